@@ -0,0 +1,155 @@
+#include "cpu_glyph_cache.hpp"
+
+#include "font_registry.hpp"
+#include "glyph_cache_file.hpp"
+
+#include <mutex>
+
+using namespace Text;
+
+static constexpr const size_t HASH_BASE = 0xCBF29CE484222325ull;
+static constexpr const size_t HASH_MULTIPLIER = 0x100000001B3ull;
+
+// Public Functions
+
+CPUGlyphCache::CPUGlyphCache(GlyphCacheFile* pDiskCache)
+		: m_pDiskCache(pDiskCache) {}
+
+const CPUGlyph& CPUGlyphCache::get_glyph(SingleScriptFont font, uint32_t glyphIndex) {
+	Key key{font.size, glyphIndex, font.face.handle, 0, StrokeType::NONE};
+
+	if (auto* pGlyph = find_glyph(key)) {
+		return *pGlyph;
+	}
+
+	// Rasterize outside of the lock, concurrent misses on the same glyph produce identical bitmaps
+	CPUGlyph glyph{};
+	auto cacheKey = make_glyph_cache_key(font, glyphIndex, 0, StrokeType::NONE, GlyphCacheEntryType::BITMAP);
+
+	if (!m_pDiskCache || !m_pDiskCache->find(cacheKey, glyph.bitmap, glyph.offset, glyph.hasColor)) {
+		if (auto fontData = FontRegistry::get_font_data(font)) {
+			auto result = fontData.rasterize_glyph(glyphIndex, glyph.offset);
+			glyph.bitmap = std::move(result.bitmap);
+			glyph.hasColor = result.hasColor;
+
+			if (m_pDiskCache && cacheKey.fontHash != 0) {
+				m_pDiskCache->insert(cacheKey, glyph.bitmap, glyph.offset, glyph.hasColor);
+			}
+		}
+	}
+
+	return insert_glyph(key, std::move(glyph));
+}
+
+const CPUGlyph& CPUGlyphCache::get_stroke(SingleScriptFont font, uint32_t glyphIndex, uint8_t thickness,
+		StrokeType type) {
+	Key key{font.size, glyphIndex, font.face.handle, thickness, type};
+
+	if (auto* pGlyph = find_glyph(key)) {
+		return *pGlyph;
+	}
+
+	CPUGlyph glyph{};
+	auto cacheKey = make_glyph_cache_key(font, glyphIndex, thickness, type, GlyphCacheEntryType::BITMAP_OUTLINE);
+
+	if (!m_pDiskCache || !m_pDiskCache->find(cacheKey, glyph.bitmap, glyph.offset, glyph.hasColor)) {
+		if (stroke_uses_distance_field(thickness, type)) {
+			if (auto pField = get_stroke_field(font, glyphIndex); !pField->empty()) {
+				glyph.bitmap = make_stroke_from_distance_field(*pField, static_cast<float>(thickness),
+						glyph.offset);
+			}
+		}
+		else if (auto fontData = FontRegistry::get_font_data(font)) {
+			glyph.bitmap = fontData.rasterize_glyph_outline(glyphIndex, thickness, type, glyph.offset).bitmap;
+		}
+
+		if (m_pDiskCache && cacheKey.fontHash != 0) {
+			m_pDiskCache->insert(cacheKey, glyph.bitmap, glyph.offset, glyph.hasColor);
+		}
+	}
+
+	return insert_glyph(key, std::move(glyph));
+}
+
+void CPUGlyphCache::clear() {
+	std::unique_lock lock(m_mutex);
+	m_glyphs.clear();
+	m_strokeFields.clear();
+	m_strokeFieldUses.clear();
+}
+
+const CPUGlyph* CPUGlyphCache::find_glyph(const Key& key) {
+	std::shared_lock lock(m_mutex);
+
+	if (auto it = m_glyphs.find(key); it != m_glyphs.end()) {
+		return &it->second;
+	}
+
+	return nullptr;
+}
+
+const CPUGlyph& CPUGlyphCache::insert_glyph(const Key& key, CPUGlyph&& glyph) {
+	std::unique_lock lock(m_mutex);
+	// If another thread inserted the glyph first, its entry is kept so that handed out references stay valid
+	return m_glyphs.try_emplace(key, std::move(glyph)).first->second;
+}
+
+std::shared_ptr<const DistanceField> CPUGlyphCache::get_stroke_field(SingleScriptFont font, uint32_t glyphIndex) {
+	Key key{font.size, glyphIndex, font.face.handle, 0, StrokeType::NONE};
+
+	{
+		// Marking the field as used reorders the use list, so even hits need the exclusive lock
+		std::unique_lock lock(m_mutex);
+
+		if (auto it = m_strokeFields.find(key); it != m_strokeFields.end()) {
+			m_strokeFieldUses.splice(m_strokeFieldUses.begin(), m_strokeFieldUses, it->second.usePosition);
+			return it->second.field;
+		}
+	}
+
+	auto pField = std::make_shared<DistanceField>();
+
+	if (auto fontData = FontRegistry::get_font_data(font)) {
+		*pField = fontData.get_glyph_distance_field(glyphIndex, STROKE_FIELD_SPREAD);
+	}
+
+	std::unique_lock lock(m_mutex);
+
+	// Another thread may have generated the same field while the lock was released
+	if (auto it = m_strokeFields.find(key); it != m_strokeFields.end()) {
+		return it->second.field;
+	}
+
+	if (m_strokeFields.size() >= MAX_STROKE_FIELDS) {
+		m_strokeFields.erase(m_strokeFieldUses.back());
+		m_strokeFieldUses.pop_back();
+	}
+
+	m_strokeFieldUses.push_front(key);
+	m_strokeFields.emplace(key, StrokeField{
+		.field = pField,
+		.usePosition = m_strokeFieldUses.begin(),
+	});
+
+	return pField;
+}
+
+// CPUGlyphCache::Key
+
+bool CPUGlyphCache::Key::operator==(const Key& o) const {
+	return size == o.size && glyphIndex == o.glyphIndex && face == o.face && strokeThickness == o.strokeThickness
+			&& strokeType == o.strokeType;
+}
+
+// CPUGlyphCache::KeyHash
+
+size_t CPUGlyphCache::KeyHash::operator()(const Key& k) const {
+	// FNV-1a
+	size_t hash = HASH_BASE;
+	hash = static_cast<size_t>(hash * HASH_MULTIPLIER) ^ static_cast<size_t>(k.size);
+	hash = static_cast<size_t>(hash * HASH_MULTIPLIER) ^ static_cast<size_t>(k.glyphIndex);
+	hash = static_cast<size_t>(hash * HASH_MULTIPLIER) ^ static_cast<size_t>(k.face);
+	hash = static_cast<size_t>(hash * HASH_MULTIPLIER) ^ static_cast<size_t>(k.strokeThickness);
+	hash = static_cast<size_t>(hash * HASH_MULTIPLIER) ^ static_cast<size_t>(k.strokeType);
+	return hash;
+}
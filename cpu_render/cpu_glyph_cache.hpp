@@ -0,0 +1,83 @@
+#pragma once
+
+#include "bitmap.hpp"
+#include "distance_field.hpp"
+#include "font.hpp"
+#include "stroke_type.hpp"
+
+#include <list>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace Text {
+
+class GlyphCacheFile;
+
+struct CPUGlyph {
+	Bitmap bitmap;
+	float offset[2];
+	bool hasColor;
+};
+
+/**
+ * Rasterized glyph and stroke bitmaps shared by CPU render calls and their worker threads. Entries are created on
+ * first use and live until `clear()`. If a `GlyphCacheFile` is given, bitmaps are read from and written to it
+ * using the same keys as the GPU text atlases.
+ *
+ * @thread_safety `get_glyph()` and `get_stroke()` are thread safe and return references that stay valid until
+ * `clear()`. `clear()` must be externally synchronized.
+ */
+class CPUGlyphCache final {
+	public:
+		explicit CPUGlyphCache(GlyphCacheFile* pDiskCache = nullptr);
+
+		CPUGlyphCache(CPUGlyphCache&&) = delete;
+		void operator=(CPUGlyphCache&&) = delete;
+
+		CPUGlyphCache(const CPUGlyphCache&) = delete;
+		void operator=(const CPUGlyphCache&) = delete;
+
+		const CPUGlyph& get_glyph(SingleScriptFont, uint32_t glyphIndex);
+		const CPUGlyph& get_stroke(SingleScriptFont, uint32_t glyphIndex, uint8_t thickness, StrokeType);
+
+		void clear();
+	private:
+		// Distance fields kept for deriving strokes, each a float per pixel, so they are evicted least recently
+		// used first
+		static constexpr const size_t MAX_STROKE_FIELDS = 256;
+
+		struct Key {
+			uint32_t size;
+			uint32_t glyphIndex;
+			FaceIndex_T face;
+			uint8_t strokeThickness;
+			StrokeType strokeType;
+
+			bool operator==(const Key&) const;
+		};
+
+		struct KeyHash {
+			size_t operator()(const Key&) const;
+		};
+
+		struct StrokeField {
+			// Shared so a field evicted by one thread stays alive while another derives a stroke from it
+			std::shared_ptr<const DistanceField> field;
+			std::list<Key>::iterator usePosition;
+		};
+
+		std::shared_mutex m_mutex;
+		std::unordered_map<Key, CPUGlyph, KeyHash> m_glyphs;
+		// Round-joined strokes of any thickness are derived from one distance field per glyph and size
+		std::unordered_map<Key, StrokeField, KeyHash> m_strokeFields;
+		// Keys of `m_strokeFields`, most recently used first
+		std::list<Key> m_strokeFieldUses;
+		GlyphCacheFile* m_pDiskCache;
+
+		const CPUGlyph* find_glyph(const Key&);
+		const CPUGlyph& insert_glyph(const Key&, CPUGlyph&&);
+		std::shared_ptr<const DistanceField> get_stroke_field(SingleScriptFont, uint32_t glyphIndex);
+};
+
+}
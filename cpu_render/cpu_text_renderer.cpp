@@ -0,0 +1,342 @@
+#include "cpu_text_renderer.hpp"
+
+#include "cpu_glyph_cache.hpp"
+#include "executor.hpp"
+#include "font_registry.hpp"
+#include "formatting_iterator.hpp"
+#include "layout_info.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace Text;
+
+static constexpr const int32_t TILE_SIZE = 128;
+// Glyphs are claimed in small chunks to balance cache hits and misses without contending on the counter
+static constexpr const size_t GLYPHS_PER_CLAIM = 16;
+
+namespace {
+
+enum class DrawCommandType : uint8_t {
+	GLYPH,
+	STROKE,
+	RECT,
+};
+
+struct DrawCommand {
+	// Resolved from the glyph cache before compositing, null for rects
+	const CPUGlyph* pGlyph;
+	SingleScriptFont font;
+	uint32_t glyphIndex;
+	// Pen position for glyphs and strokes, top left corner for rects
+	float x;
+	float y;
+	float width;
+	float height;
+	Color color;
+	uint8_t strokeThickness;
+	StrokeType strokeType;
+	DrawCommandType type;
+};
+
+struct PixelRect {
+	int32_t left;
+	int32_t top;
+	int32_t right;
+	int32_t bottom;
+};
+
+}
+
+static void build_draw_commands(const CPUTextRenderInfo& info, std::vector<DrawCommand>& commands);
+static void emit_rect(std::vector<DrawCommand>& commands, float x, float y, float width, float height,
+		const Color& color);
+
+static PixelRect get_command_bounds(const DrawCommand& cmd);
+static void composite_tile(Bitmap& target, const DrawCommand* pCommands, const std::vector<uint32_t>& tileCommands,
+		const PixelRect& tileRect);
+
+static int32_t round_to_pixel(float value);
+
+// Public Functions
+
+void Text::render_text(Bitmap& target, const CPUTextRenderInfo& info, CPUGlyphCache& glyphCache,
+		uint32_t threadCount) {
+	if (target.get_width() == 0 || target.get_height() == 0 || info.pLayout->get_line_count() == 0) {
+		return;
+	}
+
+	std::vector<DrawCommand> commands;
+	build_draw_commands(info, commands);
+
+	if (commands.empty()) {
+		return;
+	}
+
+	auto& executor = get_executor();
+
+	if (threadCount == 0) {
+		threadCount = executor.get_worker_count();
+	}
+
+	// Resolve glyph bitmaps, rasterizing cache misses in parallel
+	{
+		std::atomic_size_t nextCommand{0};
+		auto workerCount = static_cast<uint32_t>(std::min<size_t>(threadCount,
+				(commands.size() + GLYPHS_PER_CLAIM - 1) / GLYPHS_PER_CLAIM));
+
+		run_on_workers(executor, workerCount, [&](uint32_t) {
+			for (;;) {
+				auto first = nextCommand.fetch_add(GLYPHS_PER_CLAIM, std::memory_order_relaxed);
+
+				if (first >= commands.size()) {
+					break;
+				}
+
+				for (size_t i = first, l = std::min(first + GLYPHS_PER_CLAIM, commands.size()); i < l; ++i) {
+					auto& cmd = commands[i];
+
+					switch (cmd.type) {
+						case DrawCommandType::GLYPH:
+							cmd.pGlyph = &glyphCache.get_glyph(cmd.font, cmd.glyphIndex);
+							break;
+						case DrawCommandType::STROKE:
+							cmd.pGlyph = &glyphCache.get_stroke(cmd.font, cmd.glyphIndex, cmd.strokeThickness,
+									cmd.strokeType);
+							break;
+						default:
+							break;
+					}
+				}
+			}
+		});
+	}
+
+	// Bin commands into tiles, preserving draw order within each tile
+	auto targetWidth = static_cast<int32_t>(target.get_width());
+	auto targetHeight = static_cast<int32_t>(target.get_height());
+	auto tilesX = (targetWidth + TILE_SIZE - 1) / TILE_SIZE;
+	auto tilesY = (targetHeight + TILE_SIZE - 1) / TILE_SIZE;
+
+	std::vector<std::vector<uint32_t>> tiles(tilesX * tilesY);
+	std::vector<uint32_t> activeTiles;
+
+	for (uint32_t i = 0; i < commands.size(); ++i) {
+		auto bounds = get_command_bounds(commands[i]);
+		bounds.left = std::max(bounds.left, 0);
+		bounds.top = std::max(bounds.top, 0);
+		bounds.right = std::min(bounds.right, targetWidth);
+		bounds.bottom = std::min(bounds.bottom, targetHeight);
+
+		if (bounds.left >= bounds.right || bounds.top >= bounds.bottom) {
+			continue;
+		}
+
+		for (auto ty = bounds.top / TILE_SIZE; ty <= (bounds.bottom - 1) / TILE_SIZE; ++ty) {
+			for (auto tx = bounds.left / TILE_SIZE; tx <= (bounds.right - 1) / TILE_SIZE; ++tx) {
+				auto& tile = tiles[ty * tilesX + tx];
+
+				if (tile.empty()) {
+					activeTiles.push_back(ty * tilesX + tx);
+				}
+
+				tile.push_back(i);
+			}
+		}
+	}
+
+	// Composite tiles independently
+	std::atomic_size_t nextTile{0};
+
+	run_on_workers(executor, static_cast<uint32_t>(std::min<size_t>(threadCount, activeTiles.size())),
+			[&](uint32_t) {
+		for (;;) {
+			auto index = nextTile.fetch_add(1, std::memory_order_relaxed);
+
+			if (index >= activeTiles.size()) {
+				break;
+			}
+
+			auto tileIndex = activeTiles[index];
+			auto tileX = static_cast<int32_t>(tileIndex % tilesX) * TILE_SIZE;
+			auto tileY = static_cast<int32_t>(tileIndex / tilesX) * TILE_SIZE;
+			PixelRect tileRect{tileX, tileY, std::min(tileX + TILE_SIZE, targetWidth),
+					std::min(tileY + TILE_SIZE, targetHeight)};
+
+			composite_tile(target, commands.data(), tiles[tileIndex], tileRect);
+		}
+	});
+}
+
+// Static Functions
+
+// Mirrors the draw order of the GPU text renderer: per glyph, the stroke, then the glyph, then any underline or
+// strikethrough ending at it.
+static void build_draw_commands(const CPUTextRenderInfo& info, std::vector<DrawCommand>& commands) {
+	auto& layout = *info.pLayout;
+	auto* glyphPositions = layout.get_glyph_position_data();
+	uint32_t glyphIndex{};
+	uint32_t glyphPosIndex{};
+	float strikethroughStartPos{};
+	float underlineStartPos{};
+
+	commands.reserve(2 * layout.get_glyph_count());
+
+	layout.for_each_run(info.width, info.alignment, [&](auto, auto runIndex, auto lineX, auto lineY) {
+		auto font = layout.get_run_font(runIndex);
+		auto fontData = FontRegistry::get_font_data(font);
+		auto originX = info.x + lineX;
+		auto originY = info.y + lineY;
+
+		FormattingIterator iter(*info.pFormatting, layout.is_run_rtl(runIndex)
+				? layout.get_run_char_end_index(runIndex) : layout.get_run_char_start_index(runIndex));
+		underlineStartPos = strikethroughStartPos = glyphPositions[glyphPosIndex];
+
+		for (auto glyphEndIndex = layout.get_run_glyph_end_index(runIndex); glyphIndex < glyphEndIndex;
+				++glyphIndex, glyphPosIndex += 2) {
+			auto pX = glyphPositions[glyphPosIndex];
+			auto pY = glyphPositions[glyphPosIndex + 1];
+			auto glyphID = layout.get_glyph_id(glyphIndex);
+			auto event = iter.advance_to(layout.get_char_index(glyphIndex));
+			auto stroke = iter.get_stroke_state();
+
+			if (stroke.color.a > 0.f) {
+				commands.push_back({
+					.font = font,
+					.glyphIndex = glyphID,
+					.x = originX + pX,
+					.y = originY + pY,
+					.color = stroke.color,
+					.strokeThickness = stroke.thickness,
+					.strokeType = stroke.joins,
+					.type = DrawCommandType::STROKE,
+				});
+			}
+
+			commands.push_back({
+				.font = font,
+				.glyphIndex = glyphID,
+				.x = originX + pX,
+				.y = originY + pY,
+				.color = iter.get_color(),
+				.type = DrawCommandType::GLYPH,
+			});
+
+			if ((event & FormattingEvent::UNDERLINE_END) != FormattingEvent::NONE) {
+				emit_rect(commands, originX + underlineStartPos, originY + fontData.get_underline_position(),
+						pX - underlineStartPos, fontData.get_underline_thickness() + 0.5f, iter.get_prev_color());
+			}
+
+			if ((event & FormattingEvent::UNDERLINE_BEGIN) != FormattingEvent::NONE) {
+				underlineStartPos = pX;
+			}
+
+			if ((event & FormattingEvent::STRIKETHROUGH_END) != FormattingEvent::NONE) {
+				emit_rect(commands, originX + strikethroughStartPos,
+						originY + fontData.get_strikethrough_position(), pX - strikethroughStartPos,
+						fontData.get_strikethrough_thickness() + 0.5f, iter.get_prev_color());
+			}
+
+			if ((event & FormattingEvent::STRIKETHROUGH_BEGIN) != FormattingEvent::NONE) {
+				strikethroughStartPos = pX;
+			}
+		}
+
+		// Finalize last strikethrough
+		if (iter.has_strikethrough()) {
+			emit_rect(commands, originX + strikethroughStartPos, originY + fontData.get_strikethrough_position(),
+					glyphPositions[glyphPosIndex] - strikethroughStartPos,
+					fontData.get_strikethrough_thickness() + 0.5f, iter.get_color());
+		}
+
+		// Finalize last underline
+		if (iter.has_underline()) {
+			emit_rect(commands, originX + underlineStartPos, originY + fontData.get_underline_position(),
+					glyphPositions[glyphPosIndex] - underlineStartPos, fontData.get_underline_thickness() + 0.5f,
+					iter.get_color());
+		}
+
+		glyphPosIndex += 2;
+	});
+}
+
+static void emit_rect(std::vector<DrawCommand>& commands, float x, float y, float width, float height,
+		const Color& color) {
+	// Right-to-left runs produce negative widths
+	if (width < 0.f) {
+		x += width;
+		width = -width;
+	}
+
+	commands.push_back({
+		.x = x,
+		.y = y,
+		.width = width,
+		.height = height,
+		.color = color,
+		.type = DrawCommandType::RECT,
+	});
+}
+
+static PixelRect get_command_bounds(const DrawCommand& cmd) {
+	if (cmd.type == DrawCommandType::RECT) {
+		auto left = round_to_pixel(cmd.x);
+		auto top = round_to_pixel(cmd.y);
+		return {left, top, std::max(left + 1, round_to_pixel(cmd.x + cmd.width)),
+				std::max(top + 1, round_to_pixel(cmd.y + cmd.height))};
+	}
+
+	auto& glyph = *cmd.pGlyph;
+	auto left = round_to_pixel(cmd.x) + static_cast<int32_t>(glyph.offset[0]);
+	auto top = round_to_pixel(cmd.y) + static_cast<int32_t>(glyph.offset[1]);
+
+	return {left, top, left + static_cast<int32_t>(glyph.bitmap.get_width()),
+			top + static_cast<int32_t>(glyph.bitmap.get_height())};
+}
+
+static void composite_tile(Bitmap& target, const DrawCommand* pCommands, const std::vector<uint32_t>& tileCommands,
+		const PixelRect& tileRect) {
+	auto width = static_cast<uint32_t>(tileRect.right - tileRect.left);
+	auto height = static_cast<uint32_t>(tileRect.bottom - tileRect.top);
+	auto* pTarget = target.data() + tileRect.top * target.get_width() + tileRect.left;
+
+	// Composite into a tile-sized copy so that the blits clip to the tile. Edge tiles use the top left corner of
+	// the full-sized copy, pixels past it are never copied back.
+	thread_local Bitmap t_tile(TILE_SIZE, TILE_SIZE);
+
+	for (uint32_t y = 0; y < height; ++y) {
+		std::memcpy(t_tile.data() + y * TILE_SIZE, pTarget + y * target.get_width(), width * sizeof(uint32_t));
+	}
+
+	for (auto index : tileCommands) {
+		auto& cmd = pCommands[index];
+		auto bounds = get_command_bounds(cmd);
+		auto x = bounds.left - tileRect.left;
+		auto y = bounds.top - tileRect.top;
+
+		switch (cmd.type) {
+			case DrawCommandType::GLYPH:
+				t_tile.blit_alpha(cmd.pGlyph->bitmap, x, y, cmd.pGlyph->hasColor ? Color{1.f, 1.f, 1.f, 1.f}
+						: cmd.color);
+				break;
+			case DrawCommandType::STROKE:
+				t_tile.blit_alpha(cmd.pGlyph->bitmap, x, y, cmd.color);
+				break;
+			case DrawCommandType::RECT:
+				t_tile.blend_rect(x, y, static_cast<uint32_t>(bounds.right - bounds.left),
+						static_cast<uint32_t>(bounds.bottom - bounds.top), cmd.color);
+				break;
+		}
+	}
+
+	for (uint32_t y = 0; y < height; ++y) {
+		std::memcpy(pTarget + y * target.get_width(), t_tile.data() + y * TILE_SIZE, width * sizeof(uint32_t));
+	}
+}
+
+static int32_t round_to_pixel(float value) {
+	return static_cast<int32_t>(std::floor(value + 0.5f));
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "text_alignment.hpp"
+
+#include <cstdint>
+
+class Bitmap;
+
+namespace Text {
+
+class CPUGlyphCache;
+class LayoutInfo;
+
+struct FormattingRuns;
+
+struct CPUTextRenderInfo {
+	const LayoutInfo* pLayout;
+	const FormattingRuns* pFormatting;
+	// Position of the top left corner of the text area within the target bitmap
+	float x;
+	float y;
+	// Width of the text area, used for horizontal alignment
+	float width;
+	TextXAlignment alignment;
+};
+
+/**
+ * Draws the strokes, glyphs, underlines and strikethroughs of a laid out paragraph into `target`, blending over
+ * its existing contents. Glyph positions are rounded to whole pixels. Glyphs missing from `glyphCache` are
+ * rasterized in parallel, then the target is split into tiles which are composited independently.
+ *
+ * @param threadCount The maximum number of workers to use, or 0 to use the installed `Executor`'s worker count
+ * @thread_safety Thread safe, provided concurrent calls draw into different bitmaps
+ */
+void render_text(Bitmap& target, const CPUTextRenderInfo&, CPUGlyphCache& glyphCache, uint32_t threadCount = 0);
+
+}
@@ -1,8 +1,10 @@
 #pragma once
 
+#include "glyph_cache_policy.hpp"
+
 namespace CVars {
 
-inline bool useMSDF = false;
+inline Text::GlyphCachePolicy glyphCachePolicy{};
 inline bool showGlyphOutlines = false;
 inline bool showRunOutlines = false;
 inline bool showGlyphBoundaries = false;
@@ -13,12 +13,17 @@
 #include "ui_container.hpp"
 
 #include "font_registry.hpp"
+#include "glyph_cache_file.hpp"
+
+Text::LayoutService* g_layoutService{};
 
 static int g_width = 640;
 static int g_height = 480;
 
 static constexpr const float INSET = 10.f;
 
+static constexpr const char* GLYPH_CACHE_FILE_NAME = "glyph_cache.bin";
+
 static void on_key_event(GLFWwindow* window, int key, int scancode, int action, int mods);
 static void on_mouse_button_event(GLFWwindow* window, int button, int action, int mods);
 static void on_mouse_move_event(GLFWwindow* window, double xPos, double yPos);
@@ -65,8 +70,13 @@ int main() {
 
 	init_pipelines();
 
-	g_textAtlas = new TextAtlas;
-	g_msdfTextAtlas = new MSDFTextAtlas;
+	// A missing or stale cache file is not an error, it will be rewritten on exit
+	Text::GlyphCacheFile glyphCache;
+	glyphCache.open(GLYPH_CACHE_FILE_NAME);
+
+	g_textAtlas = new TextAtlas(&glyphCache);
+	g_msdfTextAtlas = new MSDFTextAtlas(&glyphCache);
+	g_layoutService = new Text::LayoutService;
 
 	auto textBox = TextBox::create();
 	textBox->set_position(INSET, 0.f);
@@ -101,9 +111,15 @@ int main() {
 		glfwPollEvents();
 	}
 
+	delete g_layoutService;
+	g_layoutService = nullptr;
 	delete g_msdfTextAtlas;
 	delete g_textAtlas;
 
+	if (!glyphCache.save()) {
+		printf("Failed to write glyph cache to %s\n", GLYPH_CACHE_FILE_NAME);
+	}
+
 	deinit_pipelines();
 
 	glfwTerminate();
@@ -167,6 +183,7 @@ static void on_resize(GLFWwindow* window, int width, int height) {
 static void render(UIContainer& container) {
 	glClearColor(1.f, 1.f, 1.f, 1.f);
 	glClear(GL_COLOR_BUFFER_BIT);
+	g_layoutService->swap_buffers();
 	container.render();
 }
 
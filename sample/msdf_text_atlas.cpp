@@ -1,6 +1,8 @@
 #include "msdf_text_atlas.hpp"
 
 #include "font_registry.hpp"
+#include "glyph_cache_file.hpp"
+#include "msdf_batch.hpp"
 
 #include <glad/glad.h>
 
@@ -14,38 +16,44 @@ static constexpr uint32_t TEXTURE_PADDING = 1u;
 
 // MSDFTextAtlas
 
+MSDFTextAtlas::MSDFTextAtlas(Text::GlyphCacheFile* pDiskCache)
+		: m_pDiskCache(pDiskCache) {}
+
 Image* MSDFTextAtlas::get_glyph_info(Text::SingleScriptFont font, uint32_t glyphIndex, float* texCoordExtentsOut,
 		float* sizeOut, float* offsetOut, bool& hasColorOut) {
 	GlyphKey key{glyphIndex, font.face.handle};
+	auto it = m_glyphs.find(key);
+
+	if (it == m_glyphs.end()) {
+		GlyphInfo info{};
+		Bitmap bitmap;
+		bool hasColor = false;
+		auto cacheKey = Text::make_glyph_cache_key(font, glyphIndex, 0, StrokeType::NONE,
+				Text::GlyphCacheEntryType::MSDF);
+
+		if (!m_pDiskCache || !m_pDiskCache->find(cacheKey, bitmap, info.offset, hasColor)) {
+			auto fontData = Text::FontRegistry::get_font_data(font);
+			bitmap = fontData.get_msdf_glyph(glyphIndex, info.offset);
+
+			if (m_pDiskCache && cacheKey.fontHash != 0) {
+				m_pDiskCache->insert(cacheKey, bitmap, info.offset, hasColor);
+			}
+		}
 
-	if (auto it = m_glyphs.find(key); it != m_glyphs.end()) {
-		std::memcpy(texCoordExtentsOut, it->second.texCoordExtents, 4 * sizeof(float));
-		std::memcpy(sizeOut, it->second.bitmapSize, 2 * sizeof(float));
-		std::memcpy(offsetOut, it->second.offset, 2 * sizeof(float));
-		hasColorOut = it->second.pPage ? it->second.pPage->hasColor : false;
-		return &it->second.pPage->image;
+		it = add_glyph(key, bitmap, info);
 	}
 
-	GlyphInfo info{};
-	auto fontData = Text::FontRegistry::get_font_data(font);
-	auto bitmap = fontData.get_msdf_glyph(glyphIndex, info.offset);
-	bool hasColor = false;
-	info.bitmapSize[0] = static_cast<float>(bitmap.get_width());
-	info.bitmapSize[1] = static_cast<float>(bitmap.get_height());
+	// Glyph entries are stored in em units, scale them to the requested size
+	auto& emSize = get_em_size(font);
 
-	if (bitmap.get_width() > 0 && bitmap.get_height() > 0) {
-		info.pPage = upload_glyph(bitmap, info.texCoordExtents, hasColor);
-	}
+	std::memcpy(texCoordExtentsOut, it->second.texCoordExtents, 4 * sizeof(float));
+	sizeOut[0] = it->second.bitmapSize[0] * emSize.x;
+	sizeOut[1] = it->second.bitmapSize[1] * emSize.y;
+	offsetOut[0] = it->second.offset[0] * emSize.x;
+	offsetOut[1] = it->second.offset[1] * emSize.y;
+	hasColorOut = it->second.pPage ? it->second.pPage->hasColor : false;
 
-	auto* result = info.pPage ? &info.pPage->image : nullptr;
-	std::memcpy(texCoordExtentsOut, info.texCoordExtents, 4 * sizeof(float));
-	std::memcpy(sizeOut, info.bitmapSize, 2 * sizeof(float));
-	std::memcpy(offsetOut, info.offset, 2 * sizeof(float));
-	hasColorOut = hasColor;
-
-	m_glyphs.emplace(std::make_pair(std::move(key), std::move(info)));
-
-	return result;
+	return it->second.pPage ? &it->second.pPage->image : nullptr;
 }
 
 Image* MSDFTextAtlas::get_stroke_info(Text::SingleScriptFont font, uint32_t glyphIndex, uint8_t thickness,
@@ -61,9 +69,20 @@ Image* MSDFTextAtlas::get_stroke_info(Text::SingleScriptFont font, uint32_t glyp
 	}
 
 	GlyphInfo info{};
-	auto fontData = Text::FontRegistry::get_font_data(font);
-	auto bitmap = fontData.get_msdf_outline_glyph(glyphIndex, thickness, type, info.offset);
+	Bitmap bitmap;
 	bool hasColor = false;
+	auto cacheKey = Text::make_glyph_cache_key(font, glyphIndex, thickness, type,
+			Text::GlyphCacheEntryType::MSDF_OUTLINE);
+
+	if (!m_pDiskCache || !m_pDiskCache->find(cacheKey, bitmap, info.offset, hasColor)) {
+		auto fontData = Text::FontRegistry::get_font_data(font);
+		bitmap = fontData.get_msdf_outline_glyph(glyphIndex, thickness, type, info.offset);
+
+		if (m_pDiskCache && cacheKey.fontHash != 0) {
+			m_pDiskCache->insert(cacheKey, bitmap, info.offset, hasColor);
+		}
+	}
+
 	info.bitmapSize[0] = static_cast<float>(bitmap.get_width());
 	info.bitmapSize[1] = static_cast<float>(bitmap.get_height());
 
@@ -82,6 +101,92 @@ Image* MSDFTextAtlas::get_stroke_info(Text::SingleScriptFont font, uint32_t glyp
 	return result;
 }
 
+void MSDFTextAtlas::warm_glyphs(const Text::MSDFBatchGlyph* pGlyphs, size_t glyphCount) {
+	std::vector<Text::MSDFBatchGlyph> missingGlyphs;
+	std::vector<GlyphKey> missingKeys;
+	std::unordered_set<GlyphKey, GlyphKeyHash> seenKeys;
+
+	for (size_t i = 0; i < glyphCount; ++i) {
+		GlyphKey key{pGlyphs[i].glyphIndex, pGlyphs[i].font.face.handle};
+
+		if (m_glyphs.find(key) != m_glyphs.end() || !seenKeys.insert(key).second) {
+			continue;
+		}
+
+		// Disk cache hits are cheap enough to resolve on this thread
+		GlyphInfo info{};
+		Bitmap bitmap;
+		bool hasColor = false;
+		auto cacheKey = Text::make_glyph_cache_key(pGlyphs[i].font, pGlyphs[i].glyphIndex, 0, StrokeType::NONE,
+				Text::GlyphCacheEntryType::MSDF);
+
+		if (m_pDiskCache && m_pDiskCache->find(cacheKey, bitmap, info.offset, hasColor)) {
+			add_glyph(key, bitmap, info);
+			continue;
+		}
+
+		missingGlyphs.emplace_back(pGlyphs[i]);
+		missingKeys.emplace_back(key);
+	}
+
+	if (missingGlyphs.empty()) {
+		return;
+	}
+
+	auto batch = Text::generate_msdf_batch(missingGlyphs.data(), missingGlyphs.size());
+
+	for (size_t i = 0; i < missingGlyphs.size(); ++i) {
+		auto& glyphResult = batch.glyphs[i];
+		auto* pSrc = batch.pixels.data() + glyphResult.dataOffset;
+
+		GlyphInfo info{};
+		info.offset[0] = glyphResult.offset[0];
+		info.offset[1] = glyphResult.offset[1];
+
+		Bitmap bitmap(glyphResult.width, glyphResult.height);
+		auto* pDst = bitmap.data();
+		auto pixelCount = static_cast<size_t>(glyphResult.width) * glyphResult.height;
+
+		for (size_t j = 0; j < pixelCount; ++j, pSrc += 3) {
+			pDst[j] = pSrc[0] | (pSrc[1] << 8) | (pSrc[2] << 16) | 0xFF000000u;
+		}
+
+		if (m_pDiskCache) {
+			auto cacheKey = Text::make_glyph_cache_key(missingGlyphs[i].font, missingGlyphs[i].glyphIndex, 0,
+					StrokeType::NONE, Text::GlyphCacheEntryType::MSDF);
+
+			if (cacheKey.fontHash != 0) {
+				m_pDiskCache->insert(cacheKey, bitmap, info.offset, false);
+			}
+		}
+
+		add_glyph(missingKeys[i], bitmap, info);
+	}
+}
+
+MSDFTextAtlas::GlyphMap::iterator MSDFTextAtlas::add_glyph(const GlyphKey& key, const Bitmap& bitmap,
+		GlyphInfo& info) {
+	info.bitmapSize[0] = static_cast<float>(bitmap.get_width()) / Text::MSDF_EM_SIZE;
+	info.bitmapSize[1] = static_cast<float>(bitmap.get_height()) / Text::MSDF_EM_SIZE;
+
+	if (bitmap.get_width() > 0 && bitmap.get_height() > 0) {
+		info.pPage = upload_glyph(bitmap, info.texCoordExtents, false);
+	}
+
+	return m_glyphs.emplace(std::make_pair(key, info)).first;
+}
+
+const MSDFTextAtlas::EmSize& MSDFTextAtlas::get_em_size(Text::SingleScriptFont font) {
+	auto key = (static_cast<uint64_t>(font.face.handle) << 32) | font.size;
+
+	if (auto it = m_emSizes.find(key); it != m_emSizes.end()) {
+		return it->second;
+	}
+
+	auto fontData = Text::FontRegistry::get_font_data(font);
+	return m_emSizes.emplace(key, EmSize{fontData.get_ppem_x(), fontData.get_ppem_y()}).first->second;
+}
+
 MSDFTextAtlas::Page* MSDFTextAtlas::upload_glyph(const Bitmap& bitmap, float* texCoordExtentsOut,
 		bool hasColor) {
 	auto padWidth = bitmap.get_width() + TEXTURE_PADDING;
@@ -171,4 +276,3 @@ size_t MSDFTextAtlas::StrokeKeyHash::operator()(const StrokeKey& k) const {
 	hash = static_cast<size_t>(hash * HASH_MULTIPLIER) ^ static_cast<size_t>(k.type);
 	return hash;
 }
-
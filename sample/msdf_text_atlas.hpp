@@ -7,17 +7,33 @@
 #include <memory>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 class Bitmap;
+
+namespace Text {
+
+class GlyphCacheFile;
+struct MSDFBatchGlyph;
+
+}
 class Font;
 
 class MSDFTextAtlas final {
 	public:
+		explicit MSDFTextAtlas(Text::GlyphCacheFile* pDiskCache = nullptr);
+
 		Image* get_glyph_info(Text::SingleScriptFont, uint32_t glyphIndex, float* texCoordExtentsOut,
 				float* sizeOut, float* offsetOut, bool& hasColorOut);
 		Image* get_stroke_info(Text::SingleScriptFont, uint32_t glyphIndex, uint8_t thickness,
 				StrokeType strokeType, float* texCoordExtentsOut, float* sizeOut, float* offsetOut,
 				bool& hasColorOut);
+
+		/**
+		 * Generates and uploads any glyphs in `pGlyphs` that are not yet in the atlas in a single parallel batch,
+		 * so that later `get_glyph_info` calls for them are cache hits.
+		 */
+		void warm_glyphs(const Text::MSDFBatchGlyph* pGlyphs, size_t glyphCount);
 	private:
 		struct Page {
 			Image image;
@@ -60,12 +76,24 @@ class MSDFTextAtlas final {
 			size_t operator()(const StrokeKey&) const;
 		};
 
+		struct EmSize {
+			float x;
+			float y;
+		};
+
+		using GlyphMap = std::unordered_map<GlyphKey, GlyphInfo, GlyphKeyHash>;
+
 		std::vector<std::unique_ptr<Page>> m_pages;
-		std::unordered_map<GlyphKey, GlyphInfo, GlyphKeyHash> m_glyphs;
+		GlyphMap m_glyphs;
 		std::unordered_map<StrokeKey, GlyphInfo, StrokeKeyHash> m_strokes;
+		// Pixels per em of each face and size in use, keyed by `face << 32 | size`
+		std::unordered_map<uint64_t, EmSize> m_emSizes;
 
 		Image m_defaultImage;
+		Text::GlyphCacheFile* m_pDiskCache;
 
+		GlyphMap::iterator add_glyph(const GlyphKey&, const Bitmap&, GlyphInfo&);
+		const EmSize& get_em_size(Text::SingleScriptFont);
 		Page* upload_glyph(const Bitmap&, float* texCoordExtentsOut, bool hasColor);
 		Page* get_or_create_target_page(uint32_t width, uint32_t height, bool hasColor);
 
@@ -1,6 +1,7 @@
 #include "text_atlas.hpp"
 
 #include "font_registry.hpp"
+#include "glyph_cache_file.hpp"
 
 #include <glad/glad.h>
 
@@ -14,7 +15,8 @@ static constexpr uint32_t TEXTURE_PADDING = 1u;
 
 // TextAtlas
 
-TextAtlas::TextAtlas() {
+TextAtlas::TextAtlas(Text::GlyphCacheFile* pDiskCache)
+		: m_pDiskCache(pDiskCache) {
 	uint8_t imageData[8 * 8 * 4];
 	std::memset(imageData, 0xFF, 8 * 8 * 4);
 	m_defaultImage = Image(GL_RGBA8, GL_RGBA, 8, 8, GL_UNSIGNED_BYTE, imageData);
@@ -33,8 +35,22 @@ Image* TextAtlas::get_glyph_info(Text::SingleScriptFont font, uint32_t glyphInde
 	}
 
 	GlyphInfo info{};
-	auto fontData = Text::FontRegistry::get_font_data(font);
-	auto [bitmap, hasColor] = fontData.rasterize_glyph(glyphIndex, info.offset);
+	Bitmap bitmap;
+	bool hasColor{};
+	auto cacheKey = Text::make_glyph_cache_key(font, glyphIndex, 0, StrokeType::NONE,
+			Text::GlyphCacheEntryType::BITMAP);
+
+	if (!m_pDiskCache || !m_pDiskCache->find(cacheKey, bitmap, info.offset, hasColor)) {
+		auto fontData = Text::FontRegistry::get_font_data(font);
+		auto result = fontData.rasterize_glyph(glyphIndex, info.offset);
+		bitmap = std::move(result.bitmap);
+		hasColor = result.hasColor;
+
+		if (m_pDiskCache && cacheKey.fontHash != 0) {
+			m_pDiskCache->insert(cacheKey, bitmap, info.offset, hasColor);
+		}
+	}
+
 	info.bitmapSize[0] = static_cast<float>(bitmap.get_width());
 	info.bitmapSize[1] = static_cast<float>(bitmap.get_height());
 
@@ -66,8 +82,19 @@ Image* TextAtlas::get_stroke_info(Text::SingleScriptFont font, uint32_t glyphInd
 	}
 
 	GlyphInfo info{};
-	auto fontData = Text::FontRegistry::get_font_data(font);
-	auto [bitmap, hasColor] = fontData.rasterize_glyph_outline(glyphIndex, thickness, type, info.offset);
+	Bitmap bitmap;
+	bool hasColor{};
+	auto cacheKey = Text::make_glyph_cache_key(font, glyphIndex, thickness, type,
+			Text::GlyphCacheEntryType::BITMAP_OUTLINE);
+
+	if (!m_pDiskCache || !m_pDiskCache->find(cacheKey, bitmap, info.offset, hasColor)) {
+		bitmap = rasterize_stroke(font, glyphIndex, thickness, type, info.offset);
+
+		if (m_pDiskCache && cacheKey.fontHash != 0) {
+			m_pDiskCache->insert(cacheKey, bitmap, info.offset, hasColor);
+		}
+	}
+
 	info.bitmapSize[0] = static_cast<float>(bitmap.get_width());
 	info.bitmapSize[1] = static_cast<float>(bitmap.get_height());
 
@@ -90,6 +117,43 @@ Image* TextAtlas::get_default_texture() {
 	return &m_defaultImage;
 }
 
+Bitmap TextAtlas::rasterize_stroke(Text::SingleScriptFont font, uint32_t glyphIndex, uint8_t thickness,
+		StrokeType type, float* offsetOut) {
+	if (!Text::stroke_uses_distance_field(thickness, type)) {
+		auto fontData = Text::FontRegistry::get_font_data(font);
+		return fontData.rasterize_glyph_outline(glyphIndex, thickness, type, offsetOut).bitmap;
+	}
+
+	GlyphKey key{font.size, glyphIndex, font.face.handle};
+	auto it = m_strokeFields.find(key);
+
+	if (it != m_strokeFields.end()) {
+		m_strokeFieldUses.splice(m_strokeFieldUses.begin(), m_strokeFieldUses, it->second.usePosition);
+	}
+	else {
+		if (m_strokeFields.size() >= MAX_STROKE_FIELDS) {
+			m_strokeFields.erase(m_strokeFieldUses.back());
+			m_strokeFieldUses.pop_back();
+		}
+
+		auto fontData = Text::FontRegistry::get_font_data(font);
+		m_strokeFieldUses.push_front(key);
+		it = m_strokeFields.emplace(std::make_pair(key, StrokeField{
+			.field = fontData.get_glyph_distance_field(glyphIndex, Text::STROKE_FIELD_SPREAD),
+			.usePosition = m_strokeFieldUses.begin(),
+		})).first;
+	}
+
+	auto& field = it->second.field;
+
+	if (field.empty()) {
+		offsetOut[0] = offsetOut[1] = 0.f;
+		return {};
+	}
+
+	return Text::make_stroke_from_distance_field(field, static_cast<float>(thickness), offsetOut);
+}
+
 TextAtlas::Page* TextAtlas::upload_glyph(const Bitmap& bitmap, float* texCoordExtentsOut, bool hasColor) {
 	auto padWidth = bitmap.get_width() + TEXTURE_PADDING;
 	auto padHeight = bitmap.get_height() + TEXTURE_PADDING;
@@ -179,4 +243,3 @@ size_t TextAtlas::StrokeKeyHash::operator()(const StrokeKey& k) const {
 	hash = static_cast<size_t>(hash * HASH_MULTIPLIER) ^ static_cast<size_t>(k.type);
 	return hash;
 }
-
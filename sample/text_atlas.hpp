@@ -1,18 +1,26 @@
 #pragma once
 
+#include "distance_field.hpp"
 #include "font.hpp"
 #include "image.hpp"
 #include "stroke_type.hpp"
 
+#include <list>
 #include <memory>
 #include <vector>
 #include <unordered_map>
 
 class Bitmap;
 
+namespace Text {
+
+class GlyphCacheFile;
+
+}
+
 class TextAtlas final {
 	public:
-		explicit TextAtlas();
+		explicit TextAtlas(Text::GlyphCacheFile* pDiskCache = nullptr);
 
 		Image* get_glyph_info(Text::SingleScriptFont, uint32_t glyphIndex, float* texCoordExtentsOut,
 				float* sizeOut, float* offsetOut, bool& hasColorOut);
@@ -22,6 +30,10 @@ class TextAtlas final {
 
 		Image* get_default_texture();
 	private:
+		// Distance fields kept for deriving strokes, each a float per pixel, so they are evicted least recently
+		// used first
+		static constexpr const size_t MAX_STROKE_FIELDS = 256;
+
 		struct Page {
 			Image image;
 			uint32_t xOffset;
@@ -64,12 +76,24 @@ class TextAtlas final {
 			size_t operator()(const StrokeKey&) const;
 		};
 
+		struct StrokeField {
+			Text::DistanceField field;
+			std::list<GlyphKey>::iterator usePosition;
+		};
+
 		std::vector<std::unique_ptr<Page>> m_pages;
 		std::unordered_map<GlyphKey, GlyphInfo, GlyphKeyHash> m_glyphs;
 		std::unordered_map<StrokeKey, GlyphInfo, StrokeKeyHash> m_strokes;
+		// Round-joined strokes of any thickness are derived from one distance field per glyph and size
+		std::unordered_map<GlyphKey, StrokeField, GlyphKeyHash> m_strokeFields;
+		// Keys of `m_strokeFields`, most recently used first
+		std::list<GlyphKey> m_strokeFieldUses;
 
 		Image m_defaultImage;
+		Text::GlyphCacheFile* m_pDiskCache;
 
+		Bitmap rasterize_stroke(Text::SingleScriptFont, uint32_t glyphIndex, uint8_t thickness, StrokeType,
+				float* offsetOut);
 		Page* upload_glyph(const Bitmap&, float* texCoordExtentsOut, bool hasColor);
 		Page* get_or_create_target_page(uint32_t width, uint32_t height, bool hasColor);
 
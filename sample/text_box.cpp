@@ -7,6 +7,7 @@
 #include "text_atlas.hpp"
 #include "msdf_text_atlas.hpp"
 #include "formatting_iterator.hpp"
+#include "msdf_batch.hpp"
 #include "ui_container.hpp"
 
 #include <GLFW/glfw3.h>
@@ -15,6 +16,13 @@ std::shared_ptr<TextBox> TextBox::create() {
 	return std::make_shared<TextBox>();
 }
 
+TextBox::~TextBox() {
+	if (g_layoutService) {
+		g_layoutService->cancel(get_layout_owner());
+		g_layoutService->remove_result(get_layout_owner());
+	}
+}
+
 bool TextBox::handle_mouse_button(UIContainer& container, int button, int action, int mods, double mouseX,
 		double mouseY) {
 	if (button != GLFW_MOUSE_BUTTON_1) {
@@ -207,6 +215,8 @@ void TextBox::release_focus(UIContainer& container) {
 }
 
 void TextBox::render(UIContainer& container) {
+	apply_async_layout();
+
 	// Outline
 	container.emit_rect(get_position()[0], get_position()[1], get_size()[0], get_size()[1], {0, 0.5f, 0, 1.f},
 			PipelineIndex::OUTLINE);
@@ -224,17 +234,14 @@ void TextBox::render(UIContainer& container) {
 			std::swap(selectionStart, selectionEnd);
 		}
 
-		m_layout.for_each_run(get_size()[0], m_textXAlignment, [&](auto lineIndex, auto runIndex,
-				auto lineX, auto lineY) {
-			if (m_layout.run_contains_char_range(runIndex, selectionStart, selectionEnd)) {
-				auto [minPos, maxPos] = m_layout.get_position_range_in_run(runIndex, selectionStart,
-						selectionEnd);
-				
-				container.emit_rect(get_position()[0] + lineX + minPos, get_position()[1] + lineY
-						- m_layout.get_line_ascent(lineIndex), maxPos - minPos,
-						m_layout.get_line_height(lineIndex), Color::from_rgb(0, 120, 215), PipelineIndex::RECT);
-			}
-		});
+		std::vector<Text::SelectionRect> selectionRects;
+		m_layout.get_selection_rects(get_size()[0], m_textXAlignment, selectionStart, selectionEnd,
+				selectionRects);
+
+		for (auto& rect : selectionRects) {
+			container.emit_rect(get_position()[0] + rect.x, get_position()[1] + rect.y, rect.width, rect.height,
+					Color::from_rgb(0, 120, 215), PipelineIndex::RECT);
+		}
 	}
 
 	// Draw main text elements
@@ -247,6 +254,7 @@ void TextBox::render(UIContainer& container) {
 			auto lineY) {
 		auto font = m_layout.get_run_font(runIndex);
 		auto fontData = Text::FontRegistry::get_font_data(font);
+		bool useMSDF = CVars::glyphCachePolicy.get_render_mode(fontData) == Text::GlyphRenderMode::MSDF;
 
 		bool runHasHighlighting = hasHighlighting && m_layout.run_contains_char_range(runIndex,
 				selectionStart, selectionEnd);
@@ -283,7 +291,7 @@ void TextBox::render(UIContainer& container) {
 				float texCoordExtents[4]{};
 				float glyphSize[2]{};
 				bool strokeHasColor{};
-				auto* pGlyphImage = CVars::useMSDF ? g_msdfTextAtlas->get_stroke_info(font, glyphID,
+				auto* pGlyphImage = useMSDF ? g_msdfTextAtlas->get_stroke_info(font, glyphID,
 								stroke.thickness, stroke.joins, texCoordExtents, glyphSize, offset,
 								strokeHasColor)
 						: g_textAtlas->get_stroke_info(font, glyphID, stroke.thickness, stroke.joins,
@@ -292,11 +300,11 @@ void TextBox::render(UIContainer& container) {
 				container.emit_rect(get_position()[0] + lineX + pX + offset[0],
 						get_position()[1] + lineY + pY + offset[1],
 						glyphSize[0], glyphSize[1], texCoordExtents, pGlyphImage, stroke.color,
-						CVars::useMSDF ? PipelineIndex::MSDF : PipelineIndex::RECT);
+						useMSDF ? PipelineIndex::MSDF : PipelineIndex::RECT);
 			}
 
 			// Main Glyph
-			auto* pGlyphImage = CVars::useMSDF ? g_msdfTextAtlas->get_glyph_info(font, glyphID, texCoordExtents,
+			auto* pGlyphImage = useMSDF ? g_msdfTextAtlas->get_glyph_info(font, glyphID, texCoordExtents,
 					glyphSize, offset, glyphHasColor)
 					: g_textAtlas->get_glyph_info(font, glyphID, texCoordExtents, glyphSize, offset,
 					glyphHasColor);
@@ -305,7 +313,7 @@ void TextBox::render(UIContainer& container) {
 			container.emit_rect(get_position()[0] + lineX + pX + offset[0],
 					get_position()[1] + lineY + pY + offset[1], glyphSize[0],
 					glyphSize[1], texCoordExtents, pGlyphImage, textColor,
-					CVars::useMSDF ? PipelineIndex::MSDF : PipelineIndex::RECT, pClip);
+					useMSDF ? PipelineIndex::MSDF : PipelineIndex::RECT, pClip);
 			
 			// Underline
 			if ((event & Text::FormattingEvent::UNDERLINE_END) != Text::FormattingEvent::NONE) {
@@ -402,19 +410,19 @@ bool TextBox::should_focused_use_rich_text() const {
 }
 
 void TextBox::cursor_move_to_next_character(bool selectionMode) {
-	set_cursor_position_internal(m_cursorCtrl.next_character(m_cursorPosition), selectionMode);
+	set_cursor_position_internal(m_cursorCtrl.next_character(m_layout, m_cursorPosition), selectionMode);
 }
 
 void TextBox::cursor_move_to_prev_character(bool selectionMode) {
-	set_cursor_position_internal(m_cursorCtrl.prev_character(m_cursorPosition), selectionMode);
+	set_cursor_position_internal(m_cursorCtrl.prev_character(m_layout, m_cursorPosition), selectionMode);
 }
 
 void TextBox::cursor_move_to_next_word(bool selectionMode) {
-	set_cursor_position_internal(m_cursorCtrl.next_word(m_cursorPosition), selectionMode);
+	set_cursor_position_internal(m_cursorCtrl.next_word(m_layout, m_cursorPosition), selectionMode);
 }
 
 void TextBox::cursor_move_to_prev_word(bool selectionMode) {
-	set_cursor_position_internal(m_cursorCtrl.prev_word(m_cursorPosition), selectionMode);
+	set_cursor_position_internal(m_cursorCtrl.prev_word(m_layout, m_cursorPosition), selectionMode);
 }
 
 void TextBox::cursor_move_to_next_line(bool selectionMode) {
@@ -594,6 +602,12 @@ void TextBox::remove_highlighted_text() {
 void TextBox::recalc_text() {
 	bool richText = is_focused() ? should_focused_use_rich_text() : m_richText;
 
+	// Edits need the layout right away for cursor movement, so a pending background layout is superseded
+	if (m_pendingLayout != 0) {
+		g_layoutService->cancel(get_layout_owner());
+		m_pendingLayout = 0;
+	}
+
 	m_visualCursorInfo = {};
 
 	if (!m_font) {
@@ -606,9 +620,11 @@ void TextBox::recalc_text() {
 			: Text::make_default_formatting_runs(m_text, m_contentText, m_font, m_textColor, strokeState);
 
 	auto& text = richText ? m_contentText : m_text;
-	m_cursorCtrl.set_text(text);
 
 	if (text.empty()) {
+		// The previous layout is kept for line queries, but must not offer cursor stops past the empty text
+		m_layout.compute_text_boundaries(text.data(), 0);
+
 		auto fontData = Text::FontRegistry::get_font_data(m_font);
 		m_visualCursorInfo.height = fontData.get_ascent() - fontData.get_descent();
 		return;
@@ -618,6 +634,74 @@ void TextBox::recalc_text() {
 			m_textWrapped ? get_size()[0] : 0.f, get_size()[1], m_textYAlignment, Text::LayoutInfoFlags::NONE);
 
 	m_visualCursorInfo = m_layout.calc_cursor_pixel_pos(get_size()[0], m_textXAlignment, m_cursorPosition);
+
+	warm_msdf_glyphs();
+}
+
+// Relayout for a change that leaves the text and formatting as they are, such as a resize. Bursts of these are
+// coalesced by the layout service, and the current layout is kept until the new one is published.
+void TextBox::recalc_text_async() {
+	bool richText = is_focused() ? should_focused_use_rich_text() : m_richText;
+	auto& text = richText ? m_contentText : m_text;
+
+	if (!g_layoutService || !m_font || text.empty()) {
+		recalc_text();
+		return;
+	}
+
+	Text::ValueRuns<Text::Font> fontRuns(m_formatting.fontRuns.get_run_count());
+	m_formatting.fontRuns.get_runs_subset(0, static_cast<int32_t>(text.size()), fontRuns);
+
+	m_pendingLayout = g_layoutService->submit(get_layout_owner(), {
+		.text = text,
+		.fontRuns = std::move(fontRuns),
+		.textAreaWidth = m_textWrapped ? get_size()[0] : 0.f,
+		.textAreaHeight = get_size()[1],
+		.textYAlignment = m_textYAlignment,
+		.flags = Text::LayoutInfoFlags::NONE,
+	});
+}
+
+void TextBox::apply_async_layout() {
+	if (m_pendingLayout == 0) {
+		return;
+	}
+
+	auto* result = g_layoutService->get_result(get_layout_owner());
+
+	if (!result || result->generation != m_pendingLayout) {
+		return;
+	}
+
+	m_layout = std::move(result->layout);
+	g_layoutService->remove_result(get_layout_owner());
+	m_pendingLayout = 0;
+
+	m_visualCursorInfo = m_layout.calc_cursor_pixel_pos(get_size()[0], m_textXAlignment, m_cursorPosition);
+
+	warm_msdf_glyphs();
+}
+
+void TextBox::warm_msdf_glyphs() {
+	std::vector<Text::MSDFBatchGlyph> glyphs;
+	glyphs.reserve(m_layout.get_glyph_count());
+	uint32_t glyphIndex{};
+
+	m_layout.for_each_run(get_size()[0], m_textXAlignment, [&](auto, auto runIndex, auto, auto) {
+		auto font = m_layout.get_run_font(runIndex);
+
+		if (CVars::glyphCachePolicy.get_render_mode(font) != Text::GlyphRenderMode::MSDF) {
+			glyphIndex = m_layout.get_run_glyph_end_index(runIndex);
+			return;
+		}
+
+		for (auto glyphEndIndex = m_layout.get_run_glyph_end_index(runIndex); glyphIndex < glyphEndIndex;
+				++glyphIndex) {
+			glyphs.push_back({font, m_layout.get_glyph_id(glyphIndex)});
+		}
+	});
+
+	g_msdfTextAtlas->warm_glyphs(glyphs.data(), glyphs.size());
 }
 
 // Setters
@@ -666,6 +750,10 @@ void TextBox::set_selectable(bool selectable) {
 
 void TextBox::set_size(float width, float height) {
 	UIObject::set_size(width, height);
-	recalc_text();
+	recalc_text_async();
+}
+
+Text::LayoutService::OwnerID TextBox::get_layout_owner() const {
+	return reinterpret_cast<uintptr_t>(this);
 }
 
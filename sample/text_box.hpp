@@ -2,6 +2,7 @@
 
 #include "cursor_controller.hpp"
 #include "layout_info.hpp"
+#include "layout_service.hpp"
 #include "formatting.hpp"
 #include "ui_object.hpp"
 
@@ -9,6 +10,8 @@ class TextBox final : public UIObject {
 	public:
 		static std::shared_ptr<TextBox> create();
 
+		~TextBox() override;
+
 		bool handle_mouse_button(UIContainer&, int button, int action, int mods, double mouseX,
 				double mouseY) override;
 		bool handle_key_press(UIContainer&, int key, int action, int mods) override;
@@ -53,6 +56,8 @@ class TextBox final : public UIObject {
 		Text::FormattingRuns m_formatting;
 		Text::VisualCursorInfo m_visualCursorInfo;
 		Text::CursorController m_cursorCtrl;
+		// Generation of the layout requested from `g_layoutService`, or 0 if none is pending
+		uint64_t m_pendingLayout{};
 
 		bool should_focused_use_rich_text() const;
 
@@ -88,5 +93,13 @@ class TextBox final : public UIObject {
 		void remove_highlighted_text();
 
 		void recalc_text();
+		void recalc_text_async();
+		void apply_async_layout();
+		void warm_msdf_glyphs();
+
+		Text::LayoutService::OwnerID get_layout_owner() const;
 };
 
+// Created and destroyed by main, null while no service is running
+extern Text::LayoutService* g_layoutService;
+
@@ -0,0 +1,189 @@
+#include "bidi_prescan.hpp"
+
+#include <unicode/uchar.h>
+#include <unicode/utf8.h>
+#include <unicode/utf16.h>
+
+#include <bit>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define RICHTEXT_PRESCAN_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	#include <arm_neon.h>
+	#define RICHTEXT_PRESCAN_NEON
+#endif
+
+using namespace Text;
+
+// Bidi classes R, AL and AN and the explicit formatting characters all lie at or above the Hebrew block
+static constexpr const char16_t FIRST_RTL_OR_EXPLICIT = 0x0590;
+
+static int32_t skip_ascii(const char* chars, int32_t index, int32_t count);
+static int32_t skip_below_rtl(const char16_t* chars, int32_t index, int32_t count);
+static bool is_rtl_or_explicit(UChar32 c);
+
+// Public Functions
+
+bool Text::is_trivially_ltr(const char* chars, int32_t count) {
+	int32_t index = 0;
+
+	while ((index = skip_ascii(chars, index, count)) < count) {
+		UChar32 c;
+		U8_NEXT(reinterpret_cast<const uint8_t*>(chars), index, count, c);
+
+		if (c < 0 || is_rtl_or_explicit(c)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool Text::is_trivially_ltr(const char16_t* chars, int32_t count) {
+	int32_t index = 0;
+
+	while ((index = skip_below_rtl(chars, index, count)) < count) {
+		UChar32 c;
+		U16_NEXT(chars, index, count, c);
+
+		if (U_IS_SURROGATE(c) || is_rtl_or_explicit(c)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void Text::find_paragraph_boundary(const char* chars, int32_t count, size_t offset, size_t& outParagraphLength,
+		size_t& outSeparatorLength) {
+	auto index = static_cast<int32_t>(offset);
+
+	while (index < count) {
+		auto separatorStart = index;
+		UChar32 c;
+		U8_NEXT(reinterpret_cast<const uint8_t*>(chars), index, count, c);
+
+		if (c >= 0 && u_charDirection(c) == U_BLOCK_SEPARATOR) {
+			if (c == 0x000D && index < count && chars[index] == '\n') {
+				++index;
+			}
+
+			outParagraphLength = static_cast<size_t>(index) - offset;
+			outSeparatorLength = static_cast<size_t>(index - separatorStart);
+			return;
+		}
+	}
+
+	outParagraphLength = static_cast<size_t>(count) - offset;
+	outSeparatorLength = 0;
+}
+
+void Text::find_paragraph_boundary(const char16_t* chars, int32_t count, size_t offset,
+		size_t& outParagraphLength, size_t& outSeparatorLength) {
+	auto index = static_cast<int32_t>(offset);
+
+	while (index < count) {
+		auto separatorStart = index;
+		UChar32 c;
+		U16_NEXT(chars, index, count, c);
+
+		if (!U_IS_SURROGATE(c) && u_charDirection(c) == U_BLOCK_SEPARATOR) {
+			if (c == 0x000D && index < count && chars[index] == u'\n') {
+				++index;
+			}
+
+			outParagraphLength = static_cast<size_t>(index) - offset;
+			outSeparatorLength = static_cast<size_t>(index - separatorStart);
+			return;
+		}
+	}
+
+	outParagraphLength = static_cast<size_t>(count) - offset;
+	outSeparatorLength = 0;
+}
+
+// Static Functions
+
+static int32_t skip_ascii(const char* chars, int32_t index, int32_t count) {
+#if defined(RICHTEXT_PRESCAN_SSE2)
+	for (; index + 16 <= count; index += 16) {
+		auto mask = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(chars + index)));
+
+		if (mask != 0) {
+			return index + std::countr_zero(static_cast<unsigned>(mask));
+		}
+	}
+#elif defined(RICHTEXT_PRESCAN_NEON)
+	for (; index + 16 <= count; index += 16) {
+		if (vmaxvq_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(chars + index))) >= 0x80) {
+			break;
+		}
+	}
+#else
+	for (; index + 8 <= count; index += 8) {
+		uint64_t word;
+		std::memcpy(&word, chars + index, sizeof(word));
+
+		if (word & 0x8080808080808080ull) {
+			break;
+		}
+	}
+#endif
+
+	while (index < count && static_cast<uint8_t>(chars[index]) < 0x80) {
+		++index;
+	}
+
+	return index;
+}
+
+static int32_t skip_below_rtl(const char16_t* chars, int32_t index, int32_t count) {
+#if defined(RICHTEXT_PRESCAN_SSE2)
+	// SSE2 has no unsigned 16-bit compare, a saturating subtract is zero exactly for the units below the limit
+	auto limit = _mm_set1_epi16(FIRST_RTL_OR_EXPLICIT - 1);
+
+	for (; index + 8 <= count; index += 8) {
+		auto units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(chars + index));
+		auto aboveLimit = _mm_subs_epu16(units, limit);
+		auto mask = _mm_movemask_epi8(_mm_cmpeq_epi16(aboveLimit, _mm_setzero_si128())) ^ 0xFFFF;
+
+		if (mask != 0) {
+			return index + std::countr_zero(static_cast<unsigned>(mask)) / 2;
+		}
+	}
+#elif defined(RICHTEXT_PRESCAN_NEON)
+	for (; index + 8 <= count; index += 8) {
+		if (vmaxvq_u16(vld1q_u16(reinterpret_cast<const uint16_t*>(chars + index))) >= FIRST_RTL_OR_EXPLICIT) {
+			break;
+		}
+	}
+#endif
+
+	while (index < count && chars[index] < FIRST_RTL_OR_EXPLICIT) {
+		++index;
+	}
+
+	return index;
+}
+
+static bool is_rtl_or_explicit(UChar32 c) {
+	switch (u_charDirection(c)) {
+		case U_RIGHT_TO_LEFT:
+		case U_RIGHT_TO_LEFT_ARABIC:
+		case U_ARABIC_NUMBER:
+		case U_LEFT_TO_RIGHT_EMBEDDING:
+		case U_LEFT_TO_RIGHT_OVERRIDE:
+		case U_RIGHT_TO_LEFT_EMBEDDING:
+		case U_RIGHT_TO_LEFT_OVERRIDE:
+		case U_POP_DIRECTIONAL_FORMAT:
+		case U_LEFT_TO_RIGHT_ISOLATE:
+		case U_RIGHT_TO_LEFT_ISOLATE:
+		case U_FIRST_STRONG_ISOLATE:
+		case U_POP_DIRECTIONAL_ISOLATE:
+			return true;
+		default:
+			return false;
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Text {
+
+/**
+ * Whether the UTF-8 text resolves to embedding level 0 everywhere under a left-to-right default paragraph
+ * direction: it contains no strong right-to-left characters (bidi classes R and AL), no Arabic numbers (AN)
+ * and no explicit embedding, override or isolate controls. Ill-formed text conservatively returns false.
+ * ASCII spans are skipped 16 bytes at a time, only non-ASCII code points need a property lookup.
+ */
+[[nodiscard]] bool is_trivially_ltr(const char* chars, int32_t count);
+
+/**
+ * UTF-16 counterpart of the above. Code units below U+0590, where the first right-to-left block starts, are
+ * skipped 8 at a time; unpaired surrogates conservatively return false.
+ */
+[[nodiscard]] bool is_trivially_ltr(const char16_t* chars, int32_t count);
+
+/**
+ * Finds the end of the paragraph starting at `offset`, splitting on bidi paragraph separators (class B) the
+ * same way as `SBAlgorithmGetParagraphBoundary`: `outParagraphLength` includes the separator, which is 2 code
+ * units for CR LF.
+ */
+void find_paragraph_boundary(const char* chars, int32_t count, size_t offset, size_t& outParagraphLength,
+		size_t& outSeparatorLength);
+void find_paragraph_boundary(const char16_t* chars, int32_t count, size_t offset, size_t& outParagraphLength,
+		size_t& outSeparatorLength);
+
+}
@@ -1,8 +1,259 @@
 #include "bitmap.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cstring>
 
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define RICHTEXT_BITMAP_AVX2
+	#define RICHTEXT_BITMAP_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define RICHTEXT_BITMAP_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	#include <arm_neon.h>
+	#define RICHTEXT_BITMAP_NEON
+#endif
+
+// The vector paths evaluate every channel with the same sequence of IEEE float operations as `Color`
+// (divide by 255, multiply, blend, multiply by 255 and truncate), so their output is bit-identical to the
+// per-pixel `get_pixel`/`set_pixel` code they replace.
+
+namespace {
+
+#if defined(RICHTEXT_BITMAP_SSE2)
+
+using Vec4 = __m128;
+
+inline Vec4 vec_load(const Color& c) {
+	return _mm_setr_ps(c.r, c.g, c.b, c.a);
+}
+
+inline Vec4 vec_one() {
+	return _mm_set1_ps(1.f);
+}
+
+inline Vec4 vec_add(Vec4 a, Vec4 b) {
+	return _mm_add_ps(a, b);
+}
+
+inline Vec4 vec_sub(Vec4 a, Vec4 b) {
+	return _mm_sub_ps(a, b);
+}
+
+inline Vec4 vec_mul(Vec4 a, Vec4 b) {
+	return _mm_mul_ps(a, b);
+}
+
+inline Vec4 vec_div(Vec4 a, Vec4 b) {
+	return _mm_div_ps(a, b);
+}
+
+inline Vec4 vec_broadcast_alpha(Vec4 v) {
+	return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+inline Vec4 vec_set_alpha_one(Vec4 v) {
+	auto hi = _mm_shuffle_ps(v, vec_one(), _MM_SHUFFLE(0, 0, 2, 2));
+	return _mm_shuffle_ps(v, hi, _MM_SHUFFLE(2, 0, 1, 0));
+}
+
+inline Vec4 unpack_pixel(uint32_t pixel) {
+	auto zero = _mm_setzero_si128();
+	auto words = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(pixel)), zero), zero);
+	return _mm_div_ps(_mm_cvtepi32_ps(words), _mm_set1_ps(255.f));
+}
+
+inline uint32_t pack_pixel(Vec4 c) {
+	auto words = _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(c, _mm_set1_ps(255.f))), _mm_set1_epi32(0xFF));
+	words = _mm_packs_epi32(words, words);
+	return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(words, words)));
+}
+
+#elif defined(RICHTEXT_BITMAP_NEON)
+
+using Vec4 = float32x4_t;
+
+inline Vec4 vec_load(const Color& c) {
+	const float values[4] = {c.r, c.g, c.b, c.a};
+	return vld1q_f32(values);
+}
+
+inline Vec4 vec_one() {
+	return vdupq_n_f32(1.f);
+}
+
+inline Vec4 vec_add(Vec4 a, Vec4 b) {
+	return vaddq_f32(a, b);
+}
+
+inline Vec4 vec_sub(Vec4 a, Vec4 b) {
+	return vsubq_f32(a, b);
+}
+
+inline Vec4 vec_mul(Vec4 a, Vec4 b) {
+	return vmulq_f32(a, b);
+}
+
+inline Vec4 vec_div(Vec4 a, Vec4 b) {
+	return vdivq_f32(a, b);
+}
+
+inline Vec4 vec_broadcast_alpha(Vec4 v) {
+	return vdupq_laneq_f32(v, 3);
+}
+
+inline Vec4 vec_set_alpha_one(Vec4 v) {
+	return vsetq_lane_f32(1.f, v, 3);
+}
+
+inline Vec4 unpack_pixel(uint32_t pixel) {
+	auto words = vmovl_u16(vget_low_u16(vmovl_u8(vcreate_u8(pixel))));
+	return vdivq_f32(vcvtq_f32_u32(words), vdupq_n_f32(255.f));
+}
+
+inline uint32_t pack_pixel(Vec4 c) {
+	auto words = vandq_u32(vcvtq_u32_f32(vmulq_f32(c, vdupq_n_f32(255.f))), vdupq_n_u32(0xFF));
+	auto halves = vmovn_u32(words);
+	auto bytes = vmovn_u16(vcombine_u16(halves, halves));
+	return vget_lane_u32(vreinterpret_u32_u8(bytes), 0);
+}
+
+#else
+
+using Vec4 = Color;
+
+inline Vec4 vec_load(const Color& c) {
+	return c;
+}
+
+inline Vec4 vec_one() {
+	return {1.f, 1.f, 1.f, 1.f};
+}
+
+inline Vec4 vec_add(const Vec4& a, const Vec4& b) {
+	return a + b;
+}
+
+inline Vec4 vec_sub(const Vec4& a, const Vec4& b) {
+	return a - b;
+}
+
+inline Vec4 vec_mul(const Vec4& a, const Vec4& b) {
+	return a * b;
+}
+
+inline Vec4 vec_div(const Vec4& a, const Vec4& b) {
+	return {a.r / b.r, a.g / b.g, a.b / b.b, a.a / b.a};
+}
+
+inline Vec4 vec_broadcast_alpha(const Vec4& v) {
+	return {v.a, v.a, v.a, v.a};
+}
+
+inline Vec4 vec_set_alpha_one(const Vec4& v) {
+	return {v.r, v.g, v.b, 1.f};
+}
+
+inline Vec4 unpack_pixel(uint32_t pixel) {
+	return Color::from_argb_uint(pixel);
+}
+
+inline uint32_t pack_pixel(const Vec4& c) {
+	return Color::to_argb(c);
+}
+
+#endif
+
+constexpr std::array<uint8_t, 256> make_a8_alpha_table() {
+	std::array<uint8_t, 256> result{};
+
+	for (uint32_t i = 0; i < 256; ++i) {
+		auto alpha = static_cast<float>(i) / 255.f;
+		result[i] = static_cast<uint8_t>(static_cast<uint32_t>(alpha * 255.f) & 0xFFu);
+	}
+
+	return result;
+}
+
+// Converting coverage to float and back does not round-trip for every value, so the converted alpha is tabled
+constexpr auto A8_ALPHA_TABLE = make_a8_alpha_table();
+
+inline uint32_t a8_to_argb(uint8_t coverage) {
+	return (static_cast<uint32_t>(A8_ALPHA_TABLE[coverage]) << 24) | 0xFFFFFFu;
+}
+
+inline uint32_t blend_pixel(uint32_t src, uint32_t dst, const Vec4& tint) {
+	auto srcColor = vec_mul(unpack_pixel(src), tint);
+
+	if ((dst >> 24) == 0) {
+		return pack_pixel(srcColor);
+	}
+
+	auto srcAlpha = vec_broadcast_alpha(srcColor);
+	return pack_pixel(vec_add(vec_mul(srcColor, srcAlpha),
+			vec_mul(unpack_pixel(dst), vec_sub(vec_one(), srcAlpha))));
+}
+
+inline uint32_t unpremultiply_bgra(const uint8_t* src) {
+	uint32_t rgba = src[2] | (src[1] << 8) | (src[0] << 16) | (static_cast<uint32_t>(src[3]) << 24);
+	auto color = unpack_pixel(rgba);
+	return pack_pixel(vec_div(color, vec_set_alpha_one(vec_broadcast_alpha(color))));
+}
+
+#if defined(RICHTEXT_BITMAP_AVX2)
+
+inline __m256 unpack_pixels2(const uint32_t* pPixels) {
+	auto words = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pPixels)));
+	return _mm256_div_ps(_mm256_cvtepi32_ps(words), _mm256_set1_ps(255.f));
+}
+
+inline void pack_pixels2(__m256 c, uint32_t* pPixels) {
+	auto words = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_mul_ps(c, _mm256_set1_ps(255.f))),
+			_mm256_set1_epi32(0xFF));
+	auto halves = _mm_packs_epi32(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(pPixels), _mm_packus_epi16(halves, halves));
+}
+
+#endif
+
+/**
+ * Blends `count` pixels produced by `getSrc(i)` over `pDst`.
+ */
+template <typename Functor>
+void blend_row(uint32_t* pDst, uint32_t count, const Color& tint, Functor&& getSrc) {
+	uint32_t i = 0;
+
+#if defined(RICHTEXT_BITMAP_AVX2)
+	auto tint2 = _mm256_setr_ps(tint.r, tint.g, tint.b, tint.a, tint.r, tint.g, tint.b, tint.a);
+	auto one = _mm256_set1_ps(1.f);
+	auto zero = _mm256_setzero_ps();
+
+	for (; i + 2 <= count; i += 2) {
+		const uint32_t srcPixels[2] = {getSrc(i), getSrc(i + 1)};
+
+		auto srcColor = _mm256_mul_ps(unpack_pixels2(srcPixels), tint2);
+		auto dstColor = unpack_pixels2(pDst + i);
+		auto srcAlpha = _mm256_permute_ps(srcColor, _MM_SHUFFLE(3, 3, 3, 3));
+		auto blended = _mm256_add_ps(_mm256_mul_ps(srcColor, srcAlpha),
+				_mm256_mul_ps(dstColor, _mm256_sub_ps(one, srcAlpha)));
+		auto dstHasAlpha = _mm256_cmp_ps(_mm256_permute_ps(dstColor, _MM_SHUFFLE(3, 3, 3, 3)), zero,
+				_CMP_GT_OQ);
+
+		pack_pixels2(_mm256_blendv_ps(srcColor, blended, dstHasAlpha), pDst + i);
+	}
+#endif
+
+	auto tint4 = vec_load(tint);
+
+	for (; i < count; ++i) {
+		pDst[i] = blend_pixel(getSrc(i), pDst[i], tint4);
+	}
+}
+
+}
+
 Bitmap::Bitmap(uint32_t width, uint32_t height)
 		: m_data(std::make_unique<uint32_t[]>(width * height))
 		, m_width(width)
@@ -35,6 +286,22 @@ void Bitmap::fill_rect(int32_t x, int32_t y, uint32_t width, uint32_t height, co
 	}
 }
 
+void Bitmap::blend_rect(int32_t x, int32_t y, uint32_t width, uint32_t height, const Color& color) {
+	auto startX = std::max(0, x);
+	auto startY = std::max(0, y);
+	auto endX = std::min(x + static_cast<int32_t>(width), static_cast<int32_t>(m_width));
+	auto endY = std::min(y + static_cast<int32_t>(height), static_cast<int32_t>(m_height));
+
+	if (startX >= endX) {
+		return;
+	}
+
+	// An opaque white source scaled by `color` is exactly `color`
+	for (int32_t iy = startY; iy < endY; ++iy) {
+		blend_row(m_data.get() + iy * m_width + startX, endX - startX, color, [](uint32_t) { return ~0u; });
+	}
+}
+
 void Bitmap::blit(const Bitmap& src, int32_t x, int32_t y) {
 	x = std::max(0, x);
 	y = std::max(0, y);
@@ -56,18 +323,32 @@ void Bitmap::blit_alpha(const Bitmap& src, int32_t x, int32_t y, const Color& co
 	auto endX = std::min(x + static_cast<int32_t>(src.get_width()), static_cast<int32_t>(m_width));
 	auto endY = std::min(y + static_cast<int32_t>(src.get_height()), static_cast<int32_t>(m_height));
 
+	if (startX >= endX) {
+		return;
+	}
+
+	for (int32_t iy = startY; iy < endY; ++iy) {
+		auto* pSrc = src.data() + (iy - y) * src.get_width() + (startX - x);
+		blend_row(m_data.get() + iy * m_width + startX, endX - startX, color,
+				[pSrc](uint32_t i) { return pSrc[i]; });
+	}
+}
+
+void Bitmap::blit_alpha_a8(const uint8_t* src, uint32_t width, uint32_t height, uint32_t stride, int32_t x,
+		int32_t y, const Color& color) {
+	auto startX = std::max(0, x);
+	auto startY = std::max(0, y);
+	auto endX = std::min(x + static_cast<int32_t>(width), static_cast<int32_t>(m_width));
+	auto endY = std::min(y + static_cast<int32_t>(height), static_cast<int32_t>(m_height));
+
+	if (startX >= endX) {
+		return;
+	}
+
 	for (int32_t iy = startY; iy < endY; ++iy) {
-		for (int32_t ix = startX; ix < endX; ++ix) {
-			auto srcColor = src.get_pixel(ix - x, iy - y) * color;
-			auto dstColor = get_pixel(ix, iy);
-
-			if (dstColor.a > 0.f) {
-				set_pixel(ix, iy, Color::blend(srcColor, dstColor));
-			}
-			else {
-				set_pixel(ix, iy, srcColor);
-			}
-		}
+		auto* pSrc = src + (iy - y) * stride + (startX - x);
+		blend_row(m_data.get() + iy * m_width + startX, endX - startX, color,
+				[pSrc](uint32_t i) { return a8_to_argb(pSrc[i]); });
 	}
 }
 
@@ -95,3 +376,14 @@ const uint32_t* Bitmap::data() const {
 	return m_data.get();
 }
 
+void Bitmap::convert_a8_to_argb(const uint8_t* src, uint32_t* dst, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		dst[i] = a8_to_argb(src[i]);
+	}
+}
+
+void Bitmap::convert_bgra_to_argb(const uint8_t* src, uint32_t* dst, size_t count) {
+	for (size_t i = 0; i < count; ++i, src += 4) {
+		dst[i] = unpremultiply_bgra(src);
+	}
+}
@@ -2,6 +2,8 @@
 
 #include "color.hpp"
 
+#include <cstddef>
+
 #include <memory>
 
 class Bitmap final {
@@ -19,9 +21,19 @@ class Bitmap final {
 		void clear(const Color&);
 
 		void fill_rect(int32_t x, int32_t y, uint32_t width, uint32_t height, const Color&);
+		/**
+		 * Blends a solid rectangle over the bitmap, clipped to its bounds.
+		 */
+		void blend_rect(int32_t x, int32_t y, uint32_t width, uint32_t height, const Color&);
 
 		void blit(const Bitmap& src, int32_t x, int32_t y);
 		void blit_alpha(const Bitmap& src, int32_t x, int32_t y, const Color& = {1.f, 1.f, 1.f, 1.f});
+		/**
+		 * Blits an 8-bit coverage mask with a row pitch of `stride` bytes, tinted by `color`. The result is
+		 * identical to converting the mask with `convert_a8_to_argb` and calling `blit_alpha`.
+		 */
+		void blit_alpha_a8(const uint8_t* src, uint32_t width, uint32_t height, uint32_t stride, int32_t x,
+				int32_t y, const Color& = {1.f, 1.f, 1.f, 1.f});
 
 		void set_pixel(uint32_t x, uint32_t y, const Color&);
 
@@ -32,6 +44,15 @@ class Bitmap final {
 
 		uint32_t* data();
 		const uint32_t* data() const;
+
+		/**
+		 * Converts 8-bit coverage to white ARGB pixels, matching `set_pixel(x, y, {1, 1, 1, a / 255})`.
+		 */
+		static void convert_a8_to_argb(const uint8_t* src, uint32_t* dst, size_t count);
+		/**
+		 * Converts premultiplied BGRA pixels, as produced by FreeType for color glyphs, to straight-alpha ARGB.
+		 */
+		static void convert_bgra_to_argb(const uint8_t* src, uint32_t* dst, size_t count);
 	private:
 		std::unique_ptr<uint32_t[]> m_data{};
 		uint32_t m_width{};
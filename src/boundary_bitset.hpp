@@ -0,0 +1,91 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace Text {
+
+/**
+ * A set of code unit indices in the range [0, textLength], one bit per index. Used to store grapheme cluster and
+ * word boundaries so that cursor movement is a bit scan rather than a break iterator walk.
+ */
+class BoundaryBitset {
+	public:
+		static constexpr const uint32_t INVALID_INDEX = ~0u;
+
+		void clear() {
+			m_words.clear();
+			m_textLength = 0;
+		}
+
+		/**
+		 * Clears the set and sizes it to hold indices [0, textLength].
+		 */
+		void reset(uint32_t textLength) {
+			m_words.assign(textLength / 64 + 1, 0);
+			m_textLength = textLength;
+		}
+
+		void set(uint32_t index) {
+			m_words[index / 64] |= 1ull << (index % 64);
+		}
+
+		bool test(uint32_t index) const {
+			return index / 64 < m_words.size() && (m_words[index / 64] & (1ull << (index % 64)));
+		}
+
+		/**
+		 * Returns the smallest set index greater than `index`, or `INVALID_INDEX` if there is none.
+		 */
+		uint32_t next(uint32_t index) const {
+			if (index >= m_textLength) {
+				return INVALID_INDEX;
+			}
+
+			auto wordIndex = (index + 1) / 64;
+			auto word = m_words[wordIndex] & (~0ull << ((index + 1) % 64));
+
+			while (word == 0) {
+				if (++wordIndex == m_words.size()) {
+					return INVALID_INDEX;
+				}
+
+				word = m_words[wordIndex];
+			}
+
+			return static_cast<uint32_t>(wordIndex * 64 + std::countr_zero(word));
+		}
+
+		/**
+		 * Returns the largest set index less than `index`, or `INVALID_INDEX` if there is none.
+		 */
+		uint32_t prev(uint32_t index) const {
+			if (index == 0 || m_words.empty()) {
+				return INVALID_INDEX;
+			}
+
+			index = index > m_textLength ? m_textLength : index - 1;
+			auto wordIndex = index / 64;
+			auto word = m_words[wordIndex] & (~0ull >> (63 - index % 64));
+
+			while (word == 0) {
+				if (wordIndex-- == 0) {
+					return INVALID_INDEX;
+				}
+
+				word = m_words[wordIndex];
+			}
+
+			return static_cast<uint32_t>(wordIndex * 64 + 63 - std::countl_zero(word));
+		}
+
+		uint32_t get_text_length() const {
+			return m_textLength;
+		}
+	private:
+		std::vector<uint64_t> m_words;
+		uint32_t m_textLength{};
+};
+
+}
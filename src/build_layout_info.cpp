@@ -0,0 +1,1310 @@
+#include "layout_info.hpp"
+#include "layout_job.hpp"
+#include "shaped_text.hpp"
+
+#include "bidi_prescan.hpp"
+#include "binary_search.hpp"
+#include "value_run_utils.hpp"
+#include "font_registry.hpp"
+#include "script_run_iterator.hpp"
+#include "simple_shaping.hpp"
+
+#include <unicode/ubidi.h>
+#include <unicode/brkiter.h>
+#include <unicode/utf8.h>
+#include <unicode/utf16.h>
+#include <usc_impl.h>
+
+extern "C" {
+#include <SheenBidi.h>
+}
+
+#include <hb.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+using namespace Text;
+
+// The layout pipeline is written once, parameterized on the code unit type and the bidi backend. Decoding, break
+// iterator setup and HarfBuzz buffer filling are selected at compile time through `Encoding`, and paragraph
+// segmentation, level resolution, script itemization and visual reordering through the backend.
+
+namespace {
+
+template <typename CharT>
+struct Encoding;
+
+template <>
+struct Encoding<char> {
+	static constexpr const SBStringEncoding SHEEN_ENCODING = SBStringEncodingUTF8;
+
+	static UChar32 get(const char* chars, int32_t index, int32_t count) {
+		UChar32 c;
+		U8_GET(reinterpret_cast<const uint8_t*>(chars), 0, index, count, c);
+		return c;
+	}
+
+	static void forward(const char* chars, int32_t& index, int32_t count) {
+		U8_FWD_1(chars, index, count);
+	}
+
+	static void open_utext(UText* pText, const char* chars, int32_t count, UErrorCode& err) {
+		utext_openUTF8(pText, chars, count, &err);
+	}
+
+	static void add_to_buffer(hb_buffer_t* pBuffer, const char* chars, int32_t textLength, uint32_t itemOffset,
+			int32_t itemLength) {
+		hb_buffer_add_utf8(pBuffer, chars, textLength, itemOffset, itemLength);
+	}
+};
+
+template <>
+struct Encoding<char16_t> {
+	static constexpr const SBStringEncoding SHEEN_ENCODING = SBStringEncodingUTF16;
+
+	static UChar32 get(const char16_t* chars, int32_t index, int32_t count) {
+		UChar32 c;
+		U16_GET(chars, 0, index, count, c);
+		return c;
+	}
+
+	static void forward(const char16_t* chars, int32_t& index, int32_t count) {
+		U16_FWD_1(chars, index, count);
+	}
+
+	static void open_utext(UText* pText, const char16_t* chars, int32_t count, UErrorCode& err) {
+		utext_openUChars(pText, chars, count, &err);
+	}
+
+	static void add_to_buffer(hb_buffer_t* pBuffer, const char16_t* chars, int32_t textLength,
+			uint32_t itemOffset, int32_t itemLength) {
+		hb_buffer_add_utf16(pBuffer, reinterpret_cast<const uint16_t*>(chars), textLength, itemOffset,
+				itemLength);
+	}
+};
+
+/**
+ * ICU ubidi and usc_impl backend, UTF-16 only. Paragraphs are split on CR, LF, CR LF, LSEP and PSEP, and the text
+ * always ends with a paragraph, which is empty if the text ends with a separator.
+ */
+class ICUBidiBackend {
+	public:
+		explicit ICUBidiBackend(const char16_t* chars, int32_t count, LayoutInfoFlags flags)
+				: m_chars(chars)
+				, m_count(count)
+				, m_pParaBiDi(ubidi_open())
+				, m_pLineBiDi(ubidi_open()) {
+			m_paragraphLevel = ((flags & LayoutInfoFlags::RIGHT_TO_LEFT) == LayoutInfoFlags::NONE)
+					? UBIDI_DEFAULT_LTR : UBIDI_DEFAULT_RTL;
+
+			if ((flags & LayoutInfoFlags::OVERRIDE_DIRECTIONALITY) != LayoutInfoFlags::NONE) {
+				m_paragraphLevel |= UBIDI_LEVEL_OVERRIDE;
+			}
+		}
+
+		~ICUBidiBackend() {
+			ubidi_close(m_pParaBiDi);
+			ubidi_close(m_pLineBiDi);
+		}
+
+		ICUBidiBackend(ICUBidiBackend&&) = delete;
+		void operator=(ICUBidiBackend&&) = delete;
+
+		bool next_paragraph(int32_t offset, int32_t& outContentLength, int32_t& outSeparatorLength,
+				int32_t& outParagraphLength) {
+			if (m_done) {
+				return false;
+			}
+
+			for (auto index = offset; index < m_count;) {
+				auto separatorStart = index;
+				UChar32 c;
+				U16_NEXT(m_chars, index, m_count, c);
+
+				if (c == CH_LF || c == CH_CR || c == CH_LSEP || c == CH_PSEP) {
+					if (c == CH_CR && index < m_count && m_chars[index] == CH_LF) {
+						++index;
+					}
+
+					outContentLength = separatorStart - offset;
+					outSeparatorLength = index - separatorStart;
+					outParagraphLength = index - offset;
+					return true;
+				}
+			}
+
+			m_done = true;
+			outContentLength = outParagraphLength = m_count - offset;
+			outSeparatorLength = 0;
+			return true;
+		}
+
+		ValueRuns<uint8_t> begin_paragraph(int32_t offset, int32_t contentLength, int32_t) {
+			UErrorCode err{};
+			m_paragraphOffset = offset;
+			ubidi_setPara(m_pParaBiDi, m_chars + offset, contentLength, m_paragraphLevel, nullptr, &err);
+			auto levelRunCount = ubidi_countRuns(m_pParaBiDi, &err);
+
+			ValueRuns<uint8_t> levelRuns(levelRunCount);
+
+			int32_t logicalStart{};
+			int32_t limit;
+			UBiDiLevel level;
+
+			for (int32_t run = 0; run < levelRunCount; ++run) {
+				ubidi_getLogicalRun(m_pParaBiDi, logicalStart, &limit, &level);
+				levelRuns.add(limit, level);
+				logicalStart = limit;
+			}
+
+			return levelRuns;
+		}
+
+		void end_paragraph() {}
+
+		static ValueRuns<UScriptCode> compute_scripts(const char16_t* chars, int32_t count) {
+			UErrorCode err{};
+			auto* sr = uscript_openRun(chars, count, &err);
+
+			ValueRuns<UScriptCode> scriptRuns;
+
+			int32_t limit;
+			UScriptCode script;
+
+			while (uscript_nextRun(sr, nullptr, &limit, &script)) {
+				scriptRuns.add(limit, script);
+			}
+
+			uscript_closeRun(sr);
+
+			return scriptRuns;
+		}
+
+		template <typename Functor>
+		void for_each_visual_run(int32_t lineStart, int32_t lineEnd, Functor&& func) {
+			UErrorCode err{};
+			ubidi_setLine(m_pParaBiDi, lineStart - m_paragraphOffset, lineEnd - m_paragraphOffset, m_pLineBiDi,
+					&err);
+			auto runCount = ubidi_countRuns(m_pLineBiDi, &err);
+
+			for (int32_t i = 0; i < runCount; ++i) {
+				int32_t logicalStart, runLength;
+				auto runDir = ubidi_getVisualRun(m_pLineBiDi, i, &logicalStart, &runLength);
+				func(lineStart + logicalStart, runLength, runDir != UBIDI_LTR);
+			}
+		}
+	private:
+		static constexpr const UChar32 CH_LF = 0x000A;
+		static constexpr const UChar32 CH_CR = 0x000D;
+		static constexpr const UChar32 CH_LSEP = 0x2028;
+		static constexpr const UChar32 CH_PSEP = 0x2029;
+
+		const char16_t* m_chars;
+		int32_t m_count;
+		UBiDi* m_pParaBiDi;
+		UBiDi* m_pLineBiDi;
+		UBiDiLevel m_paragraphLevel;
+		int32_t m_paragraphOffset{};
+		bool m_done{};
+};
+
+template <typename Functor>
+void for_each_sheen_visual_run(SBParagraphRef paragraph, int32_t lineStart, int32_t lineEnd, Functor&& func) {
+	// Without a paragraph the whole line is a single LTR run, visual order is logical order
+	if (!paragraph) {
+		func(lineStart, lineEnd - lineStart, false);
+		return;
+	}
+
+	SBLineRef sbLine = SBParagraphCreateLine(paragraph, lineStart, lineEnd - lineStart);
+	auto runCount = SBLineGetRunCount(sbLine);
+	auto* sbRuns = SBLineGetRunsPtr(sbLine);
+
+	for (SBUInteger i = 0; i < runCount; ++i) {
+		func(static_cast<int32_t>(sbRuns[i].offset), static_cast<int32_t>(sbRuns[i].length),
+				(sbRuns[i].level & 1) != 0);
+	}
+
+	SBLineRelease(sbLine);
+}
+
+/**
+ * SheenBidi and ScriptRunIterator backend, for UTF-8 or UTF-16. Paragraphs are split on bidi paragraph
+ * separators, and a separator ending the text is kept in the last paragraph. Unidirectional LTR paragraphs skip
+ * SheenBidi entirely, resolving to a single level 0 run; the SheenBidi algorithm is only created once a paragraph
+ * needs it.
+ */
+template <typename CharT>
+class SheenBidiBackend {
+	public:
+		explicit SheenBidiBackend(const CharT* chars, int32_t count, LayoutInfoFlags flags)
+				: m_chars(chars)
+				, m_count(count)
+				, m_rightToLeft((flags & LayoutInfoFlags::RIGHT_TO_LEFT) != LayoutInfoFlags::NONE) {
+			m_baseLevel = m_rightToLeft ? SBLevelDefaultRTL : SBLevelDefaultLTR;
+		}
+
+		~SheenBidiBackend() {
+			if (m_algorithm) {
+				SBAlgorithmRelease(m_algorithm);
+			}
+		}
+
+		SheenBidiBackend(SheenBidiBackend&&) = delete;
+		void operator=(SheenBidiBackend&&) = delete;
+
+		bool next_paragraph(int32_t offset, int32_t& outContentLength, int32_t& outSeparatorLength,
+				int32_t& outParagraphLength) {
+			if (offset >= m_count) {
+				return false;
+			}
+
+			size_t paragraphLength, separatorLength;
+			find_paragraph_boundary(m_chars, m_count, offset, paragraphLength, separatorLength);
+
+			bool isLastParagraph = offset + paragraphLength == m_count;
+
+			if (isLastParagraph) {
+				outContentLength = paragraphLength - separatorLength > 0 ? paragraphLength : 0;
+				outSeparatorLength = 0;
+			}
+			else {
+				outContentLength = paragraphLength - separatorLength;
+				outSeparatorLength = separatorLength;
+			}
+
+			outParagraphLength = paragraphLength;
+			return true;
+		}
+
+		ValueRuns<uint8_t> begin_paragraph(int32_t offset, int32_t contentLength, int32_t paragraphLength) {
+			// A paragraph without RTL characters, Arabic numbers or explicit directional controls resolves to a
+			// single LTR level, so no SheenBidi objects are needed
+			if (!m_rightToLeft && is_trivially_ltr(m_chars + offset, paragraphLength)) {
+				return ValueRuns<uint8_t>(uint8_t{0}, contentLength);
+			}
+
+			if (!m_algorithm) {
+				SBCodepointSequence codepointSequence{Encoding<CharT>::SHEEN_ENCODING, (void*)m_chars,
+						(size_t)m_count};
+				m_algorithm = SBAlgorithmCreate(&codepointSequence);
+			}
+
+			m_paragraph = SBAlgorithmCreateParagraph(m_algorithm, offset, paragraphLength, m_baseLevel);
+
+			ValueRuns<uint8_t> levelRuns;
+			auto* levels = SBParagraphGetLevelsPtr(m_paragraph);
+			SBLevel lastLevel = levels[0];
+
+			for (int32_t i = 1; i < contentLength; ++i) {
+				if (levels[i] != lastLevel) {
+					levelRuns.add(i, lastLevel);
+					lastLevel = levels[i];
+				}
+			}
+
+			levelRuns.add(contentLength, lastLevel);
+
+			return levelRuns;
+		}
+
+		void end_paragraph() {
+			if (m_paragraph) {
+				SBParagraphRelease(m_paragraph);
+				m_paragraph = nullptr;
+			}
+		}
+
+		static ValueRuns<UScriptCode> compute_scripts(const CharT* chars, int32_t count) {
+			ScriptRunIterator runIter(chars, count);
+			ValueRuns<UScriptCode> scriptRuns;
+			int32_t start;
+			int32_t limit;
+			UScriptCode script;
+
+			while (runIter.next(start, limit, script)) {
+				scriptRuns.add(limit, script);
+			}
+
+			return scriptRuns;
+		}
+
+		template <typename Functor>
+		void for_each_visual_run(int32_t lineStart, int32_t lineEnd, Functor&& func) {
+			for_each_sheen_visual_run(m_paragraph, lineStart, lineEnd, func);
+		}
+
+		/**
+		 * Returns a new reference to the current paragraph, or null if it resolved without SheenBidi.
+		 */
+		SBParagraphRef retain_paragraph() const {
+			return m_paragraph ? SBParagraphRetain(m_paragraph) : nullptr;
+		}
+	private:
+		const CharT* m_chars;
+		int32_t m_count;
+		SBAlgorithmRef m_algorithm{};
+		SBParagraphRef m_paragraph{};
+		SBLevel m_baseLevel;
+		bool m_rightToLeft;
+};
+
+/**
+ * Replays visual reordering for a paragraph retained by `ShapedText`.
+ */
+class RetainedBidi {
+	public:
+		explicit RetainedBidi(SBParagraphRef paragraph)
+				: m_paragraph(paragraph) {}
+
+		template <typename Functor>
+		void for_each_visual_run(int32_t lineStart, int32_t lineEnd, Functor&& func) {
+			for_each_sheen_visual_run(m_paragraph, lineStart, lineEnd, func);
+		}
+	private:
+		SBParagraphRef m_paragraph;
+};
+
+using LogicalRun = ShapedText::Run;
+
+struct LayoutBuildState {
+	explicit LayoutBuildState()
+			: pBuffer(hb_buffer_create()) {
+		UErrorCode err{U_ZERO_ERROR};
+		pLineBreakIterator = icu::BreakIterator::createLineInstance(icu::Locale::getDefault(), err);
+		hb_buffer_set_cluster_level(pBuffer, HB_BUFFER_CLUSTER_LEVEL_MONOTONE_CHARACTERS);
+	}
+
+	~LayoutBuildState() {
+		delete pLineBreakIterator;
+		hb_buffer_destroy(pBuffer);
+	}
+
+	// `hb_language_from_string` takes a global lock, so the language of the last locale is kept across runs
+	hb_language_t get_language(const icu::Locale& locale) {
+		if (!hasLanguage || languageName != locale.getLanguage()) {
+			languageName = locale.getLanguage();
+			language = hb_language_from_string(languageName.c_str(), -1);
+			hasLanguage = true;
+		}
+
+		return language;
+	}
+
+	icu::BreakIterator* pLineBreakIterator;
+	hb_buffer_t* pBuffer;
+	std::vector<LogicalRun> logicalRuns;
+	std::vector<uint32_t> glyphs;
+	std::vector<uint32_t> charIndices;
+	// Stored in the units of each run, see `ShapedText::Run::unitScale`
+	std::vector<float> glyphPositions;
+	std::vector<float> glyphWidths;
+	// 26.6 fixed-point glyph widths at the current font scale
+	std::vector<int32_t> lineBreakWidths;
+	std::string languageName;
+	hb_language_t language{};
+	bool hasLanguage{};
+};
+
+/**
+ * View of the shaping results of one paragraph, either in the build state or in a `ShapedText`. Run glyph end
+ * indices and char end indices are paragraph relative, glyph char indices are relative to the whole text.
+ */
+struct ShapedParagraph {
+	const LogicalRun* runs;
+	size_t runCount;
+	const uint32_t* glyphs;
+	const uint32_t* charIndices;
+	const float* glyphPositions;
+	const float* glyphWidths;
+	size_t glyphCount;
+};
+
+/**
+ * Lays out a text one paragraph at a time, so that `LayoutJob` can stop between paragraphs and resume later. Lines
+ * are appended to `result` as each paragraph completes. Text boundaries and vertical alignment are left to the
+ * caller.
+ */
+template <typename CharT, typename BidiBackend>
+class ParagraphLayoutBuilder {
+	public:
+		explicit ParagraphLayoutBuilder(LayoutInfo& result, const CharT* chars, int32_t count,
+					const ValueRuns<Font>& fontRuns, float textAreaWidth, LayoutInfoFlags flags)
+				: m_result(result)
+				, m_chars(chars)
+				, m_count(count)
+				, m_fontRuns(fontRuns)
+				, m_bidi(chars, count, flags)
+				, m_subsetFontRuns(fontRuns.get_run_count())
+				, m_fixedTextAreaWidth(static_cast<int32_t>(textAreaWidth * 64.f)) {}
+
+		ParagraphLayoutBuilder(ParagraphLayoutBuilder&&) = delete;
+		void operator=(ParagraphLayoutBuilder&&) = delete;
+
+		/**
+		 * Lays out the next paragraph. Returns false once every paragraph has been laid out.
+		 */
+		bool build_next_paragraph();
+
+		/**
+		 * Returns the number of code units laid out so far.
+		 */
+		int32_t get_offset() const {
+			return m_paragraphOffset;
+		}
+	private:
+		LayoutInfo& m_result;
+		const CharT* m_chars;
+		int32_t m_count;
+		const ValueRuns<Font>& m_fontRuns;
+		BidiBackend m_bidi;
+		LayoutBuildState m_state;
+		// FIXME: Give the sub-paragraphs a full view of font runs
+		ValueRuns<Font> m_subsetFontRuns;
+		// 26.6 fixed-point text area width
+		int32_t m_fixedTextAreaWidth;
+		int32_t m_paragraphOffset{};
+};
+
+}
+
+template <typename CharT, typename BidiBackend>
+static void build_layout_info_generic(LayoutInfo& result, const CharT* chars, int32_t count,
+		const ValueRuns<Font>& fontRuns, float textAreaWidth, float textAreaHeight,
+		TextYAlignment textYAlignment, LayoutInfoFlags flags);
+template <typename CharT>
+static void shape_text_generic(ShapedText& result, const CharT* chars, int32_t count,
+		const ValueRuns<Font>& fontRuns, LayoutInfoFlags flags);
+template <typename CharT>
+static void reflow_shaped_text(LayoutInfo& result, const ShapedText& shapedText, const CharT* chars,
+		int32_t count, float fontScale, float textAreaWidth, float textAreaHeight, TextYAlignment textYAlignment);
+
+// FIXME: Using `stringOffset` is a bit cumbersome, refactor this logic to have full view of the string
+template <typename CharT, typename BidiBackend>
+static void shape_paragraph(LayoutBuildState& state, BidiBackend& bidi, const CharT* chars, int32_t count,
+		int32_t stringOffset, int32_t paragraphLength, const ValueRuns<Font>& fontRuns, bool unscaled);
+template <typename CharT, typename BidiBackend>
+static size_t build_paragraph_lines(LayoutBuildState& state, LayoutInfo& result, BidiBackend& bidi,
+		const ShapedParagraph& paragraph, const CharT* chars, int32_t count, int32_t stringOffset,
+		int32_t textAreaWidth, float fontScale);
+
+template <typename CharT>
+static ValueRuns<SingleScriptFont> compute_sub_fonts(const CharT* chars, const ValueRuns<Font>& fontRuns,
+		const ValueRuns<UScriptCode>& scriptRuns);
+
+template <typename CharT>
+static bool shape_simple_run(LayoutBuildState& state, FontFace face, hb_font_t* pFont, const CharT* chars,
+		int32_t offset, int32_t count, UScriptCode script, const icu::Locale& locale, bool rightToLeft,
+		int32_t stringOffset, float positionScale);
+template <typename CharT>
+static void shape_logical_run(LayoutBuildState& state, hb_font_t* pFont, const CharT* chars, int32_t offset,
+		int32_t count, int32_t max, UScriptCode script, const icu::Locale& locale, bool rightToLeft,
+		int32_t stringOffset, float positionScale);
+// Unhinted ascent and descent of an unscaled font in em units
+static float get_em_ascent(hb_font_t* pFont);
+static float get_em_descent(hb_font_t* pFont);
+template <typename CharT>
+static int32_t find_previous_line_break(icu::BreakIterator& iter, const CharT* chars, int32_t count,
+		int32_t charIndex);
+template <typename BidiBackend>
+static void compute_line_visual_runs(LayoutInfo& result, BidiBackend& bidi, const ShapedParagraph& paragraph,
+		int32_t lineStart, int32_t lineEnd, int32_t stringOffset, float fontScale, size_t& highestRun,
+		int32_t& highestRunCharEnd);
+static void append_visual_run(LayoutInfo& result, const ShapedParagraph& paragraph, size_t logicalRunIndex,
+		int32_t charStartIndex, int32_t charEndIndex, float fontScale, float& visualRunLastX, size_t& highestRun,
+		int32_t& highestRunCharEnd);
+
+static ShapedParagraph make_shaped_paragraph(const LayoutBuildState& state);
+static ShapedParagraph make_shaped_paragraph(const ShapedText& shapedText, size_t paragraphIndex);
+
+static void align_text_vertically(LayoutInfo& result, float textAreaHeight, TextYAlignment textYAlignment);
+
+// Public Functions
+
+void Text::build_layout_info_icu(LayoutInfo& result, const char16_t* chars, int32_t count,
+		const ValueRuns<Font>& fontRuns, float textAreaWidth, float textAreaHeight,
+		TextYAlignment textYAlignment, LayoutInfoFlags flags) {
+	build_layout_info_generic<char16_t, ICUBidiBackend>(result, chars, count, fontRuns, textAreaWidth,
+			textAreaHeight, textYAlignment, flags);
+}
+
+void Text::build_layout_info_utf8(LayoutInfo& result, const char* chars, int32_t count,
+		const ValueRuns<Font>& fontRuns, float textAreaWidth, float textAreaHeight,
+		TextYAlignment textYAlignment, LayoutInfoFlags flags) {
+	build_layout_info_generic<char, SheenBidiBackend<char>>(result, chars, count, fontRuns, textAreaWidth,
+			textAreaHeight, textYAlignment, flags);
+}
+
+void Text::build_layout_info_utf16(LayoutInfo& result, const char16_t* chars, int32_t count,
+		const ValueRuns<Font>& fontRuns, float textAreaWidth, float textAreaHeight,
+		TextYAlignment textYAlignment, LayoutInfoFlags flags) {
+	build_layout_info_generic<char16_t, SheenBidiBackend<char16_t>>(result, chars, count, fontRuns,
+			textAreaWidth, textAreaHeight, textYAlignment, flags);
+}
+
+void Text::shape_text_utf8(ShapedText& result, const char* chars, int32_t count, const ValueRuns<Font>& fontRuns,
+		LayoutInfoFlags flags) {
+	shape_text_generic(result, chars, count, fontRuns, flags);
+}
+
+void Text::shape_text_utf16(ShapedText& result, const char16_t* chars, int32_t count,
+		const ValueRuns<Font>& fontRuns, LayoutInfoFlags flags) {
+	shape_text_generic(result, chars, count, fontRuns, flags);
+}
+
+void Text::build_layout_info_shaped(LayoutInfo& result, const ShapedText& shapedText, const char* chars,
+		int32_t count, float fontScale, float textAreaWidth, float textAreaHeight,
+		TextYAlignment textYAlignment) {
+	result.clear();
+	result.compute_text_boundaries(chars, count);
+	reflow_shaped_text(result, shapedText, chars, count, fontScale, textAreaWidth, textAreaHeight,
+			textYAlignment);
+}
+
+void Text::build_layout_info_shaped(LayoutInfo& result, const ShapedText& shapedText, const char16_t* chars,
+		int32_t count, float fontScale, float textAreaWidth, float textAreaHeight,
+		TextYAlignment textYAlignment) {
+	result.clear();
+	result.compute_text_boundaries(chars, count);
+	reflow_shaped_text(result, shapedText, chars, count, fontScale, textAreaWidth, textAreaHeight,
+			textYAlignment);
+}
+
+void Text::reflow_layout_info(LayoutInfo& result, const ShapedText& shapedText, const char* chars,
+		int32_t count, float fontScale, float textAreaWidth, float textAreaHeight,
+		TextYAlignment textYAlignment) {
+	result.clear_lines();
+	reflow_shaped_text(result, shapedText, chars, count, fontScale, textAreaWidth, textAreaHeight,
+			textYAlignment);
+}
+
+void Text::reflow_layout_info(LayoutInfo& result, const ShapedText& shapedText, const char16_t* chars,
+		int32_t count, float fontScale, float textAreaWidth, float textAreaHeight,
+		TextYAlignment textYAlignment) {
+	result.clear_lines();
+	reflow_shaped_text(result, shapedText, chars, count, fontScale, textAreaWidth, textAreaHeight,
+			textYAlignment);
+}
+
+struct LayoutJob::State {
+	explicit State(LayoutInfo& result, const char* chars, int32_t count, const ValueRuns<Font>& fontRuns,
+				float textAreaWidth, LayoutInfoFlags flags)
+			: builder(result, chars, count, fontRuns, textAreaWidth, flags) {}
+
+	ParagraphLayoutBuilder<char, SheenBidiBackend<char>> builder;
+};
+
+LayoutJob::LayoutJob(LayoutInfo& result, const char* chars, int32_t count, const ValueRuns<Font>& fontRuns,
+			float textAreaWidth, float textAreaHeight, TextYAlignment textYAlignment, LayoutInfoFlags flags)
+		: m_result(result)
+		, m_chars(chars)
+		, m_count(count)
+		, m_fontRuns(fontRuns)
+		, m_textAreaWidth(textAreaWidth)
+		, m_textAreaHeight(textAreaHeight)
+		, m_textYAlignment(textYAlignment)
+		, m_flags(flags) {}
+
+LayoutJob::~LayoutJob() = default;
+
+LayoutJobStatus LayoutJob::resume(const LayoutJobBudget& budget) {
+	if (m_complete) {
+		return LayoutJobStatus::COMPLETE;
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	if (!m_state) {
+		m_result.clear();
+		m_result.compute_text_boundaries(m_chars, m_count);
+		m_state = std::make_unique<State>(m_result, m_chars, m_count, m_fontRuns, m_textAreaWidth, m_flags);
+	}
+
+	auto startOffset = m_state->builder.get_offset();
+
+	for (;;) {
+		// A text ending with a paragraph separator keeps it in the last paragraph, so no paragraph is left once
+		// the whole text is consumed
+		if (!m_state->builder.build_next_paragraph() || m_state->builder.get_offset() >= m_count) {
+			m_complete = true;
+			break;
+		}
+
+		if (budget.codeUnits != 0 && m_state->builder.get_offset() - startOffset >= budget.codeUnits) {
+			break;
+		}
+
+		if (budget.time.count() != 0 && std::chrono::steady_clock::now() - startTime >= budget.time) {
+			break;
+		}
+	}
+
+	m_progress = m_state->builder.get_offset();
+	align_text_vertically(m_result, m_textAreaHeight, m_textYAlignment);
+
+	if (m_complete) {
+		m_state.reset();
+		return LayoutJobStatus::COMPLETE;
+	}
+
+	return LayoutJobStatus::PARTIAL;
+}
+
+bool LayoutJob::is_complete() const {
+	return m_complete;
+}
+
+int32_t LayoutJob::get_progress() const {
+	return m_progress;
+}
+
+// Static Functions
+
+template <typename CharT, typename BidiBackend>
+static void build_layout_info_generic(LayoutInfo& result, const CharT* chars, int32_t count,
+		const ValueRuns<Font>& fontRuns, float textAreaWidth, float textAreaHeight,
+		TextYAlignment textYAlignment, LayoutInfoFlags flags) {
+	result.clear();
+	result.compute_text_boundaries(chars, count);
+
+	ParagraphLayoutBuilder<CharT, BidiBackend> builder(result, chars, count, fontRuns, textAreaWidth, flags);
+
+	while (builder.build_next_paragraph()) {}
+
+	align_text_vertically(result, textAreaHeight, textYAlignment);
+}
+
+template <typename CharT, typename BidiBackend>
+bool ParagraphLayoutBuilder<CharT, BidiBackend>::build_next_paragraph() {
+	int32_t contentLength;
+	int32_t separatorLength;
+	int32_t paragraphLength;
+
+	if (!m_bidi.next_paragraph(m_paragraphOffset, contentLength, separatorLength, paragraphLength)) {
+		return false;
+	}
+
+	size_t lastHighestRun;
+
+	if (contentLength > 0) {
+		m_subsetFontRuns.clear();
+		m_fontRuns.get_runs_subset(m_paragraphOffset, contentLength, m_subsetFontRuns);
+
+		shape_paragraph(m_state, m_bidi, m_chars + m_paragraphOffset, contentLength, m_paragraphOffset,
+				paragraphLength, m_subsetFontRuns, false);
+		lastHighestRun = build_paragraph_lines(m_state, m_result, m_bidi, make_shaped_paragraph(m_state),
+				m_chars + m_paragraphOffset, contentLength, m_paragraphOffset, m_fixedTextAreaWidth, 1.f);
+		m_bidi.end_paragraph();
+	}
+	else {
+		auto font = m_fontRuns.get_value(m_paragraphOffset == m_count ? m_count - 1 : m_paragraphOffset);
+		auto fontData = FontRegistry::get_font_data(font);
+		auto height = fontData.get_ascent() - fontData.get_descent();
+
+		lastHighestRun = m_result.get_run_count();
+		m_result.append_empty_line(static_cast<uint32_t>(m_paragraphOffset), height, fontData.get_ascent());
+	}
+
+	m_result.set_run_char_end_offset(lastHighestRun, separatorLength);
+
+	m_paragraphOffset += paragraphLength;
+
+	return true;
+}
+
+template <typename CharT>
+static void shape_text_generic(ShapedText& result, const CharT* chars, int32_t count,
+		const ValueRuns<Font>& fontRuns, LayoutInfoFlags flags) {
+	result.clear();
+
+	LayoutBuildState state{};
+	SheenBidiBackend<CharT> bidi(chars, count, flags);
+
+	ValueRuns<Font> subsetFontRuns(fontRuns.get_run_count());
+
+	int32_t paragraphOffset{};
+	int32_t contentLength;
+	int32_t separatorLength;
+	int32_t paragraphLength;
+
+	while (bidi.next_paragraph(paragraphOffset, contentLength, separatorLength, paragraphLength)) {
+		if (contentLength > 0) {
+			subsetFontRuns.clear();
+			fontRuns.get_runs_subset(paragraphOffset, contentLength, subsetFontRuns);
+
+			shape_paragraph(state, bidi, chars + paragraphOffset, contentLength, paragraphOffset,
+					paragraphLength, subsetFontRuns, true);
+
+			for (auto& run : state.logicalRuns) {
+				result.append_run(run);
+			}
+
+			result.append_glyphs(state.glyphs.data(), state.charIndices.data(), state.glyphWidths.data(),
+					state.glyphs.size(), state.glyphPositions.data(), state.glyphPositions.size());
+			result.append_paragraph(bidi.retain_paragraph(), paragraphOffset, contentLength, separatorLength,
+					0.f, 0.f);
+			bidi.end_paragraph();
+		}
+		else {
+			auto font = fontRuns.get_value(paragraphOffset == count ? count - 1 : paragraphOffset);
+			auto* pFont = FontRegistry::get_unscaled_font({FontRegistry::get_face(font), font.get_size()});
+			auto size = static_cast<float>(font.get_size());
+
+			result.append_paragraph(nullptr, paragraphOffset, 0, separatorLength, get_em_ascent(pFont) * size,
+					get_em_descent(pFont) * size);
+		}
+
+		paragraphOffset += paragraphLength;
+	}
+
+	result.set_text_length(count);
+}
+
+template <typename CharT>
+static void reflow_shaped_text(LayoutInfo& result, const ShapedText& shapedText, const CharT* chars,
+		int32_t count, float fontScale, float textAreaWidth, float textAreaHeight, TextYAlignment textYAlignment) {
+	LayoutBuildState state{};
+	size_t lastHighestRun = 0;
+
+	// 26.6 fixed-point text area width
+	auto fixedTextAreaWidth = static_cast<int32_t>(textAreaWidth * 64.f);
+
+	for (size_t i = 0; i < shapedText.get_paragraph_count(); ++i) {
+		auto& paragraph = shapedText.get_paragraph(i);
+
+		if (paragraph.contentLength > 0) {
+			RetainedBidi bidi(paragraph.bidiParagraph);
+			lastHighestRun = build_paragraph_lines(state, result, bidi, make_shaped_paragraph(shapedText, i),
+					chars + paragraph.offset, paragraph.contentLength, paragraph.offset, fixedTextAreaWidth,
+					fontScale);
+		}
+		else {
+			auto ascent = paragraph.ascent * fontScale;
+			auto descent = paragraph.descent * fontScale;
+
+			lastHighestRun = result.get_run_count();
+			result.append_empty_line(static_cast<uint32_t>(paragraph.offset), ascent - descent, ascent);
+		}
+
+		result.set_run_char_end_offset(lastHighestRun, paragraph.separatorLength);
+	}
+
+	align_text_vertically(result, textAreaHeight, textYAlignment);
+}
+
+template <typename CharT, typename BidiBackend>
+static void shape_paragraph(LayoutBuildState& state, BidiBackend& bidi, const CharT* chars, int32_t count,
+		int32_t stringOffset, int32_t paragraphLength, const ValueRuns<Font>& fontRuns, bool unscaled) {
+	auto levelRuns = bidi.begin_paragraph(stringOffset, count, paragraphLength);
+	auto scriptRuns = BidiBackend::compute_scripts(chars, count);
+	ValueRuns<const icu::Locale*> localeRuns(&icu::Locale::getDefault(), count);
+	auto subFontRuns = compute_sub_fonts(chars, fontRuns, scriptRuns);
+	int32_t runStart{};
+
+	state.logicalRuns.clear();
+
+	state.glyphs.clear();
+	state.glyphs.reserve(count);
+
+	state.charIndices.clear();
+	state.charIndices.reserve(count);
+
+	state.glyphPositions.clear();
+	state.glyphPositions.reserve(2 * (count + subFontRuns.get_run_count()));
+
+	state.glyphWidths.clear();
+	state.glyphWidths.reserve(count);
+
+	iterate_run_intersections([&](auto limit, auto font, auto level, auto script, auto* pLocale) {
+		bool rightToLeft = level & 1;
+		auto size = static_cast<float>(font.size);
+
+		// Unscaled runs are stored in em units, hinted runs in 26.6 pixels. Only hinted runs need the sized FreeType
+		// face behind `get_font_data`.
+		FontData fontData{};
+		hb_font_t* pFont;
+		float positionScale;
+
+		if (unscaled) {
+			pFont = FontRegistry::get_unscaled_font(font);
+			positionScale = 1.f / static_cast<float>(hb_face_get_upem(hb_font_get_face(pFont)));
+		}
+		else {
+			fontData = FontRegistry::get_font_data(font);
+			pFont = fontData.hbFont;
+			positionScale = 1.f;
+		}
+
+		if (!shape_simple_run(state, font.face, pFont, chars, runStart, limit - runStart, script, *pLocale,
+				rightToLeft, stringOffset, positionScale)) {
+			shape_logical_run(state, pFont, chars, runStart, limit - runStart, count, script, *pLocale,
+					rightToLeft, stringOffset, positionScale);
+		}
+
+		state.logicalRuns.push_back({
+			.font = font,
+			.unitScale = unscaled ? size : 1.f / 64.f,
+			.ascent = unscaled ? get_em_ascent(pFont) * size : fontData.get_ascent(),
+			.descent = unscaled ? get_em_descent(pFont) * size : fontData.get_descent(),
+			.charEndIndex = limit,
+			.glyphEndIndex = static_cast<uint32_t>(state.glyphs.size()),
+			.level = level,
+		});
+
+		runStart = limit;
+	}, subFontRuns, levelRuns, scriptRuns, localeRuns);
+}
+
+template <typename CharT, typename BidiBackend>
+static size_t build_paragraph_lines(LayoutBuildState& state, LayoutInfo& result, BidiBackend& bidi,
+		const ShapedParagraph& paragraph, const CharT* chars, int32_t count, int32_t stringOffset,
+		int32_t textAreaWidth, float fontScale) {
+	size_t highestRun{};
+	int32_t highestRunCharEnd{INT32_MIN};
+
+	// If width == 0, perform no line breaking
+	if (textAreaWidth == 0) {
+		compute_line_visual_runs(result, bidi, paragraph, stringOffset, stringOffset + count, stringOffset,
+				fontScale, highestRun, highestRunCharEnd);
+		return highestRun;
+	}
+
+	// Convert widths to 26.6 at the current scale once, so that lines are fit with integer sums. For hinted runs
+	// at a scale of 1 this is exactly the width HarfBuzz returned.
+	state.lineBreakWidths.resize(paragraph.glyphCount);
+
+	for (size_t run = 0, glyphIndex = 0; run < paragraph.runCount; ++run) {
+		auto widthScale = paragraph.runs[run].unitScale * fontScale * 64.f;
+
+		for (; glyphIndex < paragraph.runs[run].glyphEndIndex; ++glyphIndex) {
+			state.lineBreakWidths[glyphIndex] = static_cast<int32_t>(std::lround(paragraph.glyphWidths[glyphIndex]
+					* widthScale));
+		}
+	}
+
+	auto* glyphWidths = state.lineBreakWidths.data();
+	auto* charIndices = paragraph.charIndices;
+	auto glyphCount = paragraph.glyphCount;
+
+	// Find line breaks
+	UText uText UTEXT_INITIALIZER;
+	UErrorCode err{};
+	Encoding<CharT>::open_utext(&uText, chars, count, err);
+	state.pLineBreakIterator->setText(&uText, err);
+
+	int32_t lineEnd = stringOffset;
+	int32_t lineStart;
+
+	while (lineEnd < stringOffset + count) {
+		int32_t lineWidthSoFar{};
+
+		lineStart = lineEnd;
+
+		auto glyphIndex = binary_search(0, glyphCount, [&](auto index) {
+			return charIndices[index] < lineStart;
+		});
+
+		while (glyphIndex < glyphCount && lineWidthSoFar + glyphWidths[glyphIndex] <= textAreaWidth) {
+			lineWidthSoFar += glyphWidths[glyphIndex];
+			++glyphIndex;
+		}
+
+		// If no glyphs fit on the line, force one to fit. There shouldn't be any zero width glyphs at the start
+		// of a line unless the paragraph consists of only zero width glyphs, because otherwise the zero width
+		// glyphs will have been included on the end of the previous line
+		if (lineWidthSoFar == 0 && glyphIndex < glyphCount) {
+			++glyphIndex;
+		}
+
+		auto charIndex = glyphIndex == glyphCount ? count + stringOffset : charIndices[glyphIndex];
+		lineEnd = find_previous_line_break(*state.pLineBreakIterator, chars, count, charIndex - stringOffset)
+				+ stringOffset;
+
+		// If this break is at or before the last one, find a glyph that produces a break after the last one,
+		// starting at the one which didn't fit
+		while (lineEnd <= lineStart && glyphIndex < glyphCount) {
+			lineEnd = charIndices[glyphIndex++];
+		}
+
+		if (lineEnd <= lineStart && glyphIndex == glyphCount) {
+			lineEnd = stringOffset + count;
+		}
+
+		compute_line_visual_runs(result, bidi, paragraph, lineStart, lineEnd, stringOffset, fontScale, highestRun,
+				highestRunCharEnd);
+	}
+
+	utext_close(&uText);
+
+	return highestRun;
+}
+
+template <typename CharT>
+static ValueRuns<SingleScriptFont> compute_sub_fonts(const CharT* chars, const ValueRuns<Font>& fontRuns,
+		const ValueRuns<UScriptCode>& scriptRuns) {
+	ValueRuns<SingleScriptFont> result(fontRuns.get_run_count());
+	int32_t offset{};
+
+	iterate_run_intersections([&](auto limit, auto baseFont, auto script) {
+		while (offset < limit) {
+			auto subFont = FontRegistry::get_sub_font(baseFont, chars, offset, limit, script);
+			result.add(offset, subFont);
+		}
+	}, fontRuns, scriptRuns);
+
+	return result;
+}
+
+// Produces what `shape_logical_run` would for runs that HarfBuzz maps straight through the cmap, see
+// `get_simple_shaping_exclusions`. Returns false without touching the state if the run needs the shaper.
+template <typename CharT>
+static bool shape_simple_run(LayoutBuildState& state, FontFace face, hb_font_t* pFont, const CharT* chars,
+		int32_t offset, int32_t count, UScriptCode script, const icu::Locale& locale, bool rightToLeft,
+		int32_t stringOffset, float positionScale) {
+	if (rightToLeft || !is_simple_shaping_enabled()) {
+		return false;
+	}
+
+	auto* pTouchedGlyphs = get_simple_shaping_exclusions(face, pFont, script, state.get_language(locale));
+
+	if (!pTouchedGlyphs) {
+		return false;
+	}
+
+	auto glyphStart = state.glyphs.size();
+
+	for (int32_t index = offset; index < offset + count;) {
+		auto c = Encoding<CharT>::get(chars, index, offset + count);
+		hb_codepoint_t glyph{};
+
+		if (c < 0 || !is_simple_shaping_codepoint(static_cast<uint32_t>(c))
+				|| !hb_font_get_nominal_glyph(pFont, static_cast<hb_codepoint_t>(c), &glyph)
+				|| hb_set_has(pTouchedGlyphs, glyph)) {
+			state.glyphs.resize(glyphStart);
+			state.charIndices.resize(glyphStart);
+			return false;
+		}
+
+		state.glyphs.emplace_back(glyph);
+		state.charIndices.emplace_back(index + stringOffset);
+		Encoding<CharT>::forward(chars, index, offset + count);
+	}
+
+	int32_t cursorX{};
+
+	for (auto i = glyphStart; i < state.glyphs.size(); ++i) {
+		auto advance = hb_font_get_glyph_h_advance(pFont, state.glyphs[i]);
+
+		state.glyphPositions.emplace_back(static_cast<float>(cursorX) * positionScale);
+		state.glyphPositions.emplace_back(0.f);
+		state.glyphWidths.emplace_back(static_cast<float>(advance) * positionScale);
+		cursorX += advance;
+	}
+
+	state.glyphPositions.emplace_back(static_cast<float>(cursorX) * positionScale);
+	state.glyphPositions.emplace_back(0.f);
+
+	return true;
+}
+
+template <typename CharT>
+static void shape_logical_run(LayoutBuildState& state, hb_font_t* pFont, const CharT* chars, int32_t offset,
+		int32_t count, int32_t max, UScriptCode script, const icu::Locale& locale, bool rightToLeft,
+		int32_t stringOffset, float positionScale) {
+	hb_buffer_set_script(state.pBuffer, hb_script_from_string(uscript_getShortName(script), 4));
+	hb_buffer_set_language(state.pBuffer, state.get_language(locale));
+	hb_buffer_set_direction(state.pBuffer, rightToLeft ? HB_DIRECTION_RTL : HB_DIRECTION_LTR);
+	hb_buffer_set_length(state.pBuffer, 0);
+	hb_buffer_set_flags(state.pBuffer, (hb_buffer_flags_t)((offset == 0 ? HB_BUFFER_FLAG_BOT : 0)
+			| (offset + count == max ? HB_BUFFER_FLAG_EOT : 0)));
+	Encoding<CharT>::add_to_buffer(state.pBuffer, chars, max, offset, 0);
+	Encoding<CharT>::add_to_buffer(state.pBuffer, chars + offset, max - offset, 0, count);
+
+	hb_shape(pFont, state.pBuffer, nullptr, 0);
+
+	auto glyphCount = hb_buffer_get_length(state.pBuffer);
+	auto* glyphPositions = hb_buffer_get_glyph_positions(state.pBuffer, nullptr);
+	auto* glyphInfos = hb_buffer_get_glyph_infos(state.pBuffer, nullptr);
+	int32_t cursorX{};
+	int32_t cursorY{};
+
+	auto scale = [positionScale](int32_t value) {
+		return static_cast<float>(value) * positionScale;
+	};
+
+	for (unsigned i = 0; i < glyphCount; ++i) {
+		state.glyphPositions.emplace_back(scale(cursorX + glyphPositions[i].x_offset));
+		state.glyphPositions.emplace_back(scale(cursorY + glyphPositions[i].y_offset));
+		cursorX += glyphPositions[i].x_advance;
+		cursorY += glyphPositions[i].y_advance;
+	}
+
+	state.glyphPositions.emplace_back(scale(cursorX));
+	state.glyphPositions.emplace_back(scale(cursorY));
+
+	if (rightToLeft) {
+		for (unsigned i = glyphCount - 1; ; --i) {
+			state.glyphs.emplace_back(glyphInfos[i].codepoint);
+			state.charIndices.emplace_back(glyphInfos[i].cluster + offset + stringOffset);
+
+			if (i == glyphCount - 1) {
+				state.glyphWidths.emplace_back(scale(glyphPositions[i].x_advance - glyphPositions[i].x_offset));
+			}
+			else {
+				state.glyphWidths.emplace_back(scale(glyphPositions[i].x_advance + glyphPositions[i + 1].x_offset
+						- glyphPositions[i].x_offset));
+			}
+
+			if (i == 0) {
+				break;
+			}
+		}
+	}
+	else {
+		for (unsigned i = 0; i < glyphCount; ++i) {
+			state.glyphs.emplace_back(glyphInfos[i].codepoint);
+			state.charIndices.emplace_back(glyphInfos[i].cluster + offset + stringOffset);
+
+			if (i == glyphCount - 1) {
+				state.glyphWidths.emplace_back(scale(glyphPositions[i].x_advance - glyphPositions[i].x_offset));
+			}
+			else {
+				state.glyphWidths.emplace_back(scale(glyphPositions[i].x_advance + glyphPositions[i + 1].x_offset
+						- glyphPositions[i].x_offset));
+			}
+		}
+	}
+}
+
+template <typename CharT>
+static int32_t find_previous_line_break(icu::BreakIterator& iter, const CharT* chars, int32_t count,
+		int32_t charIndex) {
+	// Skip over any whitespace or control characters because they can hang in the margin
+	while (charIndex < count) {
+		auto chr = Encoding<CharT>::get(chars, charIndex, count);
+
+		if (!u_isWhitespace(chr) && !u_iscntrl(chr)) {
+			break;
+		}
+
+		Encoding<CharT>::forward(chars, charIndex, count);
+	}
+
+	if (charIndex >= count) {
+		return iter.last();
+	}
+
+	// Return the break location that's at or before the character we stopped on. Note: if we're on a break, the
+	// forward step will cause `preceding` to back up to it.
+	Encoding<CharT>::forward(chars, charIndex, count);
+
+	return iter.preceding(charIndex);
+}
+
+template <typename BidiBackend>
+static void compute_line_visual_runs(LayoutInfo& result, BidiBackend& bidi, const ShapedParagraph& paragraph,
+		int32_t lineStart, int32_t lineEnd, int32_t stringOffset, float fontScale, size_t& highestRun,
+		int32_t& highestRunCharEnd) {
+	auto* logicalRuns = paragraph.runs;
+	float maxAscent{};
+	float maxDescent{};
+	float visualRunLastX{};
+
+	bidi.for_each_visual_run(lineStart, lineEnd, [&](int32_t visualRunStart, int32_t runLength,
+			bool rightToLeft) {
+		auto runStart = visualRunStart - stringOffset;
+		auto runEnd = runStart + runLength - 1;
+
+		if (!rightToLeft) {
+			auto run = binary_search(0, paragraph.runCount, [&](auto index) {
+				return logicalRuns[index].charEndIndex <= runStart;
+			});
+			auto chrIndex = runStart;
+
+			for (;;) {
+				auto logicalRunEnd = logicalRuns[run].charEndIndex;
+
+				if (auto ascent = logicalRuns[run].ascent * fontScale; ascent > maxAscent) {
+					maxAscent = ascent;
+				}
+
+				if (auto descent = logicalRuns[run].descent * fontScale; descent < maxDescent) {
+					maxDescent = descent;
+				}
+
+				if (runEnd < logicalRunEnd) {
+					append_visual_run(result, paragraph, run, chrIndex + stringOffset, runEnd + stringOffset,
+							fontScale, visualRunLastX, highestRun, highestRunCharEnd);
+					break;
+				}
+				else {
+					append_visual_run(result, paragraph, run, chrIndex + stringOffset,
+							logicalRunEnd - 1 + stringOffset, fontScale, visualRunLastX, highestRun,
+							highestRunCharEnd);
+					chrIndex = logicalRunEnd;
+					++run;
+				}
+			}
+		}
+		else {
+			auto run = binary_search(0, paragraph.runCount, [&](auto index) {
+				return logicalRuns[index].charEndIndex <= runEnd;
+			});
+			auto chrIndex = runEnd;
+
+			for (;;) {
+				auto logicalRunStart = run == 0 ? 0 : logicalRuns[run - 1].charEndIndex;
+
+				if (auto ascent = logicalRuns[run].ascent * fontScale; ascent > maxAscent) {
+					maxAscent = ascent;
+				}
+
+				if (auto descent = logicalRuns[run].descent * fontScale; descent < maxDescent) {
+					maxDescent = descent;
+				}
+
+				if (runStart >= logicalRunStart) {
+					append_visual_run(result, paragraph, run, runStart + stringOffset, chrIndex + stringOffset,
+							fontScale, visualRunLastX, highestRun, highestRunCharEnd);
+					break;
+				}
+				else {
+					append_visual_run(result, paragraph, run, logicalRunStart + stringOffset,
+							chrIndex + stringOffset, fontScale, visualRunLastX, highestRun, highestRunCharEnd);
+					chrIndex = logicalRunStart - 1;
+					--run;
+				}
+			}
+		}
+	});
+
+	result.append_line(maxAscent - maxDescent, maxAscent);
+}
+
+static void append_visual_run(LayoutInfo& result, const ShapedParagraph& paragraph, size_t run,
+		int32_t charStartIndex, int32_t charEndIndex, float fontScale, float& visualRunLastX, size_t& highestRun,
+		int32_t& highestRunCharEnd) {
+	auto* logicalRuns = paragraph.runs;
+	auto* glyphPositions = paragraph.glyphPositions;
+	auto logicalFirstGlyph = run == 0 ? 0 : logicalRuns[run - 1].glyphEndIndex;
+	auto logicalLastGlyph = logicalRuns[run].glyphEndIndex;
+	auto logicalFirstPos = run == 0 ? 0 : 2 * (logicalRuns[run - 1].glyphEndIndex + run);
+	bool rightToLeft = logicalRuns[run].level & 1;
+	auto scale = logicalRuns[run].unitScale * fontScale;
+	uint32_t visualFirstGlyph;
+	uint32_t visualLastGlyph;
+
+	if (charEndIndex > highestRunCharEnd) {
+		highestRun = result.get_run_count();
+		highestRunCharEnd = charEndIndex;
+	}
+
+	visualFirstGlyph = binary_search(logicalFirstGlyph,
+			logicalLastGlyph - logicalFirstGlyph, [&](auto index) {
+		return paragraph.charIndices[index] < charStartIndex;
+	});
+
+	visualLastGlyph = binary_search(visualFirstGlyph,
+			logicalLastGlyph - visualFirstGlyph, [&](auto index) {
+		return paragraph.charIndices[index] <= charEndIndex;
+	});
+
+	uint32_t visualFirstPosIndex;
+	uint32_t visualLastPosIndex;
+
+	if (rightToLeft) {
+		if (visualLastGlyph > visualFirstGlyph) {
+			for (uint32_t i = visualLastGlyph - 1; ; --i) {
+				result.append_glyph(paragraph.glyphs[i]);
+				result.append_char_index(paragraph.charIndices[i]);
+
+				if (i == visualFirstGlyph) {
+					break;
+				}
+			}
+		}
+
+		visualFirstPosIndex = logicalFirstGlyph + (logicalLastGlyph - visualLastGlyph);
+		visualLastPosIndex = logicalLastGlyph - (visualFirstGlyph - logicalFirstGlyph);
+	}
+	else {
+		for (uint32_t i = visualFirstGlyph; i < visualLastGlyph; ++i) {
+			result.append_glyph(paragraph.glyphs[i]);
+			result.append_char_index(paragraph.charIndices[i]);
+		}
+
+		visualFirstPosIndex = visualFirstGlyph;
+		visualLastPosIndex = visualLastGlyph;
+	}
+
+	visualRunLastX -= glyphPositions[logicalFirstPos + 2 * (visualFirstPosIndex - logicalFirstGlyph)] * scale;
+
+	for (uint32_t i = visualFirstPosIndex; i < visualLastPosIndex; ++i) {
+		auto posIndex = logicalFirstPos + 2 * (i - logicalFirstGlyph);
+		result.append_glyph_position(glyphPositions[posIndex] * scale + visualRunLastX,
+				glyphPositions[posIndex + 1] * scale);
+	}
+
+	auto logicalLastPos = logicalFirstPos + 2 * (visualLastPosIndex - logicalFirstGlyph);
+	result.append_glyph_position(glyphPositions[logicalLastPos] * scale + visualRunLastX,
+			glyphPositions[logicalLastPos + 1] * scale);
+
+	visualRunLastX += glyphPositions[logicalLastPos] * scale;
+
+	auto font = logicalRuns[run].font;
+
+	if (fontScale != 1.f) {
+		font.size = std::max(1u, static_cast<uint32_t>(std::lround(static_cast<float>(font.size) * fontScale)));
+	}
+
+	result.append_run(font, static_cast<uint32_t>(charStartIndex), static_cast<uint32_t>(charEndIndex + 1),
+			rightToLeft);
+}
+
+static ShapedParagraph make_shaped_paragraph(const LayoutBuildState& state) {
+	return {
+		.runs = state.logicalRuns.data(),
+		.runCount = state.logicalRuns.size(),
+		.glyphs = state.glyphs.data(),
+		.charIndices = state.charIndices.data(),
+		.glyphPositions = state.glyphPositions.data(),
+		.glyphWidths = state.glyphWidths.data(),
+		.glyphCount = state.glyphs.size(),
+	};
+}
+
+static ShapedParagraph make_shaped_paragraph(const ShapedText& shapedText, size_t paragraphIndex) {
+	auto& paragraph = shapedText.get_paragraph(paragraphIndex);
+	auto firstRun = shapedText.get_paragraph_first_run_index(paragraphIndex);
+	auto firstGlyph = shapedText.get_paragraph_first_glyph_index(paragraphIndex);
+
+	// Each run stores one extra position pair for its end
+	return {
+		.runs = shapedText.get_runs() + firstRun,
+		.runCount = paragraph.runEndIndex - firstRun,
+		.glyphs = shapedText.get_glyphs() + firstGlyph,
+		.charIndices = shapedText.get_char_indices() + firstGlyph,
+		.glyphPositions = shapedText.get_glyph_positions() + 2 * (firstGlyph + firstRun),
+		.glyphWidths = shapedText.get_glyph_widths() + firstGlyph,
+		.glyphCount = paragraph.glyphEndIndex - firstGlyph,
+	};
+}
+
+static void align_text_vertically(LayoutInfo& result, float textAreaHeight, TextYAlignment textYAlignment) {
+	auto totalHeight = result.get_text_height();
+	result.set_text_start_y(static_cast<float>(textYAlignment) * (textAreaHeight - totalHeight) * 0.5f);
+}
+
+static float get_em_ascent(hb_font_t* pFont) {
+	hb_font_extents_t extents{};
+	hb_font_get_h_extents(pFont, &extents);
+	return static_cast<float>(extents.ascender) / static_cast<float>(hb_face_get_upem(hb_font_get_face(pFont)));
+}
+
+static float get_em_descent(hb_font_t* pFont) {
+	hb_font_extents_t extents{};
+	hb_font_get_h_extents(pFont, &extents);
+	return static_cast<float>(extents.descender) / static_cast<float>(hb_face_get_upem(hb_font_get_face(pFont)));
+}
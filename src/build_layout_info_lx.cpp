@@ -131,6 +131,7 @@ void Text::build_layout_info_icu_lx(LayoutInfo& result, const char16_t* chars, i
 		const ValueRuns<Font>& fontRuns, float textAreaWidth, float textAreaHeight,
 		TextYAlignment textYAlignment, LayoutInfoFlags flags) {
 	result.clear();
+	result.compute_text_boundaries(chars, count);
 
 	ValueRuns<Font> subsetFontRuns(fontRuns.get_run_count());
 	std::vector<LEMultiScript> multiScriptFonts;
@@ -0,0 +1,53 @@
+#include "codepoint_set.hpp"
+
+using namespace Text;
+
+CodepointSet::CodepointSet(const uint32_t* sortedCodepoints, size_t count) {
+	if (count == 0) {
+		return;
+	}
+
+	m_blockPages.resize(BLOCK_COUNT);
+	// Page 0 is the shared empty page
+	m_pages.resize(WORDS_PER_PAGE);
+
+	uint32_t lastBlock = BLOCK_COUNT;
+
+	for (size_t i = 0; i < count; ++i) {
+		auto codepoint = sortedCodepoints[i];
+
+		if (codepoint >= CODEPOINT_LIMIT) {
+			break;
+		}
+
+		auto block = codepoint >> BLOCK_BITS;
+
+		if (block != lastBlock) {
+			m_blockPages[block] = static_cast<uint16_t>(m_pages.size() / WORDS_PER_PAGE);
+			m_pages.resize(m_pages.size() + WORDS_PER_PAGE);
+			lastBlock = block;
+		}
+
+		auto& word = m_pages[m_blockPages[block] * WORDS_PER_PAGE + ((codepoint & (BLOCK_SIZE - 1)) >> 6)];
+		auto bit = uint64_t{1} << (codepoint & 63);
+
+		if (!(word & bit)) {
+			word |= bit;
+			++m_size;
+		}
+	}
+
+	m_pages.shrink_to_fit();
+}
+
+bool CodepointSet::empty() const {
+	return m_size == 0;
+}
+
+size_t CodepointSet::size() const {
+	return m_size;
+}
+
+size_t CodepointSet::get_memory_size() const {
+	return m_blockPages.capacity() * sizeof(uint16_t) + m_pages.capacity() * sizeof(uint64_t);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+
+namespace Text {
+
+/**
+ * Immutable sparse set of Unicode codepoints, stored as a two-level bitset. The codepoint space is split into
+ * blocks of `BLOCK_SIZE` codepoints, and each block indexes a bit page. All empty blocks share page 0, so a face
+ * covering a few scripts costs a few pages rather than a bit per codepoint.
+ */
+class CodepointSet final {
+	public:
+		static constexpr const uint32_t CODEPOINT_LIMIT = 0x110000u;
+		static constexpr const uint32_t BLOCK_BITS = 12;
+		static constexpr const uint32_t BLOCK_SIZE = 1u << BLOCK_BITS;
+		static constexpr const uint32_t BLOCK_COUNT = CODEPOINT_LIMIT / BLOCK_SIZE;
+		static constexpr const uint32_t WORDS_PER_PAGE = BLOCK_SIZE / 64;
+
+		explicit CodepointSet() = default;
+		/**
+		 * Builds the set from `count` codepoints in ascending order. Values at or above `CODEPOINT_LIMIT` are
+		 * ignored.
+		 */
+		explicit CodepointSet(const uint32_t* sortedCodepoints, size_t count);
+
+		CodepointSet(CodepointSet&&) noexcept = default;
+		CodepointSet& operator=(CodepointSet&&) noexcept = default;
+
+		CodepointSet(const CodepointSet&) = delete;
+		void operator=(const CodepointSet&) = delete;
+
+		bool contains(uint32_t codepoint) const {
+			if (codepoint >= CODEPOINT_LIMIT || m_blockPages.empty()) {
+				return false;
+			}
+
+			auto page = m_blockPages[codepoint >> BLOCK_BITS];
+			auto word = m_pages[page * WORDS_PER_PAGE + ((codepoint & (BLOCK_SIZE - 1)) >> 6)];
+
+			return (word >> (codepoint & 63)) & 1;
+		}
+
+		bool empty() const;
+		size_t size() const;
+
+		/**
+		 * Heap memory used by the set, in bytes.
+		 */
+		size_t get_memory_size() const;
+	private:
+		std::vector<uint16_t> m_blockPages;
+		std::vector<uint64_t> m_pages;
+		size_t m_size{};
+};
+
+}
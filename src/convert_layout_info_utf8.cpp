@@ -14,6 +14,7 @@ void Text::convert_layout_info_to_utf8(const LayoutInfo& src, LayoutInfo& result
 		int32_t srcCharCount, const char* dstChars, int32_t dstCharCount) {
 	result.clear();
 	result.reserve_runs(src.get_run_count());
+	result.compute_text_boundaries(dstChars, dstCharCount);
 
 	auto* glyphPositions = src.get_glyph_position_data();
 	for (size_t i = 0; i < src.get_glyph_position_data_count(); i += 2) {
@@ -3,47 +3,35 @@
 #include "cursor_position.hpp"
 #include "text_alignment.hpp"
 
-#include <unicode/uversion.h>
-
-#include <string_view>
-
-U_NAMESPACE_BEGIN
-
-class BreakIterator;
-
-U_NAMESPACE_END
+#include <cstddef>
 
 namespace Text {
 
 class LayoutInfo;
+struct HitTestResult;
 
+/**
+ * Cursor movement and hit testing over a built `LayoutInfo`. Character and word movement scan the grapheme and
+ * word boundary sets computed with the layout, so no per-text break iterator state is kept.
+ */
 class CursorController {
 	public:
-		explicit CursorController();
-		~CursorController();
-
-		CursorController(CursorController&&) noexcept;
-		CursorController& operator=(CursorController&&) noexcept;
+		CursorPosition next_character(const LayoutInfo&, CursorPosition) const;
+		CursorPosition prev_character(const LayoutInfo&, CursorPosition) const;
 
-		CursorController(const CursorController&) = delete;
-		void operator=(const CursorController&) = delete;
-
-		void set_text(std::string_view);
-
-		CursorPosition next_character(CursorPosition);
-		CursorPosition prev_character(CursorPosition);
-
-		CursorPosition next_word(CursorPosition);
-		CursorPosition prev_word(CursorPosition);
+		CursorPosition next_word(const LayoutInfo&, CursorPosition) const;
+		CursorPosition prev_word(const LayoutInfo&, CursorPosition) const;
 
 		CursorPosition closest_in_line(const LayoutInfo&, float textAreaWidth, TextXAlignment, size_t lineIndex,
-				float posX);
+				float posX) const;
 		CursorPosition closest_to_position(const LayoutInfo&, float textAreaWidth, TextXAlignment, float posX,
-				float posY);
-	private:
-		icu::BreakIterator* m_iter;
-		std::string_view m_text;
+				float posY) const;
+		/**
+		 * Batched `closest_to_position` for `count` interleaved x, y pairs, best sorted by y. See
+		 * `LayoutInfo::hit_test`.
+		 */
+		void closest_to_positions(const LayoutInfo&, float textAreaWidth, TextXAlignment, const float* positions,
+				size_t count, HitTestResult* resultsOut) const;
 };
 
 }
-
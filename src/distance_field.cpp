@@ -0,0 +1,35 @@
+#include "distance_field.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace Text;
+
+Bitmap Text::make_stroke_from_distance_field(const DistanceField& field, float thickness, float* offsetOut) {
+	assert(thickness <= field.spread && "Stroke thickness must be within the distance field spread");
+
+	// The field is padded by its spread, so strokes thinner than the spread can be cropped
+	auto crop = static_cast<uint32_t>(std::max(0.f, std::floor(field.spread - thickness - 1.f)));
+	crop = std::min({crop, field.width / 2, field.height / 2});
+
+	auto width = field.width - 2 * crop;
+	auto height = field.height - 2 * crop;
+
+	offsetOut[0] = field.offset[0] + static_cast<float>(crop);
+	offsetOut[1] = field.offset[1] + static_cast<float>(crop);
+
+	Bitmap result(width, height);
+	auto* pDst = result.data();
+
+	for (uint32_t y = 0; y < height; ++y) {
+		auto* pSrc = field.distances.data() + static_cast<size_t>(y + crop) * field.width + crop;
+
+		for (uint32_t x = 0; x < width; ++x) {
+			auto coverage = std::clamp(thickness + 0.5f - std::abs(pSrc[x]), 0.f, 1.f);
+			*pDst++ = Color::to_argb({1.f, 1.f, 1.f, coverage});
+		}
+	}
+
+	return result;
+}
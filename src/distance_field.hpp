@@ -0,0 +1,46 @@
+#pragma once
+
+#include "bitmap.hpp"
+#include "stroke_type.hpp"
+
+#include <cstdint>
+
+#include <vector>
+
+namespace Text {
+
+/**
+ * A single-channel signed distance field of a glyph outline at a specific pixel size. Distances are in pixels,
+ * positive inside the glyph, and are exact up to `spread` pixels from the outline.
+ */
+struct DistanceField {
+	std::vector<float> distances;
+	uint32_t width;
+	uint32_t height;
+	float offset[2];
+	float spread;
+
+	constexpr bool empty() const {
+		return width == 0 || height == 0;
+	}
+};
+
+// Maximum stroke thickness in pixels served from distance fields, thicker strokes use FT_Stroker
+inline constexpr const float STROKE_FIELD_SPREAD = 8.f;
+
+/**
+ * Whether strokes of this thickness and join type are derived from a glyph distance field rather than rasterized
+ * with `FontData::rasterize_glyph_outline`. Miter and bevel joins need the exact stroker geometry.
+ */
+constexpr bool stroke_uses_distance_field(uint8_t thickness, StrokeType type) {
+	return type == StrokeType::ROUND && static_cast<float>(thickness) <= STROKE_FIELD_SPREAD;
+}
+
+/**
+ * Derives a stroke coverage bitmap centered on the outline with a round join and cap, equivalent to stroking the
+ * outline with `FT_Stroker` using a radius of `thickness` pixels. `thickness` must not exceed the field's spread.
+ * The result is cropped to the stroke and `offsetOut` receives its position relative to the glyph origin.
+ */
+[[nodiscard]] Bitmap make_stroke_from_distance_field(const DistanceField& field, float thickness, float* offsetOut);
+
+}
@@ -0,0 +1,120 @@
+#include "executor.hpp"
+
+#include <algorithm>
+
+using namespace Text;
+
+static Executor* g_executor{};
+
+// Public Functions
+
+uint32_t SerialExecutor::get_worker_count() const {
+	return 1;
+}
+
+void SerialExecutor::submit(TaskGroup&, std::function<void()> task) {
+	task();
+}
+
+void SerialExecutor::wait(TaskGroup&) {}
+
+ThreadPoolExecutor::ThreadPoolExecutor(uint32_t threadCount) {
+	if (threadCount == 0) {
+		threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+	}
+
+	m_threads.reserve(threadCount);
+
+	for (uint32_t i = 0; i < threadCount; ++i) {
+		m_threads.emplace_back(&ThreadPoolExecutor::thread_main, this);
+	}
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor() {
+	{
+		std::scoped_lock lock(m_mutex);
+		m_stopping = true;
+	}
+
+	m_taskSignal.notify_all();
+
+	for (auto& thread : m_threads) {
+		thread.join();
+	}
+}
+
+uint32_t ThreadPoolExecutor::get_worker_count() const {
+	return static_cast<uint32_t>(m_threads.size()) + 1;
+}
+
+void ThreadPoolExecutor::submit(TaskGroup& group, std::function<void()> task) {
+	group.add_pending();
+
+	{
+		std::scoped_lock lock(m_mutex);
+		m_queue.push_back({&group, std::move(task)});
+	}
+
+	m_taskSignal.notify_one();
+}
+
+void ThreadPoolExecutor::wait(TaskGroup& group) {
+	std::unique_lock lock(m_mutex);
+
+	while (!group.is_done()) {
+		// Help only with the group's own queued tasks, other groups may hold long running work such as background
+		// layout that the waiting thread must not be stuck behind
+		auto it = std::find_if(m_queue.begin(), m_queue.end(),
+				[&](const QueuedTask& queuedTask) { return queuedTask.pGroup == &group; });
+
+		if (it != m_queue.end()) {
+			run_task_locked(lock, it);
+		}
+		else {
+			m_finishSignal.wait(lock);
+		}
+	}
+}
+
+void Text::set_executor(Executor* executor) {
+	g_executor = executor;
+}
+
+Executor& Text::get_executor() {
+	if (g_executor) {
+		return *g_executor;
+	}
+
+	static ThreadPoolExecutor defaultExecutor;
+	return defaultExecutor;
+}
+
+// Private Methods
+
+void ThreadPoolExecutor::thread_main() {
+	std::unique_lock lock(m_mutex);
+
+	for (;;) {
+		m_taskSignal.wait(lock, [&] { return m_stopping || !m_queue.empty(); });
+
+		if (m_queue.empty()) {
+			break;
+		}
+
+		run_task_locked(lock, m_queue.begin());
+	}
+}
+
+void ThreadPoolExecutor::run_task_locked(std::unique_lock<std::mutex>& lock,
+		std::deque<QueuedTask>::iterator it) {
+	auto queuedTask = std::move(*it);
+	m_queue.erase(it);
+
+	lock.unlock();
+	queuedTask.task();
+	lock.lock();
+
+	// Finished under the lock, so a waiter cannot check the group between its check and its wait
+	queuedTask.pGroup->finish_pending();
+	m_finishSignal.notify_all();
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstdint>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Text {
+
+/**
+ * Counts the tasks submitted to an `Executor` that have not yet finished. Executors call `add_pending` when a task
+ * is submitted and `finish_pending` once it has run.
+ */
+class TaskGroup final {
+	public:
+		explicit TaskGroup() = default;
+
+		TaskGroup(TaskGroup&&) = delete;
+		void operator=(TaskGroup&&) = delete;
+
+		TaskGroup(const TaskGroup&) = delete;
+		void operator=(const TaskGroup&) = delete;
+
+		bool is_done() const {
+			return m_pending.load(std::memory_order_acquire) == 0;
+		}
+
+		void add_pending() {
+			m_pending.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void finish_pending() {
+			m_pending.fetch_sub(1, std::memory_order_release);
+		}
+	private:
+		std::atomic_uint32_t m_pending{};
+};
+
+/**
+ * Runs the library's parallel work, such as MSDF generation, glyph rasterization and background layout.
+ * Implement this to run that work on an engine's job system, and install it with `set_executor`.
+ */
+class Executor {
+	public:
+		virtual ~Executor() = default;
+
+		/**
+		 * Returns the number of tasks that can run at once, counting a thread waiting in `wait`. Parallel work is
+		 * split into at most this many tasks.
+		 */
+		virtual uint32_t get_worker_count() const = 0;
+
+		/**
+		 * Runs `task` as part of `group`, on any thread and possibly before returning.
+		 */
+		virtual void submit(TaskGroup& group, std::function<void()> task) = 0;
+
+		/**
+		 * Blocks until every task of `group` has finished. Implementations must be able to make progress on
+		 * `group` from the waiting thread, since tasks may wait on groups of their own.
+		 */
+		virtual void wait(TaskGroup& group) = 0;
+};
+
+/**
+ * Runs every task on the submitting thread inside `submit`.
+ */
+class SerialExecutor final : public Executor {
+	public:
+		uint32_t get_worker_count() const override;
+		void submit(TaskGroup& group, std::function<void()> task) override;
+		void wait(TaskGroup& group) override;
+};
+
+/**
+ * A fixed set of threads sharing one queue. Threads waiting on a group run that group's queued tasks until the group
+ * is done, never tasks of other groups.
+ */
+class ThreadPoolExecutor final : public Executor {
+	public:
+		/**
+		 * @param threadCount The number of threads to start, or 0 to leave one hardware thread for the caller
+		 */
+		explicit ThreadPoolExecutor(uint32_t threadCount = 0);
+		~ThreadPoolExecutor() override;
+
+		ThreadPoolExecutor(ThreadPoolExecutor&&) = delete;
+		void operator=(ThreadPoolExecutor&&) = delete;
+
+		ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+		void operator=(const ThreadPoolExecutor&) = delete;
+
+		uint32_t get_worker_count() const override;
+		void submit(TaskGroup& group, std::function<void()> task) override;
+		void wait(TaskGroup& group) override;
+	private:
+		struct QueuedTask {
+			TaskGroup* pGroup;
+			std::function<void()> task;
+		};
+
+		std::mutex m_mutex;
+		std::condition_variable m_taskSignal;
+		std::condition_variable m_finishSignal;
+		std::deque<QueuedTask> m_queue;
+		std::vector<std::thread> m_threads;
+		bool m_stopping{};
+
+		void thread_main();
+		void run_task_locked(std::unique_lock<std::mutex>& lock, std::deque<QueuedTask>::iterator it);
+};
+
+/**
+ * Installs the executor used by all parallel work in the library, or restores the default `ThreadPoolExecutor`
+ * if `executor` is null. The executor must outlive its use by the library.
+ *
+ * @thread_safety Must be called before any parallel work starts and be externally synchronized.
+ */
+void set_executor(Executor* executor);
+
+/**
+ * Gets the installed executor, creating the default `ThreadPoolExecutor` on first use if none was installed.
+ *
+ * @thread_safety Thread safe.
+ */
+Executor& get_executor();
+
+/**
+ * Calls `func(workerIndex)` for each worker index below `workerCount`, with the calling thread acting as worker 0
+ * and the rest submitted to `executor`, and returns once every call has returned.
+ */
+template <typename Functor>
+void run_on_workers(Executor& executor, uint32_t workerCount, Functor&& func) {
+	TaskGroup group;
+
+	for (uint32_t i = 1; i < workerCount; ++i) {
+		executor.submit(group, [&func, i] { func(i); });
+	}
+
+	func(0);
+
+	executor.wait(group);
+}
+
+}
@@ -8,6 +8,8 @@
 
 #include <msdfgen.h>
 
+#include <cmath>
+
 using namespace Text;
 
 static constexpr bool USE_MSDF_ERROR_CORRECTION = false;
@@ -19,17 +21,35 @@ struct OutlineContext {
 	msdfgen::Point2 position;
 	msdfgen::Shape* pShape;
 	msdfgen::Contour* pContour;
+	double coordScale;
+};
+
+struct MSDFScratch {
+	msdfgen::Shape shape;
+	std::vector<float> pixels;
 };
 
 }
 
+static thread_local MSDFScratch t_msdfScratch;
+
 static int msdf_move_to(const FT_Vector* to, void* userData);
 static int msdf_line_to(const FT_Vector* to, void* userData);
 static int msdf_conic_to(const FT_Vector* control, const FT_Vector* to, void* userData);
 static int msdf_cubic_to(const FT_Vector* control1, const FT_Vector* control2, const FT_Vector* to,
 		void* userData);
 
-static Bitmap load_msdf_shape(msdfgen::Shape& shape, FT_Outline& outline, float scaleX, float scaleY);
+static constexpr float saturate(float v) {
+	return v < 0.f ? 0.f : (v > 1.f ? 1.f : v);
+}
+
+static Bitmap load_msdf_shape(FT_Outline& outline, double coordScale, float* offsetOut);
+static bool generate_msdf(FT_Outline& outline, double coordScale, uint32_t& widthOut, uint32_t& heightOut,
+		float* offsetOut);
+static bool build_msdf_shape(FT_Outline& outline, double coordScale);
+static bool get_shape_bitmap_area(double padding, double& leftOut, double& bottomOut, int32_t& widthOut,
+		int32_t& heightOut);
+static double get_msdf_em_scale(FT_Face face);
 
 float FontData::get_ascent() const {
 	return static_cast<float>(ftFace->size->metrics.ascender) / 64.f;
@@ -61,6 +81,14 @@ float FontData::get_scale_y() const {
 	return static_cast<float>(metrics.y_ppem) / static_cast<float>(ftFace->units_per_EM);
 }
 
+bool FontData::has_color_glyphs() const {
+	return FT_HAS_COLOR(ftFace);
+}
+
+bool FontData::is_fixed_width() const {
+	return FT_IS_FIXED_WIDTH(ftFace);
+}
+
 bool FontData::has_codepoint(uint32_t codepoint) const {
 	hb_codepoint_t tmp;
 	return hb_font_get_nominal_glyph(hbFont, codepoint, &tmp);
@@ -108,25 +136,17 @@ FontGlyphResult FontData::rasterize_glyph(uint32_t glyph, float* offsetOut) cons
 		.hasColor = false,
 	};
 	auto* buffer = ftFace->glyph->bitmap.buffer;
+	auto pitch = static_cast<size_t>(ftFace->glyph->bitmap.pitch);
 
 	switch (ftFace->glyph->bitmap.pixel_mode) {
 		case FT_PIXEL_MODE_GRAY:
-			for (uint32_t y = 0, i = 0; y < uHeight; ++y) {
-				for (uint32_t x = 0; x < uWidth; ++x, ++i) {
-					auto alpha = static_cast<float>(buffer[i]) / 255.f;
-					result.bitmap.set_pixel(x, y, {1.f, 1.f, 1.f, alpha});
-				}
+			for (uint32_t y = 0; y < uHeight; ++y) {
+				Bitmap::convert_a8_to_argb(buffer + y * pitch, result.bitmap.data() + y * uWidth, uWidth);
 			}
 			break;
 		case FT_PIXEL_MODE_BGRA:
-			for (uint32_t y = 0, i = 0; y < uHeight; ++y) {
-				for (uint32_t x = 0; x < uWidth; ++x, i += 4) {
-					auto b = static_cast<float>(buffer[i]) / 255.f;
-					auto g = static_cast<float>(buffer[i + 1]) / 255.f;
-					auto r = static_cast<float>(buffer[i + 2]) / 255.f;
-					auto a = static_cast<float>(buffer[i + 3]) / 255.f;
-					result.bitmap.set_pixel(x, y, {r / a, g / a, b / a, a});
-				}
+			for (uint32_t y = 0; y < uHeight; ++y) {
+				Bitmap::convert_bgra_to_argb(buffer + y * pitch, result.bitmap.data() + y * uWidth, uWidth);
 			}
 
 			result.hasColor = true;
@@ -173,17 +193,15 @@ FontGlyphResult FontData::rasterize_glyph_outline(uint32_t glyphIndex, uint8_t t
 	auto uWidth = static_cast<uint32_t>(bmpGlyph->bitmap.width);
 	auto uHeight = static_cast<uint32_t>(bmpGlyph->bitmap.rows);
 	auto* buffer = bmpGlyph->bitmap.buffer;
+	auto pitch = static_cast<size_t>(bmpGlyph->bitmap.pitch);
 
 	FontGlyphResult result{
 		.bitmap = Bitmap{uWidth, uHeight},
 		.hasColor = false,
 	};
 
-	for (uint32_t y = 0, i = 0; y < uHeight; ++y) {
-		for (uint32_t x = 0; x < uWidth; ++x, ++i) {
-			auto alpha = static_cast<float>(buffer[i]) / 255.f;
-			result.bitmap.set_pixel(x, y, {1.f, 1.f, 1.f, alpha});
-		}
+	for (uint32_t y = 0; y < uHeight; ++y) {
+		Bitmap::convert_a8_to_argb(buffer + y * pitch, result.bitmap.data() + y * uWidth, uWidth);
 	}
 
 	offsetOut[0] = static_cast<float>(bmpGlyph->left);
@@ -196,13 +214,74 @@ FontGlyphResult FontData::rasterize_glyph_outline(uint32_t glyphIndex, uint8_t t
 }
 
 Bitmap FontData::get_msdf_glyph(uint32_t glyphIndex, float* offsetOut) const {
-	//FT_Load_Glyph(ftFace, glyphIndex, FT_LOAD_NO_SCALE);
-	FT_Load_Glyph(ftFace, glyphIndex, FT_LOAD_BITMAP_METRICS_ONLY);
-	msdfgen::Shape shape{};
-	offsetOut[0] = static_cast<float>(ftFace->glyph->bitmap_left);
-	offsetOut[1] = static_cast<float>(-ftFace->glyph->bitmap_top);
+	FT_Load_Glyph(ftFace, glyphIndex, FT_LOAD_NO_SCALE);
+	auto result = load_msdf_shape(ftFace->glyph->outline, get_msdf_em_scale(ftFace), offsetOut);
+	offsetOut[0] /= MSDF_EM_SIZE;
+	offsetOut[1] /= MSDF_EM_SIZE;
+
+	return result;
+}
+
+void FontData::get_msdf_glyph_rgb8(uint32_t glyphIndex, std::vector<uint8_t>& output, uint32_t& widthOut,
+		uint32_t& heightOut, float* offsetOut) const {
+	FT_Load_Glyph(ftFace, glyphIndex, FT_LOAD_NO_SCALE);
+
+	if (!generate_msdf(ftFace->glyph->outline, get_msdf_em_scale(ftFace), widthOut, heightOut, offsetOut)) {
+		widthOut = heightOut = 0;
+		offsetOut[0] = offsetOut[1] = 0.f;
+		return;
+	}
+
+	offsetOut[0] /= MSDF_EM_SIZE;
+	offsetOut[1] /= MSDF_EM_SIZE;
+
+	auto pixelCount = static_cast<size_t>(widthOut) * heightOut;
+	auto outputStart = output.size();
+	output.resize(outputStart + 3 * pixelCount);
+
+	auto* pSrc = t_msdfScratch.pixels.data();
+	auto* pDst = output.data() + outputStart;
+
+	for (size_t i = 0; i < 3 * pixelCount; ++i) {
+		pDst[i] = static_cast<uint8_t>(static_cast<uint32_t>(saturate(pSrc[i]) * 255.f) & 0xFFu);
+	}
+}
+
+DistanceField FontData::get_glyph_distance_field(uint32_t glyphIndex, float spread) const {
+	FT_Load_Glyph(ftFace, glyphIndex, FT_LOAD_NO_BITMAP);
+
+	double left, bottom;
+	int32_t width, height;
+	auto padding = static_cast<double>(spread) + 1.0;
+
+	if (ftFace->glyph->format != FT_GLYPH_FORMAT_OUTLINE
+			|| !build_msdf_shape(ftFace->glyph->outline, 1.0 / 64.0)
+			|| !get_shape_bitmap_area(padding, left, bottom, width, height)) {
+		return {.spread = spread};
+	}
+
+	DistanceField result{
+		.distances = std::vector<float>(static_cast<size_t>(width) * static_cast<size_t>(height)),
+		.width = static_cast<uint32_t>(width),
+		.height = static_cast<uint32_t>(height),
+		.offset = {static_cast<float>(left), static_cast<float>(-(bottom + height))},
+		.spread = spread,
+	};
+
+	auto range = 2.0 * static_cast<double>(spread);
+	msdfgen::Projection projection{msdfgen::Vector2{1.0}, msdfgen::Vector2{-left, -bottom}};
+	msdfgen::BitmapRef<float, 1> bmp(result.distances.data(), width, height);
 
-	return load_msdf_shape(shape, ftFace->glyph->outline, 1.f, 1.f);
+	msdfgen::GeneratorConfig generatorConfig{};
+	generatorConfig.overlapSupport = true;
+	msdfgen::generateSDF(bmp, t_msdfScratch.shape, projection, range, generatorConfig);
+
+	// Convert from the normalized [0, 1] range to pixels
+	for (auto& distance : result.distances) {
+		distance = static_cast<float>((static_cast<double>(distance) - 0.5) * range);
+	}
+
+	return result;
 }
 
 Bitmap FontData::get_msdf_outline_glyph(uint32_t glyphIndex, uint8_t thickness, StrokeType type,
@@ -242,8 +321,7 @@ Bitmap FontData::get_msdf_outline_glyph(uint32_t glyphIndex, uint8_t thickness,
 
 	FT_Stroker_Export(stroker, &outline);
 
-	msdfgen::Shape shape{};
-	auto result = load_msdf_shape(shape, outline, 1.f, 1.f);
+	auto result = load_msdf_shape(outline, 1.0 / 64.0, offsetOut);
 
 	FT_Outline_Done(glyph->library, &outline);
 	FT_Stroker_Done(stroker);
@@ -254,15 +332,37 @@ Bitmap FontData::get_msdf_outline_glyph(uint32_t glyphIndex, uint8_t thickness,
 
 // Static Functions
 
-static constexpr float saturate(float v) {
-	return v < 0.f ? 0.f : (v > 1.f ? 1.f : v);
-}
-
 static constexpr Color msdf_make_color(const float* c) {
 	return {saturate(c[0]), saturate(c[1]), saturate(c[2]), 1.f};
 }
 
-static Bitmap load_msdf_shape(msdfgen::Shape& shape, FT_Outline& outline, float scaleX, float scaleY) {
+static Bitmap load_msdf_shape(FT_Outline& outline, double coordScale, float* offsetOut) {
+	uint32_t width, height;
+
+	if (!generate_msdf(outline, coordScale, width, height, offsetOut)) {
+		offsetOut[0] = offsetOut[1] = 0.f;
+		return {};
+	}
+
+	Bitmap result(width, height);
+	auto* pSrc = t_msdfScratch.pixels.data();
+	auto* pDst = result.data();
+
+	for (size_t i = 0, l = static_cast<size_t>(width) * height; i < l; ++i, pSrc += 3) {
+		pDst[i] = Color::to_argb(msdf_make_color(pSrc));
+	}
+
+	return result;
+}
+
+/**
+ * Decomposes `outline` into the thread's scratch shape. Outline coordinates are multiplied by `coordScale` to
+ * obtain pixels. Returns false if the outline has no edges.
+ */
+static bool build_msdf_shape(FT_Outline& outline, double coordScale) {
+	// Clearing frees each contour and its edges, only the capacity of the contour list itself is kept. Edge segments
+	// are heap allocated by msdfgen one by one either way, so reusing the edge lists would save little.
+	auto& shape = t_msdfScratch.shape;
 	shape.contours.clear();
 	shape.inverseYAxis = true;
 
@@ -275,6 +375,7 @@ static Bitmap load_msdf_shape(msdfgen::Shape& shape, FT_Outline& outline, float
 
 	OutlineContext ctx{
 		.pShape = &shape,
+		.coordScale = coordScale,
 	};
 
 	FT_Outline_Decompose(&outline, &funcs, &ctx);
@@ -283,20 +384,46 @@ static Bitmap load_msdf_shape(msdfgen::Shape& shape, FT_Outline& outline, float
 		shape.contours.pop_back();
 	}
 
-	if (shape.edgeCount() == 0) {
-		return {};
+	return shape.edgeCount() > 0;
+}
+
+/**
+ * Computes a whole-pixel bitmap area covering the scratch shape plus `padding` pixels on each side.
+ */
+static bool get_shape_bitmap_area(double padding, double& leftOut, double& bottomOut, int32_t& widthOut,
+		int32_t& heightOut) {
+	auto bounds = t_msdfScratch.shape.getBounds();
+	leftOut = std::floor(bounds.l - padding);
+	bottomOut = std::floor(bounds.b - padding);
+	widthOut = static_cast<int32_t>(std::ceil(bounds.r + padding) - leftOut);
+	heightOut = static_cast<int32_t>(std::ceil(bounds.t + padding) - bottomOut);
+
+	return widthOut > 0 && heightOut > 0;
+}
+
+/**
+ * Generates an MSDF into the thread's scratch buffer. Outline coordinates are multiplied by `coordScale` to
+ * obtain pixels. `offsetOut` receives the position of the bitmap's top left corner relative to the glyph origin,
+ * in pixels, with Y pointing down.
+ */
+static bool generate_msdf(FT_Outline& outline, double coordScale, uint32_t& widthOut, uint32_t& heightOut,
+		float* offsetOut) {
+	double left, bottom;
+	int32_t width, height;
+
+	if (!build_msdf_shape(outline, coordScale)
+			|| !get_shape_bitmap_area(static_cast<double>(MSDF_PADDING), left, bottom, width, height)) {
+		return false;
 	}
 
-	auto bounds = shape.getBounds();
-	auto width = static_cast<int32_t>((bounds.r - bounds.l + 2.0 * static_cast<double>(MSDF_PADDING))
-			* scaleX);
-	auto height = static_cast<int32_t>((bounds.t - bounds.b + 2.0 * static_cast<double>(MSDF_PADDING))
-			* scaleY);
+	auto& shape = t_msdfScratch.shape;
 
-	msdfgen::Vector2 scale{scaleX, scaleY};
-	msdfgen::Vector2 translate{static_cast<double>(MSDF_PADDING)};
+	msdfgen::Vector2 scale{1.0};
+	msdfgen::Vector2 translate{-left, -bottom};
 	msdfgen::Projection projection{scale, translate};
-	msdfgen::Bitmap<float, 3> bmp(width, height);
+
+	t_msdfScratch.pixels.resize(3 * static_cast<size_t>(width) * static_cast<size_t>(height));
+	msdfgen::BitmapRef<float, 3> bmp(t_msdfScratch.pixels.data(), width, height);
 
 	msdfgen::MSDFGeneratorConfig generatorConfig{};
 	generatorConfig.overlapSupport = true;
@@ -310,26 +437,28 @@ static Bitmap load_msdf_shape(msdfgen::Shape& shape, FT_Outline& outline, float
 
 	//msdfgen::edgeColoringSimple(shape, 3.0, 0);
 	msdfgen::edgeColoringInkTrap(shape, 3.0, 0);
-	msdfgen::generateMSDF(bmp, shape, projection, 2.0, generatorConfig);
+	msdfgen::generateMSDF(bmp, shape, projection, MSDF_PIXEL_RANGE, generatorConfig);
 
 	if constexpr (USE_MSDF_ERROR_CORRECTION) {
 		msdfgen::distanceSignCorrection(bmp, shape, projection);
-		msdfgen::msdfErrorCorrection(bmp, shape, projection, 2.0, postErrorCorrectionConfig);
+		msdfgen::msdfErrorCorrection(bmp, shape, projection, MSDF_PIXEL_RANGE, postErrorCorrectionConfig);
 	}
 
-	Bitmap result(width, height);
+	offsetOut[0] = static_cast<float>(left);
+	offsetOut[1] = static_cast<float>(-(bottom + height));
 
-	for (int32_t y = 0; y < height; ++y) {
-		for (int32_t x = 0; x < width; ++x) {
-			result.set_pixel(x, y, msdf_make_color(bmp(x, y)));
-		}
-	}
+	widthOut = static_cast<uint32_t>(width);
+	heightOut = static_cast<uint32_t>(height);
 
-	return result;
+	return true;
+}
+
+static double get_msdf_em_scale(FT_Face face) {
+	return static_cast<double>(MSDF_EM_SIZE) / static_cast<double>(face->units_per_EM);
 }
 
-static msdfgen::Point2 make_point2(const FT_Vector& v) {
-	return {scalbn(v.x, -6), scalbn(v.y, -6)};
+static msdfgen::Point2 make_point2(const FT_Vector& v, double coordScale) {
+	return {static_cast<double>(v.x) * coordScale, static_cast<double>(v.y) * coordScale};
 }
 
 static int msdf_move_to(const FT_Vector* to, void* userData) {
@@ -339,7 +468,7 @@ static int msdf_move_to(const FT_Vector* to, void* userData) {
 		ctx.pContour = &ctx.pShape->addContour();
 	}
 
-	ctx.position = make_point2(*to);
+	ctx.position = make_point2(*to, ctx.coordScale);
 
 	return 0;
 }
@@ -347,7 +476,7 @@ static int msdf_move_to(const FT_Vector* to, void* userData) {
 static int msdf_line_to(const FT_Vector* to, void* userData) {
 	auto& ctx = *reinterpret_cast<OutlineContext*>(userData);
 
-	if (auto endpoint = make_point2(*to); endpoint != ctx.position) {
+	if (auto endpoint = make_point2(*to, ctx.coordScale); endpoint != ctx.position) {
 		ctx.pContour->addEdge(new msdfgen::LinearSegment(ctx.position, endpoint));
 		ctx.position = endpoint;
 	}
@@ -357,18 +486,18 @@ static int msdf_line_to(const FT_Vector* to, void* userData) {
 
 static int msdf_conic_to(const FT_Vector* control, const FT_Vector* to, void* userData) {
 	auto& ctx = *reinterpret_cast<OutlineContext*>(userData);
-	ctx.pContour->addEdge(new msdfgen::QuadraticSegment(ctx.position, make_point2(*control),
-			make_point2(*to)));
-	ctx.position = make_point2(*to);
+	ctx.pContour->addEdge(new msdfgen::QuadraticSegment(ctx.position, make_point2(*control, ctx.coordScale),
+			make_point2(*to, ctx.coordScale)));
+	ctx.position = make_point2(*to, ctx.coordScale);
 	return 0;
 }
 
 static int msdf_cubic_to(const FT_Vector* control1, const FT_Vector* control2, const FT_Vector* to,
 		void* userData) {
 	auto& ctx = *reinterpret_cast<OutlineContext*>(userData);
-	ctx.pContour->addEdge(new msdfgen::CubicSegment(ctx.position, make_point2(*control1),
-			make_point2(*control2), make_point2(*to)));
-	ctx.position = make_point2(*to);
+	ctx.pContour->addEdge(new msdfgen::CubicSegment(ctx.position, make_point2(*control1, ctx.coordScale),
+			make_point2(*control2, ctx.coordScale), make_point2(*to, ctx.coordScale)));
+	ctx.position = make_point2(*to, ctx.coordScale);
 	return 0;
 }
 
@@ -1,13 +1,23 @@
 #pragma once
 
 #include "bitmap.hpp"
+#include "distance_field.hpp"
 #include "stroke_type.hpp"
 
+#include <vector>
+
 struct FT_FaceRec_;
 struct hb_font_t;
 
 namespace Text {
 
+/**
+ * Glyph MSDFs are generated from unscaled outlines normalized to `MSDF_EM_SIZE` pixels per em, with a distance
+ * range of `MSDF_PIXEL_RANGE` pixels, so a single MSDF serves every font size.
+ */
+inline constexpr const float MSDF_EM_SIZE = 32.f;
+inline constexpr const double MSDF_PIXEL_RANGE = 2.0;
+
 struct FontGlyphResult {
 	Bitmap bitmap;
 	bool hasColor;
@@ -52,6 +62,8 @@ struct FontData {
 	float get_scale_x() const;
 	float get_scale_y() const;
 
+	bool has_color_glyphs() const;
+	bool is_fixed_width() const;
 	bool has_codepoint(uint32_t codepoint) const;
 	uint32_t map_codepoint_to_glyph(uint32_t codepoint) const;
 
@@ -68,9 +80,28 @@ struct FontData {
 	FontGlyphResult rasterize_glyph_outline(uint32_t glyph, uint8_t thickness, StrokeType,
 			float* offsetOut) const;
 
+	/**
+	 * Generates a signed distance field of the glyph outline at the current size, exact up to `spread` pixels
+	 * outside and inside the outline. Strokes with round joins of any thickness up to `spread` can be derived
+	 * from it with `make_stroke_from_distance_field`.
+	 */
+	DistanceField get_glyph_distance_field(uint32_t glyphIndex, float spread) const;
+
+	/**
+	 * Generates a size-independent MSDF of the glyph at `MSDF_EM_SIZE` pixels per em. `offsetOut` receives the
+	 * offset of the bitmap's top left corner from the glyph origin in em units. Multiply the offset and the
+	 * bitmap's extents divided by `MSDF_EM_SIZE` by the font's pixels per em to draw it at a given size.
+	 */
 	Bitmap get_msdf_glyph(uint32_t glyphIndex, float* offsetOut) const;
 	Bitmap get_msdf_outline_glyph(uint32_t glyphIndex, uint8_t thickness, StrokeType,
 			float* offsetOut) const;
+
+	/**
+	 * Generates the same MSDF as `get_msdf_glyph`, appending it to `output` as `width * height` packed RGB8
+	 * pixels. Scratch shape and distance field storage is kept per thread and reused between calls.
+	 */
+	void get_msdf_glyph_rgb8(uint32_t glyphIndex, std::vector<uint8_t>& output, uint32_t& widthOut,
+			uint32_t& heightOut, float* offsetOut) const;
 };
 
 }
@@ -0,0 +1,275 @@
+#include "font_pack.hpp"
+
+#include "binary_search.hpp"
+#include "common.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#if defined(RICHTEXT_OPERATING_SYSTEM_LINUX) || defined(RICHTEXT_OPERATING_SYSTEM_MACOS)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace Text;
+
+static constexpr const uint32_t PACK_MAGIC = 0x50465452u; // 'RTFP'
+static constexpr const uint32_t PACK_FORMAT_VERSION = 1;
+
+static_assert(sizeof(FontPackHeader) == 16);
+static_assert(sizeof(FontPackEntry) == 24);
+
+static FileMapping g_packMapping{};
+static const FontPackEntry* g_pEntries{};
+static const char* g_pStringTable{};
+static uint32_t g_entryCount{};
+
+static FileMapping map_file_from_pack(std::string_view fileName);
+static void unmap_file_from_pack(const FileMapping& mapping);
+
+static const FontPackEntry* find_entry(std::string_view uri);
+static std::string_view get_entry_uri(const FontPackEntry& entry);
+
+static bool write_all(FILE* file, const void* data, size_t size);
+static bool write_padding(FILE* file, uint64_t size);
+static bool write_file_contents(FILE* file, const std::string& srcFileName, uint64_t size);
+
+// Public Functions
+
+bool FontPack::write(std::string_view fileName, const std::string_view* pURIs, size_t uriCount) {
+	std::vector<std::string_view> uris(pURIs, pURIs + uriCount);
+	std::sort(uris.begin(), uris.end());
+	uris.erase(std::unique(uris.begin(), uris.end()), uris.end());
+
+	std::vector<FontPackEntry> entries;
+	std::string stringTable;
+
+	// Only sizes are gathered up front, the files are streamed into the pack one at a time below
+	for (auto uri : uris) {
+		std::error_code err;
+		auto size = std::filesystem::file_size(std::filesystem::path(uri), err);
+
+		if (err || size == 0) {
+			return false;
+		}
+
+		entries.push_back({
+			.dataSize = size,
+			.uriOffset = static_cast<uint32_t>(stringTable.size()),
+			.uriLength = static_cast<uint32_t>(uri.size()),
+		});
+		stringTable += uri;
+	}
+
+	FontPackHeader header{
+		.magic = PACK_MAGIC,
+		.version = PACK_FORMAT_VERSION,
+		.entryCount = static_cast<uint32_t>(entries.size()),
+		.stringTableSize = static_cast<uint32_t>(stringTable.size()),
+	};
+
+	auto align = [](uint64_t offset) {
+		return (offset + FONT_PACK_ALIGNMENT - 1) & ~(FONT_PACK_ALIGNMENT - 1);
+	};
+
+	uint64_t dataOffset = align(sizeof(FontPackHeader) + entries.size() * sizeof(FontPackEntry)
+			+ stringTable.size());
+
+	for (auto& entry : entries) {
+		entry.dataOffset = dataOffset;
+		dataOffset = align(dataOffset + entry.dataSize);
+	}
+
+	auto tempFileName = std::string(fileName) + ".tmp";
+	FILE* file = std::fopen(tempFileName.c_str(), "wb");
+
+	if (!file) {
+		return false;
+	}
+
+	bool success = write_all(file, &header, sizeof(FontPackHeader))
+			&& write_all(file, entries.data(), entries.size() * sizeof(FontPackEntry))
+			&& write_all(file, stringTable.data(), stringTable.size());
+	uint64_t offset = sizeof(FontPackHeader) + entries.size() * sizeof(FontPackEntry) + stringTable.size();
+
+	for (size_t i = 0; i < entries.size() && success; ++i) {
+		success = write_padding(file, entries[i].dataOffset - offset)
+				&& write_file_contents(file, std::string(uris[i]), entries[i].dataSize);
+		offset = entries[i].dataOffset + entries[i].dataSize;
+	}
+
+	success = (std::fclose(file) == 0) && success;
+
+	if (!success) {
+		std::remove(tempFileName.c_str());
+		return false;
+	}
+
+	std::string fileNameString(fileName);
+	std::remove(fileNameString.c_str());
+
+	return std::rename(tempFileName.c_str(), fileNameString.c_str()) == 0;
+}
+
+bool FontPack::open(std::string_view fileName) {
+	auto mapping = map_file_default(fileName);
+
+	if (!mapping.mapping) {
+		return false;
+	}
+
+	FontPackHeader header{};
+
+	if (mapping.size >= sizeof(FontPackHeader)) {
+		std::memcpy(&header, mapping.mapping, sizeof(FontPackHeader));
+	}
+
+	auto* pBase = reinterpret_cast<const uint8_t*>(mapping.mapping);
+	auto indexSize = sizeof(FontPackHeader) + static_cast<uint64_t>(header.entryCount) * sizeof(FontPackEntry);
+
+	if (header.magic != PACK_MAGIC || header.version != PACK_FORMAT_VERSION
+			|| mapping.size < indexSize + header.stringTableSize) {
+		unmap_file_default(mapping);
+		return false;
+	}
+
+	auto* pEntries = reinterpret_cast<const FontPackEntry*>(pBase + sizeof(FontPackHeader));
+
+	for (uint32_t i = 0; i < header.entryCount; ++i) {
+		// Compared without adding the two, so that huge values cannot wrap around
+		if (pEntries[i].dataOffset > mapping.size || pEntries[i].dataSize > mapping.size - pEntries[i].dataOffset
+				|| static_cast<uint64_t>(pEntries[i].uriOffset) + pEntries[i].uriLength > header.stringTableSize) {
+			unmap_file_default(mapping);
+			return false;
+		}
+	}
+
+	close();
+
+	g_packMapping = mapping;
+	g_pEntries = pEntries;
+	g_pStringTable = reinterpret_cast<const char*>(pBase + indexSize);
+	g_entryCount = header.entryCount;
+
+	return true;
+}
+
+void FontPack::close() {
+	if (g_packMapping.mapping) {
+		unmap_file_default(g_packMapping);
+	}
+
+	g_packMapping = {};
+	g_pEntries = nullptr;
+	g_pStringTable = nullptr;
+	g_entryCount = 0;
+}
+
+FileMappingFunctions FontPack::get_file_mapping_functions() {
+	return {
+		.pfnMapFile = map_file_from_pack,
+		.pfnUnmapFile = unmap_file_from_pack,
+	};
+}
+
+void FontPack::prefetch(std::string_view uri) {
+#if defined(RICHTEXT_OPERATING_SYSTEM_LINUX) || defined(RICHTEXT_OPERATING_SYSTEM_MACOS)
+	if (auto* pEntry = find_entry(uri)) {
+		// Blobs are aligned to `FONT_PACK_ALIGNMENT`, which is smaller than the page size on 16K and 64K page
+		// kernels, so round out to whole pages. The hint is best effort, a failure is not worth reporting.
+		static const auto pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+		auto start = reinterpret_cast<uintptr_t>(g_packMapping.mapping) + pEntry->dataOffset;
+		auto pageStart = start & ~(pageSize - 1);
+		auto pageEnd = (start + pEntry->dataSize + pageSize - 1) & ~(pageSize - 1);
+
+		posix_madvise(reinterpret_cast<void*>(pageStart), pageEnd - pageStart, POSIX_MADV_WILLNEED);
+	}
+#else
+	(void)uri;
+#endif
+}
+
+// Static Functions
+
+// Ranges of the pack are marked by a `handle` pointing at the pack mapping, so unmapping knows to leave them be
+static FileMapping map_file_from_pack(std::string_view fileName) {
+	if (auto* pEntry = find_entry(fileName)) {
+		return {
+			.mapping = reinterpret_cast<const uint8_t*>(g_packMapping.mapping) + pEntry->dataOffset,
+			.size = pEntry->dataSize,
+			.handle = &g_packMapping,
+		};
+	}
+
+	return map_file_default(fileName);
+}
+
+static void unmap_file_from_pack(const FileMapping& mapping) {
+	if (mapping.handle != &g_packMapping) {
+		unmap_file_default(mapping);
+	}
+}
+
+static const FontPackEntry* find_entry(std::string_view uri) {
+	auto index = binary_search(0, g_entryCount, [&](auto i) {
+		return get_entry_uri(g_pEntries[i]) < uri;
+	});
+
+	if (index < g_entryCount && get_entry_uri(g_pEntries[index]) == uri) {
+		return &g_pEntries[index];
+	}
+
+	return nullptr;
+}
+
+static std::string_view get_entry_uri(const FontPackEntry& entry) {
+	return std::string_view(g_pStringTable + entry.uriOffset, entry.uriLength);
+}
+
+static bool write_all(FILE* file, const void* data, size_t size) {
+	return size == 0 || std::fwrite(data, 1, size, file) == size;
+}
+
+static bool write_padding(FILE* file, uint64_t size) {
+	static constexpr const char ZEROES[256]{};
+
+	while (size > 0) {
+		auto chunk = std::min<uint64_t>(size, sizeof(ZEROES));
+
+		if (!write_all(file, ZEROES, chunk)) {
+			return false;
+		}
+
+		size -= chunk;
+	}
+
+	return true;
+}
+
+static bool write_file_contents(FILE* file, const std::string& srcFileName, uint64_t size) {
+	FILE* srcFile = std::fopen(srcFileName.c_str(), "rb");
+
+	if (!srcFile) {
+		return false;
+	}
+
+	char buffer[65536];
+	bool success = true;
+
+	while (size > 0 && success) {
+		auto chunk = static_cast<size_t>(std::min<uint64_t>(size, sizeof(buffer)));
+		success = std::fread(buffer, 1, chunk, srcFile) == chunk && write_all(file, buffer, chunk);
+		size -= chunk;
+	}
+
+	// A file that grew since its size was taken would no longer match its entry
+	success = success && std::fgetc(srcFile) == EOF;
+	std::fclose(srcFile);
+
+	return success;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "file_mapping.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string_view>
+
+namespace Text {
+
+/**
+ * Font blobs in a pack start on 4K page boundaries, so each face's range can be prefetched on its own and font
+ * tables keep their natural alignment. On kernels with larger pages, prefetching rounds out to whole pages.
+ */
+inline constexpr const uint64_t FONT_PACK_ALIGNMENT = 4096;
+
+/**
+ * A single file holding every font file a program ships. Layout is a `FontPackHeader`, `entryCount`
+ * `FontPackEntry` records sorted by URI, the URI string table, then the font blobs.
+ */
+struct FontPackHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t stringTableSize;
+};
+
+struct FontPackEntry {
+	uint64_t dataOffset;
+	uint64_t dataSize;
+	// Offset into the string table
+	uint32_t uriOffset;
+	uint32_t uriLength;
+};
+
+}
+
+namespace Text::FontPack {
+
+/**
+ * Writes the font files at `pURIs` into a pack at `fileName`. Each file is stored under its URI as given, which
+ * is what `FontFaceCreateInfo::uri` must match when loading from the pack. Files are streamed into the pack one
+ * at a time rather than loaded into memory together. Returns false on I/O failure.
+ */
+bool write(std::string_view fileName, const std::string_view* pURIs, size_t uriCount);
+
+/**
+ * Maps the pack at `fileName` once. While a pack is open, the functions from `get_file_mapping_functions` serve
+ * URIs found in the pack as ranges of the single mapping. Returns false if the file is missing or not a valid pack.
+ *
+ * @thread_safety Must be called before any font family is registered and be externally synchronized.
+ */
+bool open(std::string_view fileName);
+
+/**
+ * Unmaps the open pack, if any. URIs from it are no longer served by the functions from
+ * `get_file_mapping_functions`.
+ *
+ * @thread_safety Must be called once no face loaded from the pack is registered and be externally synchronized.
+ */
+void close();
+
+/**
+ * File mapping functions for `FontRegistry::set_file_mapping_functions`. URIs not in the open pack fall back to
+ * `map_file_default`.
+ */
+FileMappingFunctions get_file_mapping_functions();
+
+/**
+ * Hints the OS to read the font at `uri` into the page cache ahead of use, for faces known to be needed at
+ * startup. Does nothing if `uri` is not in the open pack or the platform has no such hint.
+ *
+ * @thread_safety Thread safe once `open` has returned.
+ */
+void prefetch(std::string_view uri);
+
+}
@@ -1,19 +1,26 @@
 #include "font_registry.hpp"
 
+#include "codepoint_set.hpp"
 #include "string_hash.hpp"
 #include "file_read_bytes.hpp"
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include FT_TRUETYPE_TABLES_H
+#include FT_MULTIPLE_MASTERS_H
+#include FT_MODULE_H
 
 #include <hb-ft.h>
 
 #include <unicode/utext.h>
 
 #include <cassert>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
 
+#include <algorithm>
+#include <atomic>
 #include <bitset>
 #include <mutex>
 #include <shared_mutex>
@@ -29,12 +36,21 @@ namespace {
 
 struct FaceData {
 	std::string name;
+	// The first face registered with a URI owns its mapping and coverage, later faces with that URI refer to it
+	FaceIndex_T source{FontFace::INVALID_FACE};
 	FileMapping mapping{};
+	// Codepoints mapped by the face's cmap, extracted once at registration. Faces at another index of their source's
+	// collection file extract their own
+	CodepointSet coverage;
+	uint32_t faceIndex{};
+	uint32_t namedInstance{};
+	std::vector<FontVariation> variations;
+	uint64_t contentHash{};
 
 	FaceData() = default;
-	FaceData(std::string&& nameIn, FileMapping&& mappingIn)
+	FaceData(std::string&& nameIn, FaceIndex_T sourceIn)
 			: name(nameIn)
-			, mapping(mappingIn) {}
+			, source(sourceIn) {}
 
 	FaceData(FaceData&& other) noexcept {
 		*this = std::move(other);
@@ -42,7 +58,13 @@ struct FaceData {
 
 	FaceData& operator=(FaceData&& other) noexcept {
 		std::swap(name, other.name);
+		std::swap(source, other.source);
 		std::swap(mapping, other.mapping);
+		std::swap(coverage, other.coverage);
+		std::swap(faceIndex, other.faceIndex);
+		std::swap(namedInstance, other.namedInstance);
+		std::swap(variations, other.variations);
+		std::swap(contentHash, other.contentHash);
 		return *this;
 	}
 
@@ -57,6 +79,7 @@ struct FamilyData {
 	std::vector<FontFamily> linkedFamilies;
 	std::vector<FontFamily> fallbackFamilies;
 	std::bitset<USCRIPT_CODE_LIMIT> scripts;
+	bool monospace{};
 	bool initialized{};
 
 	FontFace get_face(FontWeight weight, FontStyle style) const {
@@ -71,7 +94,11 @@ struct FamilyData {
 struct FontDataOwner {
 	FT_Face ftFace{};
 	hb_font_t* hbFont{};
+	hb_font_t* hbFontUnscaled{};
 	uint32_t size{};
+	// Global frame and per-thread use order of the last `get_font_data` call, for `FontRegistry::trim`
+	uint64_t lastUsedFrame{};
+	uint64_t lastUse{};
 	int16_t strikethroughPosition;
 	int16_t strikethroughThickness;
 
@@ -97,6 +124,10 @@ struct FontDataOwner {
 	FontDataOwner& operator=(FontDataOwner&& other) noexcept {
 		std::swap(ftFace, other.ftFace);
 		std::swap(hbFont, other.hbFont);
+		std::swap(hbFontUnscaled, other.hbFontUnscaled);
+		std::swap(size, other.size);
+		lastUsedFrame = other.lastUsedFrame;
+		lastUse = other.lastUse;
 		strikethroughPosition = other.strikethroughPosition;
 		strikethroughThickness = other.strikethroughThickness;
 		return *this;
@@ -113,12 +144,29 @@ struct FontDataOwner {
 		if (hbFont) {
 			hb_font_destroy(hbFont);
 		}
+
+		if (hbFontUnscaled) {
+			hb_font_destroy(hbFontUnscaled);
+		}
 	}
 
 	operator FontData() const {
 		return {ftFace, hbFont, strikethroughPosition, strikethroughThickness};
 	}
 
+	hb_font_t* get_unscaled_font() {
+		if (!hbFontUnscaled) {
+			// `hb_font_create` defaults to the face's units-per-em scale and HarfBuzz's own unhinted font functions
+			hbFontUnscaled = hb_font_create(hb_font_get_face(hbFont));
+
+			unsigned coordCount;
+			auto* pCoords = hb_font_get_var_coords_normalized(hbFont, &coordCount);
+			hb_font_set_var_coords_normalized(hbFontUnscaled, pCoords, coordCount);
+		}
+
+		return hbFontUnscaled;
+	}
+
 	void resize(uint32_t newSize) {
 		if (size == newSize) {
 			return;
@@ -136,16 +184,87 @@ struct FontDataOwner {
 };
 
 struct FontContext {
-	FT_Library lib;
+	FT_MemoryRec_ memory{};
+	FT_Library lib{};
 	std::unordered_map<FaceIndex_T, FontDataOwner> cache;
+	// Bytes currently allocated by this thread's FreeType library, including every face opened through it
+	size_t memoryUsage{};
+	uint64_t useCounter{};
 
-	explicit FontContext() {
-		FT_Init_FreeType(&lib);
-	}
+	FontContext() = default;
 
 	~FontContext() {
-		cache.clear();
-		FT_Done_FreeType(lib);
+		release();
+	}
+
+	FontContext(const FontContext&) = delete;
+	void operator=(const FontContext&) = delete;
+
+	// The library is created on first use so threads that never load a face, or that released their data, hold none
+	FT_Library get_library() {
+		if (!lib) {
+			memory = {
+				.user = this,
+				.alloc = ft_alloc,
+				.free = ft_free,
+				.realloc = ft_realloc,
+			};
+
+			FT_New_Library(&memory, &lib);
+			FT_Add_Default_Modules(lib);
+			FT_Set_Default_Properties(lib);
+		}
+
+		return lib;
+	}
+
+	void release() {
+		// Faces must be closed before the library that owns them
+		decltype(cache){}.swap(cache);
+
+		if (lib) {
+			FT_Done_Library(lib);
+			lib = nullptr;
+		}
+	}
+
+	// FreeType does not pass the block size to `free`, so each block is prefixed with its size
+	static void* ft_alloc(FT_Memory memory, long size) {
+		auto* block = static_cast<std::max_align_t*>(std::malloc(sizeof(std::max_align_t) + size));
+
+		if (!block) {
+			return nullptr;
+		}
+
+		*reinterpret_cast<size_t*>(block) = static_cast<size_t>(size);
+		static_cast<FontContext*>(memory->user)->memoryUsage += static_cast<size_t>(size);
+
+		return block + 1;
+	}
+
+	static void ft_free(FT_Memory memory, void* ptr) {
+		if (!ptr) {
+			return;
+		}
+
+		auto* block = static_cast<std::max_align_t*>(ptr) - 1;
+		static_cast<FontContext*>(memory->user)->memoryUsage -= *reinterpret_cast<size_t*>(block);
+		std::free(block);
+	}
+
+	static void* ft_realloc(FT_Memory memory, long curSize, long newSize, void* ptr) {
+		auto* block = ptr ? static_cast<std::max_align_t*>(ptr) - 1 : nullptr;
+		auto* newBlock = static_cast<std::max_align_t*>(std::realloc(block, sizeof(std::max_align_t) + newSize));
+
+		if (!newBlock) {
+			return nullptr;
+		}
+
+		auto& usage = static_cast<FontContext*>(memory->user)->memoryUsage;
+		usage = usage - static_cast<size_t>(curSize) + static_cast<size_t>(newSize);
+		*reinterpret_cast<size_t*>(newBlock) = static_cast<size_t>(newSize);
+
+		return newBlock + 1;
 	}
 };
 
@@ -155,8 +274,11 @@ thread_local FontContext t_fontContext;
 
 static std::shared_mutex g_mutex;
 
+static std::atomic<uint64_t> g_frame{};
+
 static std::vector<FaceData> g_faces;
 static std::unordered_map<std::string, FontFace, StringHash, std::equal_to<>> g_facesByName;
+static std::unordered_map<std::string, FontFace, StringHash, std::equal_to<>> g_facesByURI;
 
 static std::vector<FamilyData> g_familyData;
 static std::unordered_map<std::string, FontFamily, StringHash, std::equal_to<>> g_familiesByName;
@@ -181,7 +303,18 @@ static FontFace get_or_add_face(const FontFaceCreateInfo& faceInfo);
 static FontFace get_font_for_script(FontFamily family, FontWeight weight, FontStyle style,
 		UScriptCode script);
 static FontFace find_compatible_font(Text::Font font, uint32_t codepoint, FontFace baseFont,
-		const std::vector<FontFamily>& fallbackFamilies, FontData& fontData);
+		const std::vector<FontFamily>& fallbackFamilies);
+static bool face_covers(FontFace face, uint32_t codepoint);
+static FontData mark_used(FontDataOwner& owner);
+
+static void apply_variations(FT_Face ftFace, uint32_t namedInstance, const std::vector<FontVariation>& variations);
+
+static CodepointSet build_face_coverage(const FileMapping& mapping, uint32_t faceIndex);
+
+static uint64_t hash_file_contents(const void* data, size_t size);
+static uint64_t mix_hash(uint64_t value);
+static uint64_t hash_instance(uint64_t hash, uint32_t faceIndex, uint32_t namedInstance,
+		const FontVariation* pVariations, size_t variationCount);
 
 // Public Functions
 
@@ -213,12 +346,13 @@ FontData FontRegistry::get_font_data(SingleScriptFont font) {
 }
 
 FontData FontRegistry::get_font_data(FontFace face, uint32_t size) {
+	assert(face.valid() && "get_font_data(): Must pass valid face");
+
 	if (auto it = t_fontContext.cache.find(face.handle); it != t_fontContext.cache.end()) {
 		it->second.resize(size);
-		return it->second;
+		return mark_used(it->second);
 	}
 
-	assert(face.valid() && "get_font_data(): Must pass valid face");
 	assert(size > 0 && "get_font_data(): Must pass valid size");
 
 	FontData fontData{};
@@ -226,8 +360,11 @@ FontData FontRegistry::get_font_data(FontFace face, uint32_t size) {
 	g_mutex.lock_shared();
 
 	auto& faceData = g_faces[face.handle];
-	auto* fileData = faceData.mapping.mapping;
-	auto fileSize = faceData.mapping.size;
+	auto* fileData = g_faces[faceData.source].mapping.mapping;
+	auto fileSize = g_faces[faceData.source].mapping.size;
+	auto faceIndex = faceData.faceIndex;
+	auto namedInstance = faceData.namedInstance;
+	auto variations = faceData.variations;
 
 	g_mutex.unlock_shared();
 
@@ -235,11 +372,17 @@ FontData FontRegistry::get_font_data(FontFace face, uint32_t size) {
 		return {};
 	}
 
-	if (FT_New_Memory_Face(t_fontContext.lib, reinterpret_cast<const FT_Byte*>(fileData), fileSize, 0,
+	if (FT_New_Memory_Face(t_fontContext.get_library(), reinterpret_cast<const FT_Byte*>(fileData), fileSize,
+			static_cast<FT_Long>(faceIndex),
 			&fontData.ftFace) != 0) {
 		return {};
 	}
 
+	// Each instance gets a face of its own over the shared mapping, so selecting it happens once here
+	if (FT_HAS_MULTIPLE_MASTERS(fontData.ftFace)) {
+		apply_variations(fontData.ftFace, namedInstance, variations);
+	}
+
 	fontData.hbFont = hb_ft_font_create(fontData.ftFace, nullptr);
 
 	if (!fontData.hbFont) {
@@ -259,9 +402,75 @@ FontData FontRegistry::get_font_data(FontFace face, uint32_t size) {
 		fontData.strikethroughThickness = pOS2Table->yStrikeoutSize;
 	}
 
-	t_fontContext.cache.emplace(std::make_pair(face.handle, FontDataOwner(fontData, size)));
+	auto& owner = t_fontContext.cache.emplace(std::make_pair(face.handle, FontDataOwner(fontData, size)))
+			.first->second;
+
+	return mark_used(owner);
+}
+
+hb_font_t* FontRegistry::get_unscaled_font(SingleScriptFont font) {
+	if (!get_font_data(font)) {
+		return nullptr;
+	}
+
+	return t_fontContext.cache.find(font.face.handle)->second.get_unscaled_font();
+}
+
+bool FontRegistry::is_monospace(Font font) {
+	assert(font.valid() && "is_monospace(): Must pass valid Font");
+
+	{
+		std::shared_lock lock(g_mutex);
+
+		if (g_familyData[font.get_family().handle].monospace) {
+			return true;
+		}
+	}
+
+	auto fontData = get_font_data(font);
+	return fontData && fontData.is_fixed_width();
+}
+
+bool FontRegistry::has_codepoint(FontFace face, uint32_t codepoint) {
+	std::shared_lock lock(g_mutex);
+	return face_covers(face, codepoint);
+}
+
+uint64_t FontRegistry::get_face_content_hash(FontFace face) {
+	assert(face.valid() && "get_face_content_hash(): Must pass valid face");
+
+	const void* fileData;
+	size_t fileSize;
+	FaceIndex_T source;
+
+	{
+		std::shared_lock lock(g_mutex);
+		auto& faceData = g_faces[face.handle];
+		source = faceData.source;
+
+		if (faceData.contentHash != 0 || !g_faces[source].mapping.mapping) {
+			return faceData.contentHash;
+		}
+
+		fileData = g_faces[source].mapping.mapping;
+		fileSize = g_faces[source].mapping.size;
+	}
+
+	// Mappings stay alive until program termination, so hashing can happen outside of the lock
+	auto hash = hash_file_contents(fileData, fileSize);
+
+	std::unique_lock lock(g_mutex);
+
+	// Faces of a collection and instances of a variable font share a file but not their glyphs
+	if (auto& faceData = g_faces[face.handle]; faceData.faceIndex != 0 || faceData.namedInstance != 0
+			|| !faceData.variations.empty()) {
+		hash = hash_instance(hash, faceData.faceIndex, faceData.namedInstance, faceData.variations.data(),
+				faceData.variations.size());
+	}
 
-	return fontData;
+	g_faces[face.handle].contentHash = hash;
+
+	return hash;
 }
 
 FontRegistryError FontRegistry::register_family(const FontFamilyCreateInfo& familyInfo) {
@@ -334,6 +543,7 @@ FontRegistryError FontRegistry::register_family(const FontFamilyCreateInfo& fami
 		}
 	}
 
+	g_familyData[family.handle].monospace = familyInfo.monospace;
 	g_familyData[family.handle].initialized = true;
 	return FontRegistryError::NONE;
 }
@@ -354,6 +564,64 @@ SingleScriptFont FontRegistry::get_sub_font(Text::Font font, const char16_t* tex
 	return get_sub_font(font, iter, offset, limit, script);
 }
 
+void FontRegistry::advance_frame() {
+	g_frame.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FontRegistry::trim(const FontTrimInfo& info) {
+	auto& ctx = t_fontContext;
+
+	if (info.maxIdleFrames != 0) {
+		auto frame = g_frame.load(std::memory_order_relaxed);
+
+		std::erase_if(ctx.cache, [&](const auto& entry) {
+			return frame - entry.second.lastUsedFrame > info.maxIdleFrames;
+		});
+	}
+
+	auto overBudget = [&] {
+		return (info.maxFaceCount != 0 && ctx.cache.size() > info.maxFaceCount)
+				|| (info.maxMemoryBytes != 0 && ctx.memoryUsage > info.maxMemoryBytes);
+	};
+
+	if (!overBudget()) {
+		return;
+	}
+
+	std::vector<std::pair<uint64_t, FaceIndex_T>> facesByUse;
+	facesByUse.reserve(ctx.cache.size());
+
+	for (auto& [face, owner] : ctx.cache) {
+		facesByUse.emplace_back(owner.lastUse, face);
+	}
+
+	std::sort(facesByUse.begin(), facesByUse.end());
+
+	for (auto [_, face] : facesByUse) {
+		if (!overBudget()) {
+			break;
+		}
+
+		ctx.cache.erase(face);
+	}
+}
+
+void FontRegistry::release_thread_data() {
+	t_fontContext.release();
+}
+
+FontThreadUsage FontRegistry::get_thread_usage() {
+	return {
+		.faceCount = static_cast<uint32_t>(t_fontContext.cache.size()),
+		.memoryBytes = t_fontContext.memoryUsage,
+	};
+}
+
+void FontRegistry::set_file_mapping_functions(const FileMappingFunctions& funcs) {
+	std::unique_lock lock(g_mutex);
+	g_fileFuncs = funcs;
+}
+
 // Static Functions
 
 static bool family_is_initialized(FontFamily family) {
@@ -392,7 +660,6 @@ static SingleScriptFont get_sub_font(Text::Font font, UText& iter, int32_t& offs
 	// First, find the first font that is able to render a char from the string.
 
 	FontFace targetFace{};
-	FontData fontData;
 
 	for (;;) {
 		auto c = UTEXT_NEXT32(&iter);
@@ -400,7 +667,7 @@ static SingleScriptFont get_sub_font(Text::Font font, UText& iter, int32_t& offs
 		if (c == U_SENTINEL) {
 			break;
 		}
-		else if (auto face = find_compatible_font(font, c, baseFont, fallbackFamilies, fontData)) {
+		else if (auto face = find_compatible_font(font, c, baseFont, fallbackFamilies)) {
 			targetFace = face;
 			break;
 		}
@@ -421,7 +688,7 @@ static SingleScriptFont get_sub_font(Text::Font font, UText& iter, int32_t& offs
 		if (c == U_SENTINEL) {
 			break;
 		}
-		else if (!fontData.has_codepoint(c)) {
+		else if (!face_covers(targetFace, c)) {
 			offset = offset + idx;
 			return {targetFace, font.get_size()};
 		}
@@ -451,7 +718,19 @@ static FontFace get_or_add_face(const FontFaceCreateInfo& faceInfo) {
 	FontFace result{static_cast<FaceIndex_T>(g_faces.size())};
 	g_facesByName.emplace(std::make_pair(std::string(faceInfo.name), result));
 
-	g_faces.emplace_back(std::string(faceInfo.name), g_fileFuncs.pfnMapFile(faceInfo.uri));
+	auto [sourceIt, newFile] = g_facesByURI.emplace(std::make_pair(std::string(faceInfo.uri), result));
+	auto& faceData = g_faces.emplace_back(std::string(faceInfo.name), sourceIt->second.handle);
+	faceData.faceIndex = faceInfo.faceIndex;
+	faceData.namedInstance = faceInfo.namedInstance;
+	faceData.variations.assign(faceInfo.pVariations, faceInfo.pVariations + faceInfo.variationCount);
+
+	if (newFile) {
+		faceData.mapping = g_fileFuncs.pfnMapFile(faceInfo.uri);
+		faceData.coverage = build_face_coverage(faceData.mapping, faceData.faceIndex);
+	}
+	else if (auto& sourceData = g_faces[faceData.source]; sourceData.faceIndex != faceData.faceIndex) {
+		faceData.coverage = build_face_coverage(sourceData.mapping, faceData.faceIndex);
+	}
 
 	return result;
 }
@@ -474,18 +753,14 @@ static FontFace get_font_for_script(FontFamily family, FontWeight weight, FontSt
 	return family_get_face(family, weight, style);
 }
 
+// Coverage comes from the registration-time cmap sets, so no face is instantiated just to test a codepoint
 static FontFace find_compatible_font(Text::Font font, uint32_t codepoint, FontFace baseFont,
-		const std::vector<FontFamily>& fallbackFamilies, FontData& fontData) {
+		const std::vector<FontFamily>& fallbackFamilies) {
 	if (!baseFont) {
 		return {};
 	}
-	
-	fontData = FontRegistry::get_font_data(baseFont, font.get_size());
-	if (!fontData) {
-		return {};
-	}
 
-	if (fontData.has_codepoint(codepoint)) {
+	if (face_covers(baseFont, codepoint)) {
 		return baseFont;
 	}
 
@@ -495,13 +770,8 @@ static FontFace find_compatible_font(Text::Font font, uint32_t codepoint, FontFa
 		}
 
 		auto face = family_get_face(fam, font.get_weight(), font.get_style());
-		fontData = FontRegistry::get_font_data(face, font.get_size());
-
-		if (!fontData) {
-			continue;
-		}
 
-		if (fontData.has_codepoint(codepoint)) {
+		if (face && face_covers(face, codepoint)) {
 			return face;
 		}
 	}
@@ -509,6 +779,117 @@ static FontFace find_compatible_font(Text::Font font, uint32_t codepoint, FontFa
 	return {};
 }
 
+static bool face_covers(FontFace face, uint32_t codepoint) {
+	auto& faceData = g_faces[face.handle];
+	auto& sourceData = g_faces[faceData.source];
+	return (faceData.faceIndex == sourceData.faceIndex ? sourceData : faceData).coverage.contains(codepoint);
+}
+
+static FontData mark_used(FontDataOwner& owner) {
+	owner.lastUsedFrame = g_frame.load(std::memory_order_relaxed);
+	owner.lastUse = ++t_fontContext.useCounter;
+	return owner;
+}
+
+static void apply_variations(FT_Face ftFace, uint32_t namedInstance, const std::vector<FontVariation>& variations) {
+	FT_Set_Named_Instance(ftFace, namedInstance);
+
+	FT_MM_Var* pMMVar;
+
+	if (variations.empty() || FT_Get_MM_Var(ftFace, &pMMVar) != 0) {
+		return;
+	}
+
+	std::vector<FT_Fixed> coords(pMMVar->num_axis);
+	FT_Get_Var_Design_Coordinates(ftFace, pMMVar->num_axis, coords.data());
+
+	for (FT_UInt i = 0; i < pMMVar->num_axis; ++i) {
+		for (auto& variation : variations) {
+			if (variation.tag == pMMVar->axis[i].tag) {
+				coords[i] = static_cast<FT_Fixed>(std::lround(variation.value * 65536.f));
+			}
+		}
+	}
+
+	FT_Set_Var_Design_Coordinates(ftFace, pMMVar->num_axis, coords.data());
+	FT_Done_MM_Var(ftFace->glyph->library, pMMVar);
+}
+
+static CodepointSet build_face_coverage(const FileMapping& mapping, uint32_t faceIndex) {
+	if (!mapping.mapping) {
+		return CodepointSet{};
+	}
+
+	auto* blob = hb_blob_create(reinterpret_cast<const char*>(mapping.mapping),
+			static_cast<unsigned>(mapping.size), HB_MEMORY_MODE_READONLY, nullptr, nullptr);
+	auto* face = hb_face_create(blob, faceIndex);
+	auto* unicodes = hb_set_create();
+
+	hb_face_collect_unicodes(face, unicodes);
+
+	std::vector<uint32_t> codepoints;
+	codepoints.reserve(hb_set_get_population(unicodes));
+
+	for (hb_codepoint_t c = HB_SET_VALUE_INVALID; hb_set_next(unicodes, &c);) {
+		codepoints.emplace_back(c);
+	}
+
+	hb_set_destroy(unicodes);
+	hb_face_destroy(face);
+	hb_blob_destroy(blob);
+
+	return CodepointSet(codepoints.data(), codepoints.size());
+}
+
+static uint64_t hash_file_contents(const void* data, size_t size) {
+	static constexpr const uint64_t HASH_BASE = 0xCBF29CE484222325ull;
+
+	// Each 8 byte word is folded in through the splitmix64 finalizer, which carries every input bit into every
+	// output bit. Multiplying alone as in FNV-1a never carries the high bits of a word down, so flips there could
+	// cancel out and a changed font would reuse stale glyphs from the disk cache.
+	auto* bytes = reinterpret_cast<const uint8_t*>(data);
+	uint64_t hash = HASH_BASE ^ size;
+	size_t i = 0;
+
+	for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+		uint64_t word;
+		std::memcpy(&word, bytes + i, sizeof(uint64_t));
+		hash = mix_hash(hash ^ word);
+	}
+
+	if (i < size) {
+		uint64_t word{};
+		std::memcpy(&word, bytes + i, size - i);
+		hash = mix_hash(hash ^ word);
+	}
+
+	// 0 is reserved to mean "not yet computed"
+	return hash != 0 ? hash : 1;
+}
+
+// splitmix64 finalizer
+static uint64_t mix_hash(uint64_t value) {
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+	return value ^ (value >> 31);
+}
+
+static uint64_t hash_instance(uint64_t hash, uint32_t faceIndex, uint32_t namedInstance,
+		const FontVariation* pVariations, size_t variationCount) {
+	static constexpr const uint64_t HASH_MULTIPLIER = 0x100000001B3ull;
+
+	// Same as hashing the instance alone for the first face of a file
+	hash = (hash ^ ((static_cast<uint64_t>(faceIndex) << 32) | (namedInstance + 1))) * HASH_MULTIPLIER;
+
+	for (size_t i = 0; i < variationCount; ++i) {
+		uint32_t valueBits;
+		std::memcpy(&valueBits, &pVariations[i].value, sizeof(uint32_t));
+		hash = (hash ^ ((static_cast<uint64_t>(pVariations[i].tag) << 32) | valueBits)) * HASH_MULTIPLIER;
+	}
+
+	return hash != 0 ? hash : 1;
+}
+
 FaceData::~FaceData() {
 	if (mapping.mapping) {
 		g_fileFuncs.pfnUnmapFile(mapping);
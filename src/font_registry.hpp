@@ -8,11 +8,34 @@
 
 namespace Text {
 
+/**
+ * A variable font axis coordinate. `tag` is the OpenType axis tag packed big-endian, as by `HB_TAG`, and `value` is
+ * in the axis' design units, e.g. 700 for 'wght'.
+ */
+struct FontVariation {
+	uint32_t tag;
+	float value;
+};
+
 struct FontFaceCreateInfo {
 	std::string_view name;
 	std::string_view uri;
 	FontWeight weight;
 	FontStyle style;
+	/**
+	 * Index of the face within a font collection file such as a `.ttc`, 0 for files holding a single font.
+	 */
+	uint32_t faceIndex;
+	/**
+	 * For variable fonts, the 1-based named instance to select, or 0 for the default instance.
+	 */
+	uint32_t namedInstance;
+	/**
+	 * For variable fonts, axis coordinates applied on top of the named instance. Unlisted axes keep the named
+	 * instance's values.
+	 */
+	const FontVariation* pVariations;
+	uint32_t variationCount;
 };
 
 struct FontFamilyCreateInfo {
@@ -25,6 +48,38 @@ struct FontFamilyCreateInfo {
 	uint32_t fallbackFamilyCount;
 	const FontFaceCreateInfo* pFaces;
 	uint32_t faceCount;
+	/**
+	 * Declares the family fixed pitch, for monospaced faces that don't set the fixed width flag in their `post`
+	 * table. See `FontRegistry::is_monospace`.
+	 */
+	bool monospace;
+};
+
+/**
+ * Limits applied by `FontRegistry::trim` to the calling thread's open faces. A limit of 0 is not enforced.
+ */
+struct FontTrimInfo {
+	/**
+	 * Faces not used in the current frame or the `maxIdleFrames` frames before it are released.
+	 */
+	uint32_t maxIdleFrames;
+	/**
+	 * Least recently used faces are released until at most `maxFaceCount` remain open.
+	 */
+	uint32_t maxFaceCount;
+	/**
+	 * Least recently used faces are released until the thread's FreeType heap usage is at most `maxMemoryBytes`.
+	 */
+	size_t maxMemoryBytes;
+};
+
+struct FontThreadUsage {
+	uint32_t faceCount;
+	/**
+	 * Bytes allocated by the thread's FreeType library for the faces it has open. HarfBuzz font objects are not
+	 * included.
+	 */
+	size_t memoryBytes;
 };
 
 enum class FontRegistryError {
@@ -58,12 +113,49 @@ namespace Text::FontRegistry {
  * Gets a temporary handle to FreeType and HarfBuzz data structures representing the given font face. Object
  * may be invalid if the face handle is invalid or underlying font data failed to load at any point.
  *
+ * Each face has its own objects on each thread, including faces that are instances of one variable font file, so
+ * data returned for one face stays valid while other faces are in use. Requesting the same face at another size
+ * resizes its objects in place.
+ *
  * @thread_safety Thread safe, see `FontData` for caveats about threading and lifetimes with the returned object.
  */
 [[nodiscard]] FontData get_font_data(FontFace, uint32_t size);
 [[nodiscard]] FontData get_font_data(Font);
 [[nodiscard]] FontData get_font_data(SingleScriptFont);
 
+/**
+ * Gets a HarfBuzz font over the face at units-per-em scale with no hinting, created on the first call for the face
+ * on each thread rather than with every face. Positions shaped with it are in font units and scale linearly with
+ * size. Loads the face like `get_font_data` if needed and shares the lifetime of its objects.
+ *
+ * @thread_safety Thread safe, the returned font belongs to the calling thread.
+ */
+[[nodiscard]] hb_font_t* get_unscaled_font(SingleScriptFont);
+
+/**
+ * Whether text in the font can be laid out on a `GridLayout` cell grid: its family is declared monospace or its
+ * face is flagged fixed width.
+ *
+ * @thread_safety Thread safe, may block internally.
+ */
+[[nodiscard]] bool is_monospace(Font font);
+
+/**
+ * Returns whether the face's cmap maps `codepoint`. Answered from coverage extracted when the face was
+ * registered, without loading the face.
+ *
+ * @thread_safety Thread safe, may block internally.
+ */
+[[nodiscard]] bool has_codepoint(FontFace, uint32_t codepoint);
+
+/**
+ * Gets a 64-bit hash of the contents of the font file backing the given face, computed on first use. Suitable for
+ * keying data that must persist across runs, such as on-disk glyph caches. Returns 0 if the face failed to load.
+ *
+ * @thread_safety Thread safe, may block internally.
+ */
+[[nodiscard]] uint64_t get_face_content_hash(FontFace);
+
 /**
  * Registers a new font family based on the provided `FontFamilyCreateInfo`. If a family name referenced in
  * `pLinkedFamilies` or `pFallbackFamilies` has not yet been loaded, a family handle will be reserved for that
@@ -74,7 +166,8 @@ namespace Text::FontRegistry {
  * `pFaces` *must* not be null and contain at least one face.
  * All faces must have a globally unique name across all families.
  * Each face provided for a single family must have a unique weight and style.
- * Faces *may* share the same URI.
+ * Faces *may* share the same URI. Faces sharing a URI share one file mapping and codepoint coverage, so the weights
+ * and styles of a variable font cost a single mapping.
  *
  * @thread_safety Thread safe, may block internally.
  */
@@ -110,13 +203,50 @@ namespace Text::FontRegistry {
 [[nodiscard]] SingleScriptFont get_sub_font(Font font, const char16_t* text, int32_t& offset, int32_t limit, 
 		UScriptCode script);
 
+/**
+ * Advances the frame counter used by `trim` to find idle faces. Typically called once per frame by the thread
+ * driving the main loop, the counter is shared by all threads.
+ *
+ * @thread_safety Thread safe.
+ */
+void advance_frame();
+
+/**
+ * Releases the FreeType and HarfBuzz objects of faces the calling thread has open, as selected by `info`. Idle faces
+ * are released first, then the least recently used faces until the thread is within the face count and memory
+ * limits. Released faces are reopened on their next use.
+ *
+ * Limits are only applied here rather than on every `get_font_data` call, so that `FontData` objects obtained
+ * earlier stay valid until the caller chooses to trim.
+ *
+ * @thread_safety Thread safe, affects only the calling thread. Invalidates `FontData` objects obtained on the
+ * calling thread for the released faces.
+ */
+void trim(const FontTrimInfo& info);
+
+/**
+ * Releases all font data held by the calling thread, including its FreeType library. For threads about to park
+ * or exit, which would otherwise hold every face they have touched until they exit. The thread may use the
+ * registry again afterwards.
+ *
+ * @thread_safety Thread safe, affects only the calling thread. Invalidates all `FontData` objects obtained on the
+ * calling thread.
+ */
+void release_thread_data();
+
+/**
+ * Gets the number of faces the calling thread has open and the memory they use.
+ *
+ * @thread_safety Thread safe, reports only the calling thread.
+ */
+[[nodiscard]] FontThreadUsage get_thread_usage();
+
 /**
  * Sets the file mapping functions used to load font files internally. This function can only be called before
  * the `FontRegistry` has begun to be used to load fonts. Changing the mapping functions once files have already
  * been loaded will result in undefined behavior.
  *
- *
- * @thread_safety This function must be externally synchronized.
+ * @thread_safety Thread safe, may block internally.
  * @see FileMapping
  */
 void set_file_mapping_functions(const FileMappingFunctions& funcs);
@@ -4,6 +4,8 @@
 
 #include <simdjson.h>
 
+#include <hb.h>
+
 #include <bitset>
 #include <filesystem>
 
@@ -45,10 +47,16 @@ FontRegistryError FontRegistry::register_family_from_json_data(std::string_view
 		return FontRegistryError::INVALID_JSON;
 	}
 
+	bool monospace = false;
+	if (auto err = root["monospace"].get(monospace); err != 0 && err != simdjson::NO_SUCH_FIELD) {
+		return FontRegistryError::INVALID_JSON;
+	}
+
 	std::bitset<USCRIPT_CODE_LIMIT> availableScripts;
 	std::vector<std::string_view> linkedFamilies;
 	std::vector<std::string_view> fallbackFamilies;
 	std::vector<FontFaceCreateInfo> faces;
+	std::vector<std::vector<FontVariation>> faceVariations;
 	bool foundScripts = false;
 
 	simdjson::ondemand::array scripts;
@@ -148,6 +156,62 @@ FontRegistryError FontRegistry::register_family_from_json_data(std::string_view
 		}
 
 		face.style = style.compare("italic") == 0 ? FontStyle::ITALIC : FontStyle::NORMAL;
+
+		// Collection files such as .ttc select a face with an optional index, e.g. "index": 1
+		int64_t faceIndex;
+		if (auto err = faceObject["index"].get(faceIndex); err == 0) {
+			if (faceIndex < 0) {
+				return FontRegistryError::INVALID_JSON;
+			}
+
+			face.faceIndex = static_cast<uint32_t>(faceIndex);
+		}
+		else if (err != simdjson::NO_SUCH_FIELD) {
+			return FontRegistryError::INVALID_JSON;
+		}
+
+		// Variable fonts select an instance with an optional named instance index and axis coordinates, e.g.
+		// "named_instance": 2, "variations": {"wght": 650, "wdth": 87.5}
+		auto& variations = faceVariations.emplace_back();
+
+		int64_t namedInstance;
+		if (auto err = faceObject["named_instance"].get(namedInstance); err == 0) {
+			if (namedInstance < 0) {
+				return FontRegistryError::INVALID_JSON;
+			}
+
+			face.namedInstance = static_cast<uint32_t>(namedInstance);
+		}
+		else if (err != simdjson::NO_SUCH_FIELD) {
+			return FontRegistryError::INVALID_JSON;
+		}
+
+		simdjson::ondemand::object variationObject;
+		if (auto err = faceObject["variations"].get(variationObject); err == 0) {
+			for (auto field : variationObject) {
+				std::string_view axisTag;
+				double value;
+
+				if (field.unescaped_key().get(axisTag) != 0 || axisTag.size() != 4
+						|| field.value().get(value) != 0) {
+					return FontRegistryError::INVALID_JSON;
+				}
+
+				variations.push_back({
+					.tag = HB_TAG(axisTag[0], axisTag[1], axisTag[2], axisTag[3]),
+					.value = static_cast<float>(value),
+				});
+			}
+		}
+		else if (err != simdjson::NO_SUCH_FIELD) {
+			return FontRegistryError::INVALID_JSON;
+		}
+	}
+
+	// Variation arrays no longer move once all faces are parsed
+	for (size_t i = 0; i < faces.size(); ++i) {
+		faces[i].pVariations = faceVariations[i].data();
+		faces[i].variationCount = static_cast<uint32_t>(faceVariations[i].size());
 	}
 
 	std::vector<UScriptCode> scriptCodes;
@@ -170,6 +234,7 @@ FontRegistryError FontRegistry::register_family_from_json_data(std::string_view
 		.fallbackFamilyCount = static_cast<uint32_t>(fallbackFamilies.size()),
 		.pFaces = faces.data(),
 		.faceCount = static_cast<uint32_t>(faces.size()),
+		.monospace = monospace,
 	};
 
 	return FontRegistry::register_family(familyInfo);
@@ -0,0 +1,441 @@
+#include "glyph_cache_file.hpp"
+
+#include "binary_search.hpp"
+#include "common.hpp"
+#include "font_registry.hpp"
+
+#if defined(RICHTEXT_OPERATING_SYSTEM_WINDOWS)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+using namespace Text;
+
+static constexpr const uint32_t PACK_MAGIC = 0x43475452u; // 'RTGC'
+static constexpr const uint32_t PACK_FORMAT_VERSION = 2;
+
+static constexpr const uint32_t RLE_RUN_FLAG = 1u;
+
+namespace {
+
+struct PackHeader {
+	uint32_t magic;
+	uint32_t formatVersion;
+	uint32_t generatorVersion;
+	uint32_t entryCount;
+};
+
+}
+
+struct GlyphCacheFile::IndexEntry {
+	uint64_t fontHash;
+	uint64_t dataOffset;
+	uint32_t glyphIndex;
+	uint32_t size;
+	uint32_t width;
+	uint32_t height;
+	float offset[2];
+	uint32_t dataSize;
+	uint8_t strokeThickness;
+	StrokeType strokeType;
+	GlyphCacheEntryType type;
+	uint8_t hasColor;
+
+	GlyphCacheKey get_key() const {
+		return {fontHash, glyphIndex, size, strokeThickness, strokeType, type};
+	}
+};
+
+static_assert(sizeof(PackHeader) == 16);
+
+static void rle_encode(const uint32_t* pixels, size_t count, std::vector<uint32_t>& output);
+static bool rle_decode(const uint32_t* data, size_t dataSize, uint32_t* pixels, size_t count);
+
+static bool write_all(FILE* file, const void* data, size_t size);
+static bool replace_file(const std::string& source, const std::string& target);
+
+// Public Functions
+
+GlyphCacheFile::~GlyphCacheFile() {
+	close();
+}
+
+bool GlyphCacheFile::open(std::string_view fileName) {
+	// Entries are written and mapped as raw bytes. Checked here since the struct is private to the class.
+	static_assert(sizeof(IndexEntry) == 48);
+
+	close();
+	m_fileName = std::string(fileName);
+
+	m_mapping = map_file_default(fileName);
+
+	if (!m_mapping.mapping) {
+		return false;
+	}
+
+	PackHeader header{};
+
+	if (m_mapping.size >= sizeof(PackHeader)) {
+		std::memcpy(&header, m_mapping.mapping, sizeof(PackHeader));
+	}
+
+	if (header.magic != PACK_MAGIC || header.formatVersion != PACK_FORMAT_VERSION
+			|| header.generatorVersion != GLYPH_CACHE_GENERATOR_VERSION
+			|| m_mapping.size < sizeof(PackHeader) + header.entryCount * sizeof(IndexEntry)) {
+		close();
+		return false;
+	}
+
+	auto* pIndex = reinterpret_cast<const IndexEntry*>(reinterpret_cast<const uint8_t*>(m_mapping.mapping)
+			+ sizeof(PackHeader));
+	uint64_t dataStart = sizeof(PackHeader) + header.entryCount * sizeof(IndexEntry);
+
+	// Offsets come straight from the file, check them once here so lookups can trust every entry. The checks are
+	// ordered so none of them can overflow.
+	for (uint32_t i = 0; i < header.entryCount; ++i) {
+		auto& entry = pIndex[i];
+
+		if (entry.dataOffset < dataStart || entry.dataOffset > m_mapping.size
+				|| entry.dataOffset % sizeof(uint32_t) != 0
+				|| entry.dataSize > (m_mapping.size - entry.dataOffset) / sizeof(uint32_t)) {
+			close();
+			return false;
+		}
+	}
+
+	m_pIndex = pIndex;
+	m_entryCount = header.entryCount;
+
+	return true;
+}
+
+bool GlyphCacheFile::save() {
+	if (m_fileName.empty()) {
+		return false;
+	}
+
+	std::scoped_lock lock(m_mutex);
+
+	// Merge mapped and pending entries, both already sorted by key. Pending entries take priority.
+	struct MergedEntry {
+		IndexEntry entry;
+		const uint32_t* data;
+	};
+
+	std::vector<MergedEntry> merged;
+	merged.reserve(m_entryCount + m_pending.size());
+
+	auto* pBase = reinterpret_cast<const uint8_t*>(m_mapping.mapping);
+	uint32_t mappedIndex = 0;
+
+	auto emitMapped = [&](const IndexEntry& entry) {
+		merged.push_back({entry, reinterpret_cast<const uint32_t*>(pBase + entry.dataOffset)});
+	};
+
+	for (auto& pending : m_pending) {
+		while (mappedIndex < m_entryCount && m_pIndex[mappedIndex].get_key() < pending.key) {
+			emitMapped(m_pIndex[mappedIndex++]);
+		}
+
+		if (mappedIndex < m_entryCount && m_pIndex[mappedIndex].get_key() == pending.key) {
+			++mappedIndex;
+		}
+
+		IndexEntry entry{
+			.fontHash = pending.key.fontHash,
+			.glyphIndex = pending.key.glyphIndex,
+			.size = pending.key.size,
+			.width = pending.width,
+			.height = pending.height,
+			.offset = {pending.offset[0], pending.offset[1]},
+			.dataSize = static_cast<uint32_t>(pending.data.size()),
+			.strokeThickness = pending.key.strokeThickness,
+			.strokeType = pending.key.strokeType,
+			.type = pending.key.type,
+			.hasColor = pending.hasColor,
+		};
+		merged.push_back({entry, pending.data.data()});
+	}
+
+	while (mappedIndex < m_entryCount) {
+		emitMapped(m_pIndex[mappedIndex++]);
+	}
+
+	// Lay out blobs after the index
+	uint64_t dataOffset = sizeof(PackHeader) + merged.size() * sizeof(IndexEntry);
+
+	for (auto& [entry, _] : merged) {
+		entry.dataOffset = dataOffset;
+		dataOffset += entry.dataSize * sizeof(uint32_t);
+	}
+
+	auto tempFileName = m_fileName + ".tmp";
+	FILE* file = std::fopen(tempFileName.c_str(), "wb");
+
+	if (!file) {
+		return false;
+	}
+
+	PackHeader header{
+		.magic = PACK_MAGIC,
+		.formatVersion = PACK_FORMAT_VERSION,
+		.generatorVersion = GLYPH_CACHE_GENERATOR_VERSION,
+		.entryCount = static_cast<uint32_t>(merged.size()),
+	};
+
+	bool success = write_all(file, &header, sizeof(PackHeader));
+
+	for (auto& [entry, _] : merged) {
+		success = success && write_all(file, &entry, sizeof(IndexEntry));
+	}
+
+	for (auto& [entry, data] : merged) {
+		success = success && write_all(file, data, entry.dataSize * sizeof(uint32_t));
+	}
+
+	success = (std::fclose(file) == 0) && success;
+
+	if (!success) {
+		std::remove(tempFileName.c_str());
+		return false;
+	}
+
+#if defined(RICHTEXT_OPERATING_SYSTEM_WINDOWS)
+	// Windows cannot replace a mapped file, the old pack is remapped below if the replace fails
+	close();
+#endif
+
+	// `open` replaces the stored name, so it cannot be passed a view of it
+	auto fileName = m_fileName;
+
+	// Nothing is discarded until the new pack has replaced the old one, so a failed save loses no entries
+	if (!replace_file(tempFileName, fileName)) {
+		std::remove(tempFileName.c_str());
+#if defined(RICHTEXT_OPERATING_SYSTEM_WINDOWS)
+		open(fileName);
+#endif
+		return false;
+	}
+
+	m_pending.clear();
+	open(fileName);
+
+	return true;
+}
+
+bool GlyphCacheFile::find(const GlyphCacheKey& key, Bitmap& bitmapOut, float* offsetOut,
+		bool& hasColorOut) const {
+	// A mapped entry that fails to decode was likely replaced by `insert` after the caller re-rasterized it, so
+	// fall through to the pending entries
+	if (auto* pEntry = find_mapped(key)) {
+		auto* pData = reinterpret_cast<const uint32_t*>(reinterpret_cast<const uint8_t*>(m_mapping.mapping)
+				+ pEntry->dataOffset);
+		Bitmap bitmap(pEntry->width, pEntry->height);
+
+		if (rle_decode(pData, pEntry->dataSize, bitmap.data(), pEntry->width * pEntry->height)) {
+			bitmapOut = std::move(bitmap);
+			offsetOut[0] = pEntry->offset[0];
+			offsetOut[1] = pEntry->offset[1];
+			hasColorOut = pEntry->hasColor;
+
+			return true;
+		}
+	}
+
+	std::scoped_lock lock(m_mutex);
+
+	auto it = std::lower_bound(m_pending.begin(), m_pending.end(), key,
+			[](const auto& entry, const auto& key) { return entry.key < key; });
+
+	if (it == m_pending.end() || !(it->key == key)) {
+		return false;
+	}
+
+	Bitmap bitmap(it->width, it->height);
+	rle_decode(it->data.data(), it->data.size(), bitmap.data(), it->width * it->height);
+
+	bitmapOut = std::move(bitmap);
+	offsetOut[0] = it->offset[0];
+	offsetOut[1] = it->offset[1];
+	hasColorOut = it->hasColor;
+
+	return true;
+}
+
+void GlyphCacheFile::insert(const GlyphCacheKey& key, const Bitmap& bitmap, const float* offset, bool hasColor) {
+	PendingEntry entry{
+		.key = key,
+		.width = bitmap.get_width(),
+		.height = bitmap.get_height(),
+		.offset = {offset[0], offset[1]},
+		.hasColor = hasColor,
+	};
+	rle_encode(bitmap.data(), bitmap.get_width() * bitmap.get_height(), entry.data);
+
+	std::scoped_lock lock(m_mutex);
+
+	auto it = std::lower_bound(m_pending.begin(), m_pending.end(), key,
+			[](const auto& entry, const auto& key) { return entry.key < key; });
+
+	if (it != m_pending.end() && it->key == key) {
+		*it = std::move(entry);
+	}
+	else {
+		m_pending.insert(it, std::move(entry));
+	}
+}
+
+const GlyphCacheFile::IndexEntry* GlyphCacheFile::find_mapped(const GlyphCacheKey& key) const {
+	auto index = binary_search(0, m_entryCount, [&](auto i) {
+		return m_pIndex[i].get_key() < key;
+	});
+
+	if (index < m_entryCount && m_pIndex[index].get_key() == key) {
+		return &m_pIndex[index];
+	}
+
+	return nullptr;
+}
+
+void GlyphCacheFile::close() {
+	if (m_mapping.mapping) {
+		unmap_file_default(m_mapping);
+	}
+
+	m_mapping = {};
+	m_pIndex = nullptr;
+	m_entryCount = 0;
+}
+
+// GlyphCacheKey
+
+GlyphCacheKey Text::make_glyph_cache_key(SingleScriptFont font, uint32_t glyphIndex, uint8_t strokeThickness,
+		StrokeType strokeType, GlyphCacheEntryType type) {
+	return {
+		.fontHash = FontRegistry::get_face_content_hash(font.face),
+		.glyphIndex = glyphIndex,
+		// Glyph MSDFs are generated at a canonical em size, only strokes depend on the font size
+		.size = type == GlyphCacheEntryType::MSDF ? 0 : font.size,
+		.strokeThickness = strokeThickness,
+		.strokeType = strokeType,
+		.type = type,
+	};
+}
+
+bool GlyphCacheKey::operator==(const GlyphCacheKey& o) const {
+	return fontHash == o.fontHash && glyphIndex == o.glyphIndex && size == o.size
+			&& strokeThickness == o.strokeThickness && strokeType == o.strokeType && type == o.type;
+}
+
+bool GlyphCacheKey::operator<(const GlyphCacheKey& o) const {
+	return std::tie(fontHash, glyphIndex, size, strokeThickness, strokeType, type)
+			< std::tie(o.fontHash, o.glyphIndex, o.size, o.strokeThickness, o.strokeType, o.type);
+}
+
+// Static Functions
+
+// Each token is a header word `(count << 1) | RLE_RUN_FLAG` followed by one pixel repeated `count` times, or
+// a header word `count << 1` followed by `count` literal pixels. Glyph bitmaps are mostly fully transparent
+// or fully opaque, so long runs dominate.
+static void rle_encode(const uint32_t* pixels, size_t count, std::vector<uint32_t>& output) {
+	size_t i = 0;
+
+	while (i < count) {
+		size_t runEnd = i + 1;
+
+		while (runEnd < count && pixels[runEnd] == pixels[i]) {
+			++runEnd;
+		}
+
+		if (runEnd - i > 2) {
+			output.push_back(static_cast<uint32_t>((runEnd - i) << 1) | RLE_RUN_FLAG);
+			output.push_back(pixels[i]);
+			i = runEnd;
+			continue;
+		}
+
+		// Extend the literal span until a run of at least 3 equal pixels begins
+		size_t literalEnd = i;
+
+		while (literalEnd < count) {
+			if (literalEnd + 2 < count && pixels[literalEnd] == pixels[literalEnd + 1]
+					&& pixels[literalEnd] == pixels[literalEnd + 2]) {
+				break;
+			}
+
+			++literalEnd;
+		}
+
+		output.push_back(static_cast<uint32_t>((literalEnd - i) << 1));
+		output.insert(output.end(), pixels + i, pixels + literalEnd);
+		i = literalEnd;
+	}
+}
+
+static bool rle_decode(const uint32_t* data, size_t dataSize, uint32_t* pixels, size_t count) {
+	size_t readPos = 0;
+	size_t writePos = 0;
+
+	while (readPos < dataSize) {
+		auto header = data[readPos++];
+		size_t tokenCount = header >> 1;
+
+		if (writePos + tokenCount > count) {
+			return false;
+		}
+
+		if (header & RLE_RUN_FLAG) {
+			if (readPos >= dataSize) {
+				return false;
+			}
+
+			std::fill_n(pixels + writePos, tokenCount, data[readPos++]);
+		}
+		else {
+			if (readPos + tokenCount > dataSize) {
+				return false;
+			}
+
+			std::memcpy(pixels + writePos, data + readPos, tokenCount * sizeof(uint32_t));
+			readPos += tokenCount;
+		}
+
+		writePos += tokenCount;
+	}
+
+	return writePos == count;
+}
+
+static bool write_all(FILE* file, const void* data, size_t size) {
+	return size == 0 || std::fwrite(data, 1, size, file) == size;
+}
+
+// Replaces `target` with `source` in a single step, so readers see either the old or the new file
+static bool replace_file(const std::string& source, const std::string& target) {
+#if defined(RICHTEXT_OPERATING_SYSTEM_WINDOWS)
+	auto toWide = [](const std::string& str) {
+		auto length = MultiByteToWideChar(CP_UTF8, 0, str.data(), static_cast<int>(str.size()), nullptr, 0);
+		std::wstring result(length, L'\0');
+		MultiByteToWideChar(CP_UTF8, 0, str.data(), static_cast<int>(str.size()), result.data(), length);
+		return result;
+	};
+
+	return MoveFileExW(toWide(source).c_str(), toWide(target).c_str(),
+			MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	// POSIX rename replaces atomically, and an existing mapping of the old file stays valid
+	return std::rename(source.c_str(), target.c_str()) == 0;
+#endif
+}
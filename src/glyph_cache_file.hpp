@@ -0,0 +1,112 @@
+#pragma once
+
+#include "bitmap.hpp"
+#include "file_mapping.hpp"
+#include "font.hpp"
+#include "stroke_type.hpp"
+
+#include <cstdint>
+
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Text {
+
+/**
+ * Bump whenever the output of the glyph rasterizers or the MSDF generator changes, so that stale cache files
+ * written by older builds are discarded rather than served.
+ */
+inline constexpr const uint32_t GLYPH_CACHE_GENERATOR_VERSION = 3;
+
+enum class GlyphCacheEntryType : uint8_t {
+	BITMAP,
+	BITMAP_OUTLINE,
+	MSDF,
+	MSDF_OUTLINE,
+};
+
+struct GlyphCacheKey {
+	uint64_t fontHash;
+	uint32_t glyphIndex;
+	uint32_t size;
+	uint8_t strokeThickness;
+	StrokeType strokeType;
+	GlyphCacheEntryType type;
+
+	bool operator==(const GlyphCacheKey&) const;
+	bool operator<(const GlyphCacheKey&) const;
+};
+
+/**
+ * Builds the cache key of a glyph rendered from `font`. MSDF entries are size independent and key on size 0.
+ * `fontHash` is 0 if the face failed to load, such keys should not be inserted.
+ */
+[[nodiscard]] GlyphCacheKey make_glyph_cache_key(SingleScriptFont font, uint32_t glyphIndex, uint8_t strokeThickness,
+		StrokeType strokeType, GlyphCacheEntryType type);
+
+/**
+ * A persistent cache of rasterized glyph bitmaps, stored as a single pack file that is mapped into memory on
+ * `open()`. Bitmaps are stored run-length encoded along with their draw offsets and color flag. Entries are keyed
+ * by a hash of the font file contents (see `FontRegistry::get_face_content_hash`), so a cache file stays valid
+ * when fonts are reordered or renamed, and invalidates itself when a font file changes.
+ *
+ * New entries are kept in memory until `save()` merges them with the mapped entries and rewrites the pack.
+ *
+ * @thread_safety `find()` and `insert()` are thread safe. `open()` and `save()` must be externally synchronized.
+ */
+class GlyphCacheFile final {
+	public:
+		explicit GlyphCacheFile() = default;
+		~GlyphCacheFile();
+
+		GlyphCacheFile(GlyphCacheFile&&) = delete;
+		void operator=(GlyphCacheFile&&) = delete;
+
+		GlyphCacheFile(const GlyphCacheFile&) = delete;
+		void operator=(const GlyphCacheFile&) = delete;
+
+		/**
+		 * Maps the pack file at `fileName`. Returns false if the file is missing, corrupt, or was written by a
+		 * different generator version; the cache remains usable and `save()` will create a fresh file.
+		 */
+		bool open(std::string_view fileName);
+
+		/**
+		 * Writes all mapped and inserted entries to a temporary file, then replaces the pack file given to `open()`
+		 * with it. Returns false on I/O failure, in which case the pack file and all entries are left as they were.
+		 */
+		bool save();
+
+		/**
+		 * Looks up a cached bitmap. On success, `bitmapOut` receives the decoded bitmap, `offsetOut` the 2 draw
+		 * offsets and `hasColorOut` whether the bitmap is colored.
+		 */
+		bool find(const GlyphCacheKey&, Bitmap& bitmapOut, float* offsetOut, bool& hasColorOut) const;
+		void insert(const GlyphCacheKey&, const Bitmap&, const float* offset, bool hasColor);
+	private:
+		struct IndexEntry;
+
+		struct PendingEntry {
+			GlyphCacheKey key;
+			uint32_t width;
+			uint32_t height;
+			float offset[2];
+			bool hasColor;
+			std::vector<uint32_t> data;
+		};
+
+		std::string m_fileName;
+		FileMapping m_mapping{};
+		const IndexEntry* m_pIndex{};
+		uint32_t m_entryCount{};
+
+		mutable std::mutex m_mutex;
+		std::vector<PendingEntry> m_pending;
+
+		const IndexEntry* find_mapped(const GlyphCacheKey&) const;
+		void close();
+};
+
+}
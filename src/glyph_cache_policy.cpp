@@ -0,0 +1,19 @@
+#include "glyph_cache_policy.hpp"
+
+#include "font_registry.hpp"
+
+using namespace Text;
+
+GlyphRenderMode GlyphCachePolicy::get_render_mode(SingleScriptFont font, float renderScale) const {
+	auto fontData = FontRegistry::get_font_data(font);
+	return fontData ? get_render_mode(fontData, renderScale) : GlyphRenderMode::BITMAP;
+}
+
+GlyphRenderMode GlyphCachePolicy::get_render_mode(const FontData& fontData, float renderScale) const {
+	if (fontData.has_color_glyphs()) {
+		return GlyphRenderMode::BITMAP;
+	}
+
+	return fontData.get_ppem_y() * renderScale >= msdfMinPixelsPerEm ? GlyphRenderMode::MSDF
+			: GlyphRenderMode::BITMAP;
+}
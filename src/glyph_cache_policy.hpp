@@ -0,0 +1,36 @@
+#pragma once
+
+#include "font.hpp"
+
+#include <cstdint>
+
+namespace Text {
+
+struct FontData;
+
+enum class GlyphRenderMode : uint8_t {
+	BITMAP, // Rasterized coverage or color bitmap at the exact pixel size
+	MSDF, // Size-independent multi-channel signed distance field
+};
+
+/**
+ * Decides how the glyphs of a run should be rendered and cached. Small text is rasterized directly, where hinting
+ * and exact coverage matter most and bitmaps are cheap. Large text uses MSDFs, so that a single atlas entry
+ * serves every size above the threshold. Faces with color glyphs are always rasterized, as MSDFs cannot
+ * represent color.
+ */
+struct GlyphCachePolicy {
+	/**
+	 * Rendered sizes in pixels per em at or above which glyphs are rendered as MSDFs.
+	 */
+	float msdfMinPixelsPerEm = 48.f;
+
+	/**
+	 * @param renderScale Additional scale applied when drawing, e.g. a zoom factor
+	 * @thread_safety Thread safe, may block internally.
+	 */
+	GlyphRenderMode get_render_mode(SingleScriptFont, float renderScale = 1.f) const;
+	GlyphRenderMode get_render_mode(const FontData&, float renderScale = 1.f) const;
+};
+
+}
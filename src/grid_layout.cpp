@@ -0,0 +1,254 @@
+#include "grid_layout.hpp"
+
+#include "bidi_prescan.hpp"
+#include "font_registry.hpp"
+#include "script_run_iterator.hpp"
+#include "simple_shaping.hpp"
+
+#include <unicode/uchar.h>
+#include <unicode/utf8.h>
+
+#include <cmath>
+
+using namespace Text;
+
+static int32_t get_code_point_column_count(UChar32 c);
+
+// Public Functions
+
+void GridLine::clear() {
+	m_glyphs.clear();
+	m_glyphFonts.clear();
+	m_glyphXs.clear();
+	m_glyphCharIndices.clear();
+	m_columnCharIndices.clear();
+	m_charColumns.clear();
+}
+
+void GridLine::append_glyph(uint32_t glyphID, const SingleScriptFont& font, float x, uint32_t charIndex) {
+	m_glyphs.emplace_back(glyphID);
+	m_glyphFonts.emplace_back(font);
+	m_glyphXs.emplace_back(x);
+	m_glyphCharIndices.emplace_back(charIndex);
+}
+
+void GridLine::append_cells(uint32_t charIndex, uint32_t charEnd, uint32_t columnCount) {
+	m_charColumns.resize(charEnd, get_column_count());
+	m_columnCharIndices.insert(m_columnCharIndices.end(), columnCount, charIndex);
+}
+
+uint32_t GridLine::get_char_index_at_column(uint32_t column) const {
+	return column < get_column_count() ? m_columnCharIndices[column] : get_char_count();
+}
+
+uint32_t GridLine::get_column_at_char_index(uint32_t charIndex) const {
+	return charIndex < get_char_count() ? m_charColumns[charIndex] : get_column_count();
+}
+
+uint32_t GridLine::get_next_cursor_position(uint32_t charIndex) const {
+	auto column = get_column_at_char_index(charIndex);
+
+	if (column >= get_column_count()) {
+		return get_char_count();
+	}
+
+	// Wide characters and tabs span a bounded number of columns
+	auto current = m_columnCharIndices[column];
+
+	while (++column < get_column_count() && m_columnCharIndices[column] == current) {}
+
+	return get_char_index_at_column(column);
+}
+
+uint32_t GridLine::get_previous_cursor_position(uint32_t charIndex) const {
+	auto column = get_column_at_char_index(charIndex);
+	return column == 0 ? 0 : m_columnCharIndices[column - 1];
+}
+
+uint32_t GridLine::get_glyph_id(size_t glyphIndex) const {
+	return m_glyphs[glyphIndex];
+}
+
+const SingleScriptFont& GridLine::get_glyph_font(size_t glyphIndex) const {
+	return m_glyphFonts[glyphIndex];
+}
+
+float GridLine::get_glyph_x(size_t glyphIndex) const {
+	return m_glyphXs[glyphIndex];
+}
+
+uint32_t GridLine::get_glyph_char_index(size_t glyphIndex) const {
+	return m_glyphCharIndices[glyphIndex];
+}
+
+size_t GridLine::get_glyph_count() const {
+	return m_glyphs.size();
+}
+
+uint32_t GridLine::get_column_count() const {
+	return static_cast<uint32_t>(m_columnCharIndices.size());
+}
+
+uint32_t GridLine::get_char_count() const {
+	return static_cast<uint32_t>(m_charColumns.size());
+}
+
+GridLayout::GridLayout(Font font)
+		: m_font(font) {
+	auto fontData = FontRegistry::get_font_data(font);
+
+	if (!fontData) {
+		m_cellWidth = 0.5f * static_cast<float>(font.get_size());
+		m_rowHeight = static_cast<float>(font.get_size());
+		m_ascent = m_rowHeight;
+		return;
+	}
+
+	m_cellWidth = fontData.get_glyph_advance_x(fontData.map_codepoint_to_glyph(' ')) / 64.f;
+
+	if (m_cellWidth <= 0.f) {
+		m_cellWidth = 0.5f * fontData.get_ppem_x();
+	}
+
+	m_ascent = fontData.get_ascent();
+	m_rowHeight = fontData.get_ascent() - fontData.get_descent();
+}
+
+bool GridLayout::build_line(GridLine& result, const char* chars, int32_t count) const {
+	result.clear();
+
+	if (!is_trivially_ltr(chars, count)) {
+		return false;
+	}
+
+	ScriptRunIterator runIter(chars, count);
+	int32_t runStart;
+	int32_t runLimit;
+	UScriptCode script;
+	uint32_t column{};
+
+	while (runIter.next(runStart, runLimit, script)) {
+		// Precomposed Hangul syllables need no shaping, conjoining jamo are rejected per code point
+		if (!is_simple_shaping_script(script) && script != USCRIPT_HANGUL) {
+			result.clear();
+			return false;
+		}
+
+		for (int32_t offset = runStart; offset < runLimit;) {
+			auto subFontStart = offset;
+			auto subFont = FontRegistry::get_sub_font(m_font, chars, offset, runLimit, script);
+			auto fontData = FontRegistry::get_font_data(subFont);
+
+			for (int32_t index = subFontStart; index < offset;) {
+				auto charIndex = index;
+				UChar32 c;
+				U8_NEXT(chars, index, offset, c);
+
+				if (c < 0) {
+					c = 0xFFFD;
+				}
+
+				auto columnCount = c == '\t' ? static_cast<int32_t>(TAB_COLUMNS - column % TAB_COLUMNS)
+						: get_code_point_column_count(c);
+
+				if (columnCount < 0) {
+					result.clear();
+					return false;
+				}
+
+				result.append_cells(charIndex, index, columnCount);
+
+				if (columnCount > 0 && c != '\t' && fontData) {
+					auto glyph = fontData.map_codepoint_to_glyph(c);
+					auto advance = fontData.get_glyph_advance_x(glyph) / 64.f;
+					auto cellsWidth = static_cast<float>(columnCount) * m_cellWidth;
+
+					result.append_glyph(glyph, subFont, get_column_x(column) + 0.5f * (cellsWidth - advance),
+							charIndex);
+				}
+
+				column += columnCount;
+			}
+		}
+	}
+
+	return true;
+}
+
+GridCell GridLayout::get_cell_at(float x, float y) const {
+	return {
+		.row = y > 0.f ? static_cast<size_t>(y / m_rowHeight) : 0,
+		.column = x > 0.f ? static_cast<uint32_t>(x / m_cellWidth) : 0,
+	};
+}
+
+uint32_t GridLayout::get_closest_column_boundary(float x) const {
+	return x > 0.f ? static_cast<uint32_t>(std::lround(x / m_cellWidth)) : 0;
+}
+
+void GridLayout::get_visible_rows(float scrollY, float viewHeight, size_t rowCount, size_t& outFirstRow,
+		size_t& outRowLimit) const {
+	auto first = scrollY > 0.f ? static_cast<size_t>(scrollY / m_rowHeight) : 0;
+	auto bottom = scrollY + viewHeight;
+	auto limit = bottom > 0.f ? static_cast<size_t>(std::ceil(bottom / m_rowHeight)) : 0;
+
+	outFirstRow = first < rowCount ? first : rowCount;
+	outRowLimit = limit < rowCount ? (limit > outFirstRow ? limit : outFirstRow) : rowCount;
+}
+
+float GridLayout::get_column_x(uint32_t column) const {
+	return static_cast<float>(column) * m_cellWidth;
+}
+
+float GridLayout::get_row_top(size_t row) const {
+	return static_cast<float>(row) * m_rowHeight;
+}
+
+float GridLayout::get_row_baseline(size_t row) const {
+	return get_row_top(row) + m_ascent;
+}
+
+Font GridLayout::get_font() const {
+	return m_font;
+}
+
+float GridLayout::get_cell_width() const {
+	return m_cellWidth;
+}
+
+float GridLayout::get_row_height() const {
+	return m_rowHeight;
+}
+
+float GridLayout::get_ascent() const {
+	return m_ascent;
+}
+
+// Static Functions
+
+// Columns taken by a code point drawn on its own, or -1 if it must be shaped together with its neighbours
+static int32_t get_code_point_column_count(UChar32 c) {
+	if (c >= 0x20 && c < 0x7F) {
+		return 1;
+	}
+
+	switch (u_getIntPropertyValue(c, UCHAR_GRAPHEME_CLUSTER_BREAK)) {
+		case U_GCB_OTHER:
+		case U_GCB_LV:
+		case U_GCB_LVT:
+			break;
+		case U_GCB_CONTROL:
+		case U_GCB_CR:
+		case U_GCB_LF:
+			return 0;
+		default:
+			return -1;
+	}
+
+	if (u_hasBinaryProperty(c, UCHAR_DEFAULT_IGNORABLE_CODE_POINT)) {
+		return 0;
+	}
+
+	auto width = u_getIntPropertyValue(c, UCHAR_EAST_ASIAN_WIDTH);
+	return width == U_EA_WIDE || width == U_EA_FULLWIDTH ? 2 : 1;
+}
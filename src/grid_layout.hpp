@@ -0,0 +1,127 @@
+#pragma once
+
+#include "font.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+
+namespace Text {
+
+struct GridCell {
+	size_t row;
+	uint32_t column;
+};
+
+/**
+ * One line of text laid out on a `GridLayout` cell grid. Every code point covers 0, 1 or 2 whole columns, so
+ * converting between columns and char indices, and therefore hit testing and cursor motion within the line, is a
+ * table lookup.
+ */
+class GridLine final {
+	public:
+		void clear();
+
+		void append_glyph(uint32_t glyphID, const SingleScriptFont& font, float x, uint32_t charIndex);
+		/**
+		 * Assigns the code point at [charIndex, charEnd) to the next `columnCount` columns.
+		 */
+		void append_cells(uint32_t charIndex, uint32_t charEnd, uint32_t columnCount);
+
+		/**
+		 * Gets the char index of the code point covering `column`, or the line's length for columns past its end.
+		 */
+		uint32_t get_char_index_at_column(uint32_t column) const;
+		/**
+		 * Gets the first column of the code point containing `charIndex`. Code points that take no column share
+		 * the column of the code point after them.
+		 */
+		uint32_t get_column_at_char_index(uint32_t charIndex) const;
+
+		/**
+		 * Cursor motion by one cell, skipping code points that take no column.
+		 */
+		uint32_t get_next_cursor_position(uint32_t charIndex) const;
+		uint32_t get_previous_cursor_position(uint32_t charIndex) const;
+
+		uint32_t get_glyph_id(size_t glyphIndex) const;
+		const SingleScriptFont& get_glyph_font(size_t glyphIndex) const;
+		// Left edge of the glyph relative to the start of the line
+		float get_glyph_x(size_t glyphIndex) const;
+		uint32_t get_glyph_char_index(size_t glyphIndex) const;
+
+		size_t get_glyph_count() const;
+		uint32_t get_column_count() const;
+		uint32_t get_char_count() const;
+	private:
+		std::vector<uint32_t> m_glyphs;
+		std::vector<SingleScriptFont> m_glyphFonts;
+		std::vector<float> m_glyphXs;
+		std::vector<uint32_t> m_glyphCharIndices;
+		// Per column, the char index of the code point covering it
+		std::vector<uint32_t> m_columnCharIndices;
+		// Per code unit, the first column of the code point containing it
+		std::vector<uint32_t> m_charColumns;
+};
+
+/**
+ * Lays out text in a fixed-pitch font on a grid of equal cells, one line per row, for console and log views.
+ * Positions are computed arithmetically per cell instead of going through bidi resolution, itemization, shaping and
+ * line breaking, so a view only pays for the rows it shows: `get_visible_rows` picks them out of any number of
+ * lines without touching the rest.
+ *
+ * East Asian wide and fullwidth characters take two columns. Characters the font lacks are drawn from its
+ * fallback faces, centered on their cells. No ligatures or kerning are applied, as in a terminal.
+ */
+class GridLayout final {
+	public:
+		static constexpr const uint32_t TAB_COLUMNS = 8;
+
+		/**
+		 * Sets up the grid of `font`: cells are as wide as its space glyph and rows as tall as its hinted ascent
+		 * and descent. `font` should pass `FontRegistry::is_monospace`, other fonts lay out with uneven spacing.
+		 */
+		explicit GridLayout(Font font);
+
+		/**
+		 * Lays out `count` code units of a single line into `result`. Returns false and leaves `result` empty if the
+		 * line needs the full pipeline, such as right-to-left text, complex scripts, combining marks or joiners;
+		 * lay those lines out with `build_layout_info_utf8` instead. Tabs advance to the next multiple of
+		 * `TAB_COLUMNS`, other control and default ignorable characters take no column.
+		 */
+		bool build_line(GridLine& result, const char* chars, int32_t count) const;
+
+		/**
+		 * Gets the cell containing the point, relative to the top left of the first row. Points above or left of
+		 * the grid clamp to row or column 0.
+		 */
+		GridCell get_cell_at(float x, float y) const;
+		/**
+		 * Gets the column boundary closest to `x`, which is where a click at `x` places the cursor.
+		 */
+		uint32_t get_closest_column_boundary(float x) const;
+
+		/**
+		 * Gets the rows of a `rowCount` row grid intersecting the view from `scrollY` to `scrollY + viewHeight`
+		 * as [`outFirstRow`, `outRowLimit`).
+		 */
+		void get_visible_rows(float scrollY, float viewHeight, size_t rowCount, size_t& outFirstRow,
+				size_t& outRowLimit) const;
+
+		float get_column_x(uint32_t column) const;
+		float get_row_top(size_t row) const;
+		float get_row_baseline(size_t row) const;
+
+		Font get_font() const;
+		float get_cell_width() const;
+		float get_row_height() const;
+		float get_ascent() const;
+	private:
+		Font m_font;
+		float m_cellWidth;
+		float m_rowHeight;
+		float m_ascent;
+};
+
+}
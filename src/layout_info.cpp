@@ -3,14 +3,26 @@
 #include "binary_search.hpp"
 
 #include <unicode/brkiter.h>
+#include <unicode/uchar.h>
+#include <unicode/utext.h>
 
+#include <algorithm>
 #include <cstring>
+#include <memory>
 
 using namespace Text;
 
 static bool affinity_prefer_prev_run(bool atLineBreak, bool atSoftLineBreak, bool prevRunRTL, bool nextRunRTL,
 		CursorAffinity affinity);
 
+static bool is_line_break(UChar32 c);
+static icu::BreakIterator* get_character_break_iterator();
+
+static constexpr const UChar32 CH_LF = 0x000A;
+static constexpr const UChar32 CH_CR = 0x000D;
+static constexpr const UChar32 CH_LSEP = 0x2028;
+static constexpr const UChar32 CH_PSEP = 0x2029;
+
 static constexpr CursorPosition make_cursor(uint32_t position, bool oppositeAffinity) {
 	return {position | (static_cast<uint32_t>(oppositeAffinity) << 31)};
 }
@@ -18,11 +30,18 @@ static constexpr CursorPosition make_cursor(uint32_t position, bool oppositeAffi
 // LayoutInfo
 
 void LayoutInfo::clear() {
+	clear_lines();
+	m_graphemeBoundaries.clear();
+	m_wordBoundaries.clear();
+}
+
+void LayoutInfo::clear_lines() {
 	m_visualRuns.clear();
 	m_lines.clear();
 	m_glyphs.clear();
 	m_charIndices.clear();
 	m_glyphPositions.clear();
+	m_logicalRunOrder.clear();
 }
 
 void LayoutInfo::reserve_runs(size_t runCount) {
@@ -63,6 +82,8 @@ void LayoutInfo::append_line(float height, float ascent) {
 		.ascent = ascent,
 		.totalDescent = m_lines.empty() ? height : m_lines.back().totalDescent + height,
 	});
+
+	append_line_index(get_first_run_index(m_lines.size() - 1));
 }
 
 void LayoutInfo::append_empty_line(uint32_t charIndex, float height, float ascent) {
@@ -81,16 +102,42 @@ void LayoutInfo::append_empty_line(uint32_t charIndex, float height, float ascen
 		.ascent = ascent,
 		.totalDescent = m_lines.empty() ? height : m_lines.back().totalDescent + height,
 	});
+
+	append_line_index(get_first_run_index(m_lines.size() - 1));
 }
 
 void LayoutInfo::set_run_char_end_offset(size_t runIndex, uint8_t charEndOffset) {
-	m_visualRuns[runIndex].charEndOffset = charEndOffset;
+	auto& run = m_visualRuns[runIndex];
+	run.charEndOffset = charEndOffset;
+
+	// The builders set the separator offset after the paragraph's last line has already been appended
+	if (!m_lines.empty() && runIndex < m_lines.back().visualRunsEndIndex
+			&& runIndex >= get_first_run_index(m_lines.size() - 1)) {
+		auto& line = m_lines.back();
+		line.charEndIndex = std::max(line.charEndIndex, run.charEndIndex + charEndOffset);
+	}
 }
 
 void LayoutInfo::set_text_start_y(float textStartY) {
 	m_textStartY = textStartY;
 }
 
+void LayoutInfo::compute_text_boundaries(const char* chars, int32_t count) {
+	UErrorCode err{U_ZERO_ERROR};
+	UText uText UTEXT_INITIALIZER;
+	utext_openUTF8(&uText, chars, count, &err);
+	compute_text_boundaries(&uText, count);
+	utext_close(&uText);
+}
+
+void LayoutInfo::compute_text_boundaries(const char16_t* chars, int32_t count) {
+	UErrorCode err{U_ZERO_ERROR};
+	UText uText UTEXT_INITIALIZER;
+	utext_openUChars(&uText, chars, count, &err);
+	compute_text_boundaries(&uText, count);
+	utext_close(&uText);
+}
+
 VisualCursorInfo LayoutInfo::calc_cursor_pixel_pos(float textWidth, TextXAlignment textXAlignment,
 		CursorPosition cursor) const {
 	size_t lineIndex;
@@ -107,11 +154,24 @@ VisualCursorInfo LayoutInfo::calc_cursor_pixel_pos(float textWidth, TextXAlignme
 }
 
 size_t LayoutInfo::get_run_containing_cursor(CursorPosition cursor, size_t& outLineNumber) const {
-	outLineNumber = 0;
 	auto cursorPos = cursor.get_position();
 
+	// No run of a line ending before the cursor can contain it, so start scanning at the first line that
+	// reaches it. Affinity may still push the cursor onto the following line.
+	auto firstLine = binary_search(0, m_lines.size(), [&](auto index) {
+		return m_lines[index].charEndIndex < static_cast<uint32_t>(cursorPos);
+	});
+
+	if (firstLine == m_lines.size()) {
+		outLineNumber = m_lines.empty() ? 0 : m_lines.size() - 1;
+		return m_visualRuns.size() - 1;
+	}
+
+	// Entering the first run of `firstLine` advances the line number past the previous line
+	outLineNumber = firstLine == 0 ? 0 : firstLine - 1;
+
 	size_t firstGlyphIndex = 0;
-	for (size_t i = 0; i < m_visualRuns.size(); ++i) {
+	for (size_t i = get_first_run_index(firstLine); i < m_visualRuns.size(); ++i) {
 		auto& run = m_visualRuns[i];
 		auto lastGlyphIndex = run.glyphEndIndex;
 		bool runBeforeLineBreak = i + 1 < m_visualRuns.size()
@@ -143,6 +203,51 @@ size_t LayoutInfo::get_run_containing_cursor(CursorPosition cursor, size_t& outL
 	return m_visualRuns.size() - 1;
 }
 
+void LayoutInfo::get_selection_rects(float textWidth, TextXAlignment textXAlignment, uint32_t selectionStart,
+		uint32_t selectionEnd, std::vector<SelectionRect>& rectsOut) const {
+	if (selectionStart >= selectionEnd || m_lines.empty()) {
+		return;
+	}
+
+	auto firstLine = binary_search(0, m_lines.size(), [&](auto index) {
+		return m_lines[index].charEndIndex <= selectionStart;
+	});
+
+	auto firstLineY = m_lines.front().ascent + m_textStartY;
+
+	for (auto lineIndex = firstLine; lineIndex < m_lines.size()
+			&& m_lines[lineIndex].charStartIndex < selectionEnd; ++lineIndex) {
+		auto lineX = get_line_x_start(lineIndex, textWidth, textXAlignment);
+		auto lineTop = firstLineY + (lineIndex == 0 ? 0.f : m_lines[lineIndex - 1].totalDescent)
+				- m_lines[lineIndex].ascent;
+		auto lineHeight = get_line_height(lineIndex);
+
+		// Runs of a line cover disjoint logical ranges, so in logical order both their starts and ends ascend
+		auto firstRunIndex = get_first_run_index(lineIndex);
+		auto lastRunIndex = m_lines[lineIndex].visualRunsEndIndex;
+		auto orderIndex = binary_search(firstRunIndex, lastRunIndex - firstRunIndex, [&](auto index) {
+			return m_visualRuns[m_logicalRunOrder[index]].charEndIndex <= selectionStart;
+		});
+
+		for (; orderIndex < lastRunIndex
+				&& m_visualRuns[m_logicalRunOrder[orderIndex]].charStartIndex < selectionEnd; ++orderIndex) {
+			auto runIndex = m_logicalRunOrder[orderIndex];
+
+			if (!run_contains_char_range(runIndex, selectionStart, selectionEnd)) {
+				continue;
+			}
+
+			auto [minPos, maxPos] = get_position_range_in_run(runIndex, selectionStart, selectionEnd);
+			rectsOut.push_back({
+				.x = lineX + minPos,
+				.y = lineTop,
+				.width = maxPos - minPos,
+				.height = lineHeight,
+			});
+		}
+	}
+}
+
 size_t LayoutInfo::get_closest_line_to_height(float y) const {
 	return binary_search(0, m_lines.size(), [&](auto index) {
 		return m_lines[index].totalDescent < y;
@@ -197,9 +302,57 @@ float LayoutInfo::get_line_x_start(size_t lineNumber, float textWidth, TextXAlig
 }
 
 CursorPosition LayoutInfo::find_closest_cursor_position(float textWidth, TextXAlignment textXAlignment,
-		icu::BreakIterator& iter, size_t lineNumber, float cursorX) const {
-	cursorX -= get_line_x_start(lineNumber, textWidth, textXAlignment);
+		size_t lineNumber, float cursorX) const {
+	uint32_t runIndex;
+	uint32_t glyphIndex;
+	return find_closest_cursor_in_line(lineNumber, cursorX - get_line_x_start(lineNumber, textWidth,
+			textXAlignment), runIndex, glyphIndex);
+}
+
+void LayoutInfo::hit_test(float textWidth, TextXAlignment textXAlignment, const float* points, size_t pointCount,
+		HitTestResult* resultsOut) const {
+	if (pointCount == 0) {
+		return;
+	}
+
+	if (m_lines.empty()) {
+		std::fill_n(resultsOut, pointCount, HitTestResult{});
+		return;
+	}
+
+	size_t lineIndex = 0;
+	float lineX = get_line_x_start(0, textWidth, textXAlignment);
+	float prevY = points[1];
+
+	for (size_t i = 0; i < pointCount; ++i) {
+		auto x = points[2 * i];
+		auto y = points[2 * i + 1];
+		auto prevLineIndex = lineIndex;
 
+		// Sorted points only ever move down, so the line is found by stepping forward from the last hit.
+		// Out of order points fall back to a full search.
+		if (y < prevY) {
+			lineIndex = std::min(get_closest_line_to_height(y), m_lines.size() - 1);
+		}
+		else {
+			while (lineIndex + 1 < m_lines.size() && m_lines[lineIndex].totalDescent < y) {
+				++lineIndex;
+			}
+		}
+
+		if (lineIndex != prevLineIndex) {
+			lineX = get_line_x_start(lineIndex, textWidth, textXAlignment);
+		}
+
+		auto& result = resultsOut[i];
+		result.cursor = find_closest_cursor_in_line(lineIndex, x - lineX, result.runIndex, result.glyphIndex);
+		result.lineIndex = static_cast<uint32_t>(lineIndex);
+		prevY = y;
+	}
+}
+
+CursorPosition LayoutInfo::find_closest_cursor_in_line(size_t lineNumber, float cursorX, uint32_t& outRunIndex,
+		uint32_t& outGlyphIndex) const {
 	// Find run containing char
 	auto firstRunIndex = get_first_run_index(lineNumber);
 	auto lastRunIndex = m_lines[lineNumber].visualRunsEndIndex;
@@ -209,8 +362,11 @@ CursorPosition LayoutInfo::find_closest_cursor_position(float textWidth, TextXAl
 	});
 
 	if (runIndex == lastRunIndex) {
-		return {m_visualRuns.back().rightToLeft ? m_visualRuns.back().charStartIndex
-				: m_visualRuns.back().charEndIndex + m_visualRuns.back().charEndOffset};
+		auto& lastRun = m_visualRuns[lastRunIndex - 1];
+		outRunIndex = lastRunIndex - 1;
+		outGlyphIndex = lastRun.glyphEndIndex == get_first_glyph_index(lastRunIndex - 1) ? lastRun.glyphEndIndex
+				: lastRun.glyphEndIndex - 1;
+		return {lastRun.rightToLeft ? lastRun.charStartIndex : lastRun.charEndIndex + lastRun.charEndOffset};
 	}
 
 	// Find closest glyph in run
@@ -223,6 +379,9 @@ CursorPosition LayoutInfo::find_closest_cursor_position(float textWidth, TextXAl
 		return m_glyphPositions[firstPosIndex + 2 * index] < cursorX;
 	});
 
+	outRunIndex = static_cast<uint32_t>(runIndex);
+	outGlyphIndex = glyphIndex == firstGlyphIndex ? glyphIndex : glyphIndex - 1;
+
 	// Find visual and logical bounds of the current glyph's cluster
 	uint32_t clusterStartChar;
 	uint32_t clusterEndChar;
@@ -269,7 +428,7 @@ CursorPosition LayoutInfo::find_closest_cursor_position(float textWidth, TextXAl
 	auto currPos = clusterStartPos;
 
 	for (;;) {
-		auto nextCharIndex = iter.following(currCharIndex);
+		auto nextCharIndex = std::min(m_graphemeBoundaries.next(currCharIndex), clusterEndChar);
 		auto nextPos = clusterStartPos + static_cast<float>(nextCharIndex - clusterStartChar)
 				/ static_cast<float>(clusterEndChar - clusterStartChar)
 				* (clusterEndPos - clusterStartPos);
@@ -409,6 +568,14 @@ size_t LayoutInfo::get_char_index_count() const {
 	return m_charIndices.size();
 }
 
+const BoundaryBitset& LayoutInfo::get_grapheme_boundaries() const {
+	return m_graphemeBoundaries;
+}
+
+const BoundaryBitset& LayoutInfo::get_word_boundaries() const {
+	return m_wordBoundaries;
+}
+
 float LayoutInfo::get_text_start_y() const {
 	return m_textStartY;
 }
@@ -433,6 +600,23 @@ size_t LayoutInfo::get_glyph_position_data_count() const {
 	return m_glyphPositions.size();
 }
 
+void LayoutInfo::append_line_index(uint32_t firstRunIndex) {
+	auto& line = m_lines.back();
+	line.charStartIndex = m_visualRuns[firstRunIndex].charStartIndex;
+	line.charEndIndex = m_visualRuns[firstRunIndex].charEndIndex + m_visualRuns[firstRunIndex].charEndOffset;
+
+	for (auto i = firstRunIndex; i < line.visualRunsEndIndex; ++i) {
+		auto& run = m_visualRuns[i];
+		line.charStartIndex = std::min(line.charStartIndex, run.charStartIndex);
+		line.charEndIndex = std::max(line.charEndIndex, run.charEndIndex + run.charEndOffset);
+		m_logicalRunOrder.emplace_back(i);
+	}
+
+	std::sort(m_logicalRunOrder.begin() + firstRunIndex, m_logicalRunOrder.end(), [&](auto a, auto b) {
+		return m_visualRuns[a].charStartIndex < m_visualRuns[b].charStartIndex;
+	});
+}
+
 float LayoutInfo::get_glyph_offset_ltr(size_t runIndex, uint32_t cursor) const {
 	auto firstGlyphIndex = get_first_glyph_index(runIndex);
 	auto lastGlyphIndex = m_visualRuns[runIndex].glyphEndIndex;
@@ -491,8 +675,61 @@ float LayoutInfo::get_glyph_offset_rtl(size_t runIndex, uint32_t cursor) const {
 	return glyphOffset;
 }
 
+void LayoutInfo::compute_text_boundaries(UText* pText, int32_t count) {
+	auto textLength = static_cast<uint32_t>(count);
+	m_graphemeBoundaries.reset(textLength);
+	m_wordBoundaries.reset(textLength);
+
+	m_graphemeBoundaries.set(0);
+	m_wordBoundaries.set(0);
+	m_wordBoundaries.set(textLength);
+
+	if (count == 0) {
+		return;
+	}
+
+	UErrorCode err{U_ZERO_ERROR};
+	auto* pIter = get_character_break_iterator();
+	pIter->setText(pText, err);
+
+	// Word boundaries are only considered at grapheme boundaries, judged by the first code point of each cluster
+	bool prevWhitespace = u_isWhitespace(utext_char32At(pText, 0));
+
+	for (auto index = pIter->next(); index != icu::BreakIterator::DONE && index < count; index = pIter->next()) {
+		m_graphemeBoundaries.set(static_cast<uint32_t>(index));
+
+		auto c = utext_char32At(pText, index);
+		bool whitespace = u_isWhitespace(c);
+
+		if ((!whitespace && prevWhitespace) || is_line_break(c)) {
+			m_wordBoundaries.set(static_cast<uint32_t>(index));
+		}
+
+		prevWhitespace = whitespace;
+	}
+
+	m_graphemeBoundaries.set(textLength);
+
+	// Don't keep a reference to the caller's text
+	pIter->setText(icu::UnicodeString());
+}
+
 // Static Functions
 
+static bool is_line_break(UChar32 c) {
+	return c == CH_LF || c == CH_CR || c == CH_LSEP || c == CH_PSEP;
+}
+
+static icu::BreakIterator* get_character_break_iterator() {
+	thread_local std::unique_ptr<icu::BreakIterator> t_iter = [] {
+		UErrorCode err{U_ZERO_ERROR};
+		return std::unique_ptr<icu::BreakIterator>(icu::BreakIterator::createCharacterInstance(
+				icu::Locale::getDefault(), err));
+	}();
+
+	return t_iter.get();
+}
+
 static bool affinity_prefer_prev_run(bool atLineBreak, bool atSoftLineBreak, bool prevRunRTL, bool nextRunRTL,
 		CursorAffinity affinity) {
 	// Case 1: Current run is at a soft line break
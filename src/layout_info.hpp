@@ -1,5 +1,6 @@
 #pragma once
 
+#include "boundary_bitset.hpp"
 #include "common.hpp"
 #include "cursor_position.hpp"
 #include "text_alignment.hpp"
@@ -9,13 +10,9 @@
 
 #include <cstdint>
 
-#include <unicode/uversion.h>
+#include <vector>
 
-U_NAMESPACE_BEGIN
-
-class BreakIterator;
-
-U_NAMESPACE_END
+struct UText;
 
 namespace Text {
 
@@ -35,12 +32,31 @@ struct VisualCursorInfo {
 	uint32_t lineNumber;
 };
 
+struct HitTestResult {
+	CursorPosition cursor;
+	uint32_t lineIndex;
+	uint32_t runIndex;
+	// The glyph under the point, clamped to the run. Equal to the run's glyph end index if the run is empty.
+	uint32_t glyphIndex;
+};
+
+struct SelectionRect {
+	float x;
+	float y;
+	float width;
+	float height;
+};
+
 class LayoutInfo {
 	public:
 		/**
 		 * @brief Clears all layout information contained within the object.
 		 */
 		void clear();
+		/**
+		 * @brief Clears the lines, runs and glyphs, keeping the text boundaries for a relayout of the same text.
+		 */
+		void clear_lines();
 		void reserve_runs(size_t runCount);
 
 		void append_glyph(uint32_t glyphID);
@@ -53,6 +69,13 @@ class LayoutInfo {
 		void set_run_char_end_offset(size_t runIndex, uint8_t charEndOffset);
 		void set_text_start_y(float);
 
+		/**
+		 * Computes the grapheme cluster and word boundaries of the laid out text. Called by the layout builders,
+		 * `chars` must be the same text the layout was built from.
+		 */
+		void compute_text_boundaries(const char* chars, int32_t count);
+		void compute_text_boundaries(const char16_t* chars, int32_t count);
+
 		/**
 		 * Calculates the pixel position, height, and line number of the text cursor given the provided
 		 * `CursorPosition`.
@@ -76,6 +99,14 @@ class LayoutInfo {
 		 */
 		size_t get_run_containing_cursor(CursorPosition cursorPosition, size_t& outLineNumber) const;
 
+		/**
+		 * Appends the highlight rectangles covering the character range [selectionStart, selectionEnd) to
+		 * `rectsOut`, one per intersected run. Only the lines intersecting the range are visited. Rectangles are
+		 * relative to the text area origin and span the full height of their line.
+		 */
+		void get_selection_rects(float textWidth, TextXAlignment textXAlignment, uint32_t selectionStart,
+				uint32_t selectionEnd, std::vector<SelectionRect>& rectsOut) const;
+
 		/**
 		 * Gets the index of the line closest to the pixel height `y`. Heights above the first linewill always
 		 * return 0, and heights past the end of the last line will return the index of the last line.
@@ -85,8 +116,17 @@ class LayoutInfo {
 		CursorPosition get_line_start_position(size_t lineIndex) const;
 		CursorPosition get_line_end_position(size_t lineIndex) const;
 
-		CursorPosition find_closest_cursor_position(float textWidth, TextXAlignment, icu::BreakIterator&,
-				size_t lineNumber, float cursorX) const;
+		CursorPosition find_closest_cursor_position(float textWidth, TextXAlignment, size_t lineNumber,
+				float cursorX) const;
+
+		/**
+		 * Resolves the closest cursor position to each of `pointCount` points, stored as interleaved x, y pairs
+		 * in the same space as `find_closest_cursor_position` and `get_closest_line_to_height`. Points sorted by
+		 * y are resolved in a single forward sweep over the lines; unsorted points are still handled correctly,
+		 * with a line search for each point that moves back up.
+		 */
+		void hit_test(float textWidth, TextXAlignment, const float* points, size_t pointCount,
+				HitTestResult* resultsOut) const;
 
 		float get_line_x_start(size_t lineIndex, float textWidth, TextXAlignment) const;
 
@@ -139,6 +179,16 @@ class LayoutInfo {
 		size_t get_glyph_count() const;
 		size_t get_char_index_count() const;
 
+		/**
+		 * Grapheme cluster boundaries, the valid cursor positions within the text.
+		 */
+		const BoundaryBitset& get_grapheme_boundaries() const;
+		/**
+		 * Word boundaries used for word-wise cursor movement: the start and end of the text, the first
+		 * non-whitespace grapheme after whitespace, and line break characters.
+		 */
+		const BoundaryBitset& get_word_boundaries() const;
+
 		uint32_t get_glyph_id(uint32_t glyphIndex) const;
 		uint32_t get_char_index(uint32_t glyphIndex) const;
 
@@ -163,6 +213,10 @@ class LayoutInfo {
 
 		struct LineInfo {
 			uint32_t visualRunsEndIndex;
+			// Logical code unit range covered by the line's runs, including any trailing separator. Lines are
+			// stored in logical order, so these ranges are sorted and can be binary searched.
+			uint32_t charStartIndex;
+			uint32_t charEndIndex;
 			float width;
 			float ascent;
 			// Total descent from the top of the paragraph to the bottom of this line. The difference between
@@ -175,8 +229,20 @@ class LayoutInfo {
 		std::vector<uint32_t> m_glyphs;
 		std::vector<uint32_t> m_charIndices;
 		std::vector<float> m_glyphPositions;
+		// Per line, the line's visual run indices sorted by charStartIndex. Shares the index space of
+		// `m_visualRuns`, so the logical order of line `i` starts at `get_first_run_index(i)`.
+		std::vector<uint32_t> m_logicalRunOrder;
+		BoundaryBitset m_graphemeBoundaries;
+		BoundaryBitset m_wordBoundaries;
 		float m_textStartY{};
 
+		void compute_text_boundaries(UText*, int32_t count);
+
+		void append_line_index(uint32_t firstRunIndex);
+
+		CursorPosition find_closest_cursor_in_line(size_t lineNumber, float cursorX, uint32_t& outRunIndex,
+				uint32_t& outGlyphIndex) const;
+
 		float get_glyph_offset_ltr(size_t runIndex, uint32_t cursor) const;
 		float get_glyph_offset_rtl(size_t runIndex, uint32_t cursor) const;
 };
@@ -202,6 +268,13 @@ void build_layout_info_utf8(LayoutInfo& result, const char* chars, int32_t count
 		const ValueRuns<Font>& fontRuns, float textAreaWidth, float textAreaHeight,
 		TextYAlignment textYAlignment, LayoutInfoFlags flags);
 
+/**
+ * @brief Builds the paragraph layout from UTF-16 text using SheenBidi and the native script run iterator
+ */
+void build_layout_info_utf16(LayoutInfo& result, const char16_t* chars, int32_t count,
+		const ValueRuns<Font>& fontRuns, float textAreaWidth, float textAreaHeight,
+		TextYAlignment textYAlignment, LayoutInfoFlags flags);
+
 /**
  * @brief Converts a UTF-16 LayoutInfo to UTF-8 based indices 
  */
@@ -212,6 +285,10 @@ void convert_layout_info_to_utf8(const LayoutInfo& src, LayoutInfo& result, cons
 
 template <typename Functor>
 void Text::LayoutInfo::for_each_line(float textWidth, TextXAlignment textXAlignment, Functor&& func) const {
+	if (m_lines.empty()) {
+		return;
+	}
+
 	auto lineY = m_lines.front().ascent + m_textStartY;
 
 	for (size_t i = 0; i < m_lines.size(); ++i) {
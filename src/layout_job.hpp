@@ -0,0 +1,84 @@
+#pragma once
+
+#include "font.hpp"
+#include "layout_info.hpp"
+#include "value_runs.hpp"
+
+#include <cstdint>
+
+#include <chrono>
+#include <memory>
+
+namespace Text {
+
+/**
+ * Limits on the work done by a single `LayoutJob::resume` call. A limit of 0 is not enforced. At least one
+ * paragraph is laid out per call regardless of the limits, so that every call makes progress.
+ */
+struct LayoutJobBudget {
+	/**
+	 * Stop once this much time has passed since the call began.
+	 */
+	std::chrono::nanoseconds time;
+	/**
+	 * Stop once this many code units have been laid out in the call.
+	 */
+	int32_t codeUnits;
+};
+
+enum class LayoutJobStatus : uint8_t {
+	PARTIAL,
+	COMPLETE,
+};
+
+/**
+ * `build_layout_info_utf8` split into steps at paragraph boundaries, for laying out large texts progressively on a
+ * single thread. Each `resume` call lays out paragraphs until its budget is spent. Between calls, `result` holds
+ * every line laid out so far, with text boundaries for the whole text and vertical alignment applied to the lines
+ * present. Once complete, `result` is identical to the output of `build_layout_info_utf8`.
+ *
+ * The first `resume` call also computes text boundaries for the whole text, a single pass over it that cannot be
+ * split. Bidi paragraph boundaries are found one paragraph at a time as the job reaches them.
+ *
+ * `result`, `chars` and `fontRuns` must stay alive and unmodified until the job completes or is destroyed.
+ *
+ * @thread_safety A job may be resumed from any thread, but not from several at once.
+ */
+class LayoutJob final {
+	public:
+		explicit LayoutJob(LayoutInfo& result, const char* chars, int32_t count, const ValueRuns<Font>& fontRuns,
+				float textAreaWidth, float textAreaHeight, TextYAlignment textYAlignment, LayoutInfoFlags flags);
+		~LayoutJob();
+
+		LayoutJob(LayoutJob&&) = delete;
+		void operator=(LayoutJob&&) = delete;
+
+		LayoutJob(const LayoutJob&) = delete;
+		void operator=(const LayoutJob&) = delete;
+
+		LayoutJobStatus resume(const LayoutJobBudget& budget);
+
+		bool is_complete() const;
+
+		/**
+		 * Returns the number of code units laid out so far, out of the `count` passed to the constructor.
+		 */
+		int32_t get_progress() const;
+	private:
+		struct State;
+
+		LayoutInfo& m_result;
+		const char* m_chars;
+		int32_t m_count;
+		const ValueRuns<Font>& m_fontRuns;
+		float m_textAreaWidth;
+		float m_textAreaHeight;
+		TextYAlignment m_textYAlignment;
+		LayoutInfoFlags m_flags;
+		// Created by the first `resume` call, and released once the job completes
+		std::unique_ptr<State> m_state;
+		int32_t m_progress{};
+		bool m_complete{};
+};
+
+}
@@ -0,0 +1,156 @@
+#include "layout_service.hpp"
+
+#include "layout_job.hpp"
+
+using namespace Text;
+
+// Code units laid out between checks for a superseded request, rounded up to a paragraph boundary
+static constexpr const int32_t CANCEL_CHECK_CODE_UNITS = 4096;
+
+static void build_layout(LayoutInfo& result, const LayoutRequest& request);
+
+// Public Functions
+
+LayoutService::LayoutService(LayoutServiceMode mode)
+		: m_executor(get_executor())
+		, m_mode(mode) {}
+
+LayoutService::~LayoutService() {
+	{
+		std::scoped_lock lock(m_mutex);
+		m_stopping = true;
+	}
+
+	m_executor.wait(m_tasks);
+}
+
+uint64_t LayoutService::submit(OwnerID owner, LayoutRequest&& request) {
+	uint64_t generation;
+	bool startDrain = false;
+
+	{
+		std::scoped_lock lock(m_mutex);
+		generation = m_nextGeneration++;
+		m_latestGenerations[owner] = generation;
+
+		if (m_mode == LayoutServiceMode::BACKGROUND) {
+			m_pending.insert_or_assign(owner, PendingRequest{std::move(request), generation});
+			startDrain = !m_draining;
+			m_draining = true;
+		}
+	}
+
+	if (m_mode == LayoutServiceMode::SYNCHRONOUS) {
+		LayoutResult result{.generation = generation};
+		build_layout(result.layout, request);
+
+		std::scoped_lock lock(m_mutex);
+		publish_locked(owner, std::move(result));
+	}
+	else if (startDrain) {
+		m_executor.submit(m_tasks, [this] { drain_requests(); });
+	}
+
+	return generation;
+}
+
+void LayoutService::cancel(OwnerID owner) {
+	{
+		std::scoped_lock lock(m_mutex);
+		m_pending.erase(owner);
+		m_backResults.erase(owner);
+		// An in progress layout sees its generation is no longer current and discards its result
+		m_latestGenerations.erase(owner);
+	}
+
+	m_idleSignal.notify_all();
+}
+
+bool LayoutService::swap_buffers() {
+	std::scoped_lock lock(m_mutex);
+
+	if (m_backResults.empty()) {
+		return false;
+	}
+
+	for (auto& [owner, result] : m_backResults) {
+		m_frontResults.insert_or_assign(owner, std::move(result));
+	}
+
+	m_backResults.clear();
+
+	return true;
+}
+
+LayoutResult* LayoutService::get_result(OwnerID owner) {
+	if (auto it = m_frontResults.find(owner); it != m_frontResults.end()) {
+		return &it->second;
+	}
+
+	return nullptr;
+}
+
+void LayoutService::remove_result(OwnerID owner) {
+	m_frontResults.erase(owner);
+}
+
+void LayoutService::wait_idle() {
+	std::unique_lock lock(m_mutex);
+	m_idleSignal.wait(lock, [&] { return !m_draining; });
+}
+
+// A single task drains the queue at a time, so requests are laid out in order without holding an executor worker
+// while the service is idle
+void LayoutService::drain_requests() {
+	std::unique_lock lock(m_mutex);
+
+	while (!m_stopping && !m_pending.empty()) {
+		auto node = m_pending.extract(m_pending.begin());
+		auto owner = node.key();
+		auto& pending = node.mapped();
+
+		lock.unlock();
+
+		LayoutResult result{.generation = pending.generation};
+		auto& request = pending.request;
+		LayoutJob job(result.layout, request.text.data(), static_cast<int32_t>(request.text.size()),
+				request.fontRuns, request.textAreaWidth, request.textAreaHeight, request.textYAlignment,
+				request.flags);
+
+		while (job.resume({.codeUnits = CANCEL_CHECK_CODE_UNITS}) == LayoutJobStatus::PARTIAL) {
+			std::scoped_lock checkLock(m_mutex);
+
+			if (m_stopping || !is_current_locked(owner, pending.generation)) {
+				break;
+			}
+		}
+
+		lock.lock();
+
+		if (job.is_complete()) {
+			publish_locked(owner, std::move(result));
+		}
+	}
+
+	m_draining = false;
+	m_idleSignal.notify_all();
+}
+
+void LayoutService::publish_locked(OwnerID owner, LayoutResult&& result) {
+	if (is_current_locked(owner, result.generation)) {
+		m_backResults.insert_or_assign(owner, std::move(result));
+	}
+}
+
+bool LayoutService::is_current_locked(OwnerID owner, uint64_t generation) const {
+	auto it = m_latestGenerations.find(owner);
+	return it != m_latestGenerations.end() && it->second == generation;
+}
+
+// Static Functions
+
+static void build_layout(LayoutInfo& result, const LayoutRequest& request) {
+	build_layout_info_utf8(result, request.text.data(), static_cast<int32_t>(request.text.size()),
+			request.fontRuns, request.textAreaWidth, request.textAreaHeight, request.textYAlignment,
+			request.flags);
+}
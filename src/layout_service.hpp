@@ -0,0 +1,123 @@
+#pragma once
+
+#include "executor.hpp"
+#include "font.hpp"
+#include "layout_info.hpp"
+#include "value_runs.hpp"
+
+#include <cstdint>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Text {
+
+enum class LayoutServiceMode : uint8_t {
+	// Requests are laid out by tasks on the installed `Executor`
+	BACKGROUND,
+	// Requests are laid out inside `submit`, for tests and tools that need results immediately
+	SYNCHRONOUS,
+};
+
+/**
+ * Arguments to `build_layout_info_utf8`, owned by the request so that the caller's text may change while the
+ * layout is pending.
+ */
+struct LayoutRequest {
+	std::string text;
+	ValueRuns<Font> fontRuns;
+	float textAreaWidth;
+	float textAreaHeight;
+	TextYAlignment textYAlignment;
+	LayoutInfoFlags flags;
+};
+
+struct LayoutResult {
+	LayoutInfo layout;
+	// The value returned by the `submit` call that produced this layout
+	uint64_t generation;
+};
+
+/**
+ * Builds layouts off the UI thread, on the `Executor` installed when the service is created. Each request is
+ * tagged by an owner, and a request replaces any pending request of the same owner, so a burst of edits or resizes
+ * costs a single layout. A request that is superseded while it is being laid out is abandoned at the next
+ * paragraph boundary, see `LayoutJob`.
+ *
+ * Finished layouts are published in two buffers: background tasks fill the back buffer, and `swap_buffers`, called
+ * at frame start, moves its results to the front buffer where `get_result` reads them without locking. Front
+ * buffer results stay in place until the next swap replaces them or the owner removes them.
+ *
+ * @thread_safety `submit`, `cancel` and `wait_idle` are thread safe. `swap_buffers`, `get_result` and
+ * `remove_result` must only be called from the thread consuming results.
+ */
+class LayoutService final {
+	public:
+		using OwnerID = uint64_t;
+
+		explicit LayoutService(LayoutServiceMode mode = LayoutServiceMode::BACKGROUND);
+		~LayoutService();
+
+		LayoutService(LayoutService&&) = delete;
+		void operator=(LayoutService&&) = delete;
+
+		LayoutService(const LayoutService&) = delete;
+		void operator=(const LayoutService&) = delete;
+
+		/**
+		 * Queues a layout for `owner`, replacing its pending request if any. Returns the generation that the
+		 * resulting `LayoutResult` will carry, which increases with every call.
+		 */
+		uint64_t submit(OwnerID owner, LayoutRequest&& request);
+
+		/**
+		 * Drops the pending request of `owner` and discards the result of any request of it in progress. Results
+		 * already in the back buffer are discarded as well, for owners switching to a synchronous layout.
+		 */
+		void cancel(OwnerID owner);
+
+		/**
+		 * Publishes finished layouts to the front buffer. Returns whether any result was published.
+		 */
+		bool swap_buffers();
+
+		/**
+		 * Gets the latest published layout of `owner`, or null if there is none. Owners may move the layout out.
+		 */
+		LayoutResult* get_result(OwnerID owner);
+		void remove_result(OwnerID owner);
+
+		/**
+		 * Blocks until no request is pending or in progress. Results still need to be published by
+		 * `swap_buffers`.
+		 */
+		void wait_idle();
+	private:
+		struct PendingRequest {
+			LayoutRequest request;
+			uint64_t generation;
+		};
+
+		Executor& m_executor;
+		TaskGroup m_tasks;
+		std::mutex m_mutex;
+		std::condition_variable m_idleSignal;
+		std::unordered_map<OwnerID, PendingRequest> m_pending;
+		// Generation of each owner's newest request, results of older generations are stale
+		std::unordered_map<OwnerID, uint64_t> m_latestGenerations;
+		std::unordered_map<OwnerID, LayoutResult> m_backResults;
+		std::unordered_map<OwnerID, LayoutResult> m_frontResults;
+		uint64_t m_nextGeneration{1};
+		LayoutServiceMode m_mode;
+		// Whether a task draining `m_pending` is queued or running
+		bool m_draining{};
+		bool m_stopping{};
+
+		void drain_requests();
+		void publish_locked(OwnerID owner, LayoutResult&& result);
+		bool is_current_locked(OwnerID owner, uint64_t generation) const;
+};
+
+}
@@ -0,0 +1,108 @@
+#include "msdf_batch.hpp"
+
+#include "executor.hpp"
+#include "font_registry.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+using namespace Text;
+
+// Glyphs are claimed in small chunks to balance large and small outlines without contending on the counter
+static constexpr const size_t GLYPHS_PER_CLAIM = 8;
+
+namespace {
+
+struct WorkerOutput {
+	std::vector<uint8_t> pixels;
+};
+
+struct GlyphLocation {
+	uint32_t workerIndex;
+	size_t dataOffset;
+};
+
+}
+
+static void generate_worker(const MSDFBatchGlyph* pGlyphs, size_t glyphCount, std::atomic_size_t& nextGlyph,
+		uint32_t workerIndex, WorkerOutput& output, MSDFBatchGlyphResult* pResults, GlyphLocation* pLocations);
+
+// Public Functions
+
+MSDFBatchResult Text::generate_msdf_batch(const MSDFBatchGlyph* pGlyphs, size_t glyphCount,
+		uint32_t threadCount) {
+	MSDFBatchResult result{};
+	result.glyphs.resize(glyphCount);
+
+	if (glyphCount == 0) {
+		return result;
+	}
+
+	auto& executor = get_executor();
+
+	if (threadCount == 0) {
+		threadCount = executor.get_worker_count();
+	}
+
+	threadCount = static_cast<uint32_t>(std::min<size_t>(threadCount,
+			(glyphCount + GLYPHS_PER_CLAIM - 1) / GLYPHS_PER_CLAIM));
+
+	std::vector<WorkerOutput> workerOutputs(threadCount);
+	std::vector<GlyphLocation> locations(glyphCount);
+	std::atomic_size_t nextGlyph{0};
+
+	run_on_workers(executor, threadCount, [&](uint32_t workerIndex) {
+		generate_worker(pGlyphs, glyphCount, nextGlyph, workerIndex, workerOutputs[workerIndex],
+				result.glyphs.data(), locations.data());
+	});
+
+	// Concatenate worker outputs and rebase glyph offsets
+	std::vector<size_t> workerBases(threadCount);
+	size_t totalSize = 0;
+
+	for (uint32_t i = 0; i < threadCount; ++i) {
+		workerBases[i] = totalSize;
+		totalSize += workerOutputs[i].pixels.size();
+	}
+
+	result.pixels.resize(totalSize);
+
+	for (uint32_t i = 0; i < threadCount; ++i) {
+		if (!workerOutputs[i].pixels.empty()) {
+			std::memcpy(result.pixels.data() + workerBases[i], workerOutputs[i].pixels.data(),
+					workerOutputs[i].pixels.size());
+		}
+	}
+
+	for (size_t i = 0; i < glyphCount; ++i) {
+		result.glyphs[i].dataOffset = workerBases[locations[i].workerIndex] + locations[i].dataOffset;
+	}
+
+	return result;
+}
+
+// Static Functions
+
+static void generate_worker(const MSDFBatchGlyph* pGlyphs, size_t glyphCount, std::atomic_size_t& nextGlyph,
+		uint32_t workerIndex, WorkerOutput& output, MSDFBatchGlyphResult* pResults, GlyphLocation* pLocations) {
+	for (;;) {
+		auto first = nextGlyph.fetch_add(GLYPHS_PER_CLAIM, std::memory_order_relaxed);
+
+		if (first >= glyphCount) {
+			break;
+		}
+
+		for (size_t i = first, l = std::min(first + GLYPHS_PER_CLAIM, glyphCount); i < l; ++i) {
+			auto& glyph = pGlyphs[i];
+			auto& glyphResult = pResults[i];
+			pLocations[i] = {workerIndex, output.pixels.size()};
+
+			// FontData is cached per thread, so each worker drives its own FT_Face
+			if (auto fontData = FontRegistry::get_font_data(glyph.font)) {
+				fontData.get_msdf_glyph_rgb8(glyph.glyphIndex, output.pixels, glyphResult.width,
+						glyphResult.height, glyphResult.offset);
+			}
+		}
+	}
+}
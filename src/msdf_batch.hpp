@@ -0,0 +1,44 @@
+#pragma once
+
+#include "font.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+
+namespace Text {
+
+struct MSDFBatchGlyph {
+	SingleScriptFont font;
+	uint32_t glyphIndex;
+};
+
+/**
+ * Location of a single generated glyph within `MSDFBatchResult::pixels`. Glyphs with no outline have a width and
+ * height of 0. `offset` is in em units, see `FontData::get_msdf_glyph`.
+ */
+struct MSDFBatchGlyphResult {
+	size_t dataOffset;
+	uint32_t width;
+	uint32_t height;
+	float offset[2];
+};
+
+struct MSDFBatchResult {
+	std::vector<uint8_t> pixels;
+	std::vector<MSDFBatchGlyphResult> glyphs;
+};
+
+/**
+ * Generates MSDFs for all `glyphCount` glyphs in `pGlyphs`, distributing them across the workers of the installed
+ * `Executor`. Each output glyph is stored as tightly packed RGB8 rows in `MSDFBatchResult::pixels`, and
+ * `MSDFBatchResult::glyphs[i]` describes input glyph `i`.
+ *
+ * @param threadCount The maximum number of workers to use, or 0 to use the executor's worker count
+ * @thread_safety Thread safe
+ */
+[[nodiscard]] MSDFBatchResult generate_msdf_batch(const MSDFBatchGlyph* pGlyphs, size_t glyphCount,
+		uint32_t threadCount = 0);
+
+}
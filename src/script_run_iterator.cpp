@@ -18,6 +18,12 @@
 #include "script_run_iterator.hpp"
 
 #include <unicode/utf8.h>
+#include <unicode/utf16.h>
+
+#include <cstdint>
+
+// Generated at build time by tools/gen_script_table.cpp
+#include "script_table.inc"
 
 #define MOD(sp) ((sp) % PAREN_STACK_DEPTH)
 #define LIMIT_INC(sp) (((sp) < PAREN_STACK_DEPTH)? (sp) + 1 : PAREN_STACK_DEPTH)
@@ -29,32 +35,33 @@
 #define STACK_IS_NOT_EMPTY(scriptRun) (! STACK_IS_EMPTY(scriptRun))
 #define TOP(scriptRun) ((scriptRun)->parenStack[(scriptRun)->parenSP])
 
-static constexpr const UChar32 pairedChars[] = {
-	0x0028, 0x0029, /* ascii paired punctuation */
-	0x003c, 0x003e,
-	0x005b, 0x005d,
-	0x007b, 0x007d,
-	0x00ab, 0x00bb, /* guillemets */
-	0x2018, 0x2019, /* general punctuation */
-	0x201c, 0x201d,
-	0x2039, 0x203a,
-	0x3008, 0x3009, /* chinese paired punctuation */
-	0x300a, 0x300b,
-	0x300c, 0x300d,
-	0x300e, 0x300f,
-	0x3010, 0x3011,
-	0x3014, 0x3015,
-	0x3016, 0x3017,
-	0x3018, 0x3019,
-	0x301a, 0x301b
+namespace {
+
+struct ScriptProperties {
+	UScriptCode script;
+	int32_t pairIndex;
 };
 
-static int8_t high_bit(int32_t value);
-static int32_t get_pair_index(UChar32 ch);
+}
+
+static ScriptProperties decode_script_properties(const char* text, int32_t& index, int32_t textLength);
+static ScriptProperties decode_script_properties(const char16_t* text, int32_t& index, int32_t textLength);
+static ScriptProperties lookup_script_properties(uint32_t c);
+static ScriptProperties unpack_script_properties(uint16_t entry);
 static UBool script_is_same(UScriptCode scriptOne, UScriptCode scriptTwo);
 
 ScriptRunIterator::ScriptRunIterator(const char* text, int32_t textLength)
 		: m_text{text}
+		, m_text16{}
+		, m_textLength{textLength}
+		, m_scriptLimit{}
+		, m_parenSP{-1}
+		, m_pushCount{}
+		, m_fixupCount{} {}
+
+ScriptRunIterator::ScriptRunIterator(const char16_t* text, int32_t textLength)
+		: m_text{}
+		, m_text16{text}
 		, m_textLength{textLength}
 		, m_scriptLimit{}
 		, m_parenSP{-1}
@@ -62,6 +69,16 @@ ScriptRunIterator::ScriptRunIterator(const char* text, int32_t textLength)
 		, m_fixupCount{} {}
 
 bool ScriptRunIterator::next(int32_t& outRunStart, int32_t& outRunLimit, UScriptCode& outRunScript) {
+	if (m_text16) {
+		return next_internal(m_text16, outRunStart, outRunLimit, outRunScript);
+	}
+
+	return next_internal(m_text, outRunStart, outRunLimit, outRunScript);
+}
+
+template <typename CharT>
+bool ScriptRunIterator::next_internal(const CharT* text, int32_t& outRunStart, int32_t& outRunLimit,
+		UScriptCode& outRunScript) {
 	/* if we've fallen off the end of the text, we're done */
 	if (m_scriptLimit >= m_textLength) {
 		return false;
@@ -71,13 +88,10 @@ bool ScriptRunIterator::next(int32_t& outRunStart, int32_t& outRunLimit, UScript
 
 	auto scriptStart = m_scriptLimit;
 	UScriptCode scriptCode = USCRIPT_COMMON;
-	UChar32 ch;
-	UErrorCode err{};
 
 	for (; m_scriptLimit < m_textLength;) {
-		U8_GET((const uint8_t*)m_text, 0, m_scriptLimit, m_textLength, ch);
-		auto sc = uscript_getScript(ch, &err);
-		auto pairIndex = get_pair_index(ch);
+		auto nextLimit = m_scriptLimit;
+		auto [sc, pairIndex] = decode_script_properties(text, nextLimit, m_textLength);
 
 		/*
 		 * Paired character handling:
@@ -122,7 +136,7 @@ bool ScriptRunIterator::next(int32_t& outRunStart, int32_t& outRunLimit, UScript
 			break;
 		}
 
-		U8_FWD_1(m_text, m_scriptLimit, m_textLength);
+		m_scriptLimit = nextLimit;
 	}
 
 	outRunStart = scriptStart;
@@ -170,66 +184,56 @@ void ScriptRunIterator::fixup(UScriptCode scriptCode) {
 	}
 }
 
-static int8_t high_bit(int32_t value) {
-	int8_t bit = 0;
+// Decodes the code point at `index` and looks up its script and paired character index in one step, advancing
+// `index` past it. Ill-formed sequences map to USCRIPT_INVALID_CODE, which matches any script.
+static ScriptProperties decode_script_properties(const char* text, int32_t& index, int32_t textLength) {
+	auto lead = static_cast<uint8_t>(text[index]);
 
-	if (value <= 0) {
-		return -32;
+	if (lead < 0x80) {
+		++index;
+		return unpack_script_properties(SCRIPT_TABLE_LATIN1[lead]);
 	}
 
-	if (value >= 1 << 16) {
-		value >>= 16;
-		bit += 16;
-	}
-
-	if (value >= 1 << 8) {
-		value >>= 8;
-		bit += 8;
-	}
-
-	if (value >= 1 << 4) {
-		value >>= 4;
-		bit += 4;
-	}
-
-	if (value >= 1 << 2) {
-		value >>= 2;
-		bit += 2;
-	}
+	UChar32 ch;
+	U8_NEXT(reinterpret_cast<const uint8_t*>(text), index, textLength, ch);
 
-	if (value >= 1 << 1) {
-		//value >>= 1;
-		bit += 1;
+	if (ch < 0) {
+		return {USCRIPT_INVALID_CODE, -1};
 	}
 
-	return bit;
+	return lookup_script_properties(static_cast<uint32_t>(ch));
 }
 
-static int32_t get_pair_index(UChar32 ch) {
-	int32_t pairedCharCount = sizeof(pairedChars) / sizeof(UChar32);
-	int32_t pairedCharPower = 1 << high_bit(pairedCharCount);
-	int32_t pairedCharExtra = pairedCharCount - pairedCharPower;
+// UTF-16 counterpart of the above. Unpaired surrogates are looked up as code points, as `uscript_nextRun` does.
+static ScriptProperties decode_script_properties(const char16_t* text, int32_t& index, int32_t textLength) {
+	auto unit = static_cast<uint32_t>(text[index]);
 
-	int32_t probe = pairedCharPower;
-	int32_t pairIndex = 0;
-
-	if (ch >= pairedChars[pairedCharExtra]) {
-		pairIndex = pairedCharExtra;
+	if (unit < SCRIPT_TABLE_LATIN1_LIMIT) {
+		++index;
+		return unpack_script_properties(SCRIPT_TABLE_LATIN1[unit]);
 	}
 
-	while (probe > (1 << 0)) {
-		probe >>= 1;
+	UChar32 ch;
+	U16_NEXT(text, index, textLength, ch);
 
-		if (ch >= pairedChars[pairIndex + probe]) {
-			pairIndex += probe;
-		}
-	}
+	return lookup_script_properties(static_cast<uint32_t>(ch));
+}
 
-	if (pairedChars[pairIndex] != ch) {
-		pairIndex = -1;
+static ScriptProperties lookup_script_properties(uint32_t c) {
+	if (c < SCRIPT_TABLE_LATIN1_LIMIT) {
+		return unpack_script_properties(SCRIPT_TABLE_LATIN1[c]);
 	}
 
-	return pairIndex;
+	auto block = static_cast<uint32_t>(SCRIPT_TABLE_STAGE1[c >> SCRIPT_TABLE_BLOCK_SHIFT]);
+	return unpack_script_properties(SCRIPT_TABLE_STAGE2[(block << SCRIPT_TABLE_BLOCK_SHIFT)
+			| (c & ((1u << SCRIPT_TABLE_BLOCK_SHIFT) - 1))]);
+}
+
+static ScriptProperties unpack_script_properties(uint16_t entry) {
+	return {
+		.script = static_cast<UScriptCode>(entry & SCRIPT_TABLE_SCRIPT_MASK),
+		.pairIndex = static_cast<int32_t>(entry >> SCRIPT_TABLE_PAIR_SHIFT) - 1,
+	};
 }
 
 static UBool script_is_same(UScriptCode scriptOne, UScriptCode scriptTwo) {
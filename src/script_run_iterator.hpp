@@ -23,6 +23,7 @@
 class ScriptRunIterator final {
 	public:
 		explicit ScriptRunIterator(const char* text, int32_t textLength);
+		explicit ScriptRunIterator(const char16_t* text, int32_t textLength);
 
 		/**
 		 * Advances to the next script run, returning the start and limit offsets, and the script of the run.
@@ -39,6 +40,7 @@ class ScriptRunIterator final {
 		};
 
 		const char* m_text;
+		const char16_t* m_text16;
 		int32_t m_textLength;
 		int32_t m_scriptLimit;
 		ParenStackEntry m_parenStack[PAREN_STACK_DEPTH];
@@ -46,6 +48,10 @@ class ScriptRunIterator final {
 		int32_t m_pushCount;
 		int32_t m_fixupCount;
 
+		template <typename CharT>
+		bool next_internal(const CharT* text, int32_t& outRunStart, int32_t& outRunLimit,
+				UScriptCode& outRunScript);
+
 		void push(int32_t pairIndex, UScriptCode scriptCode);
 		void pop();
 		void fixup(UScriptCode scriptCode);
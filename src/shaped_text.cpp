@@ -0,0 +1,117 @@
+#include "shaped_text.hpp"
+
+extern "C" {
+#include <SheenBidi.h>
+}
+
+#include <utility>
+
+using namespace Text;
+
+ShapedText::~ShapedText() {
+	release_paragraphs();
+}
+
+ShapedText::ShapedText(ShapedText&& other) noexcept {
+	*this = std::move(other);
+}
+
+ShapedText& ShapedText::operator=(ShapedText&& other) noexcept {
+	std::swap(m_paragraphs, other.m_paragraphs);
+	std::swap(m_runs, other.m_runs);
+	std::swap(m_glyphs, other.m_glyphs);
+	std::swap(m_charIndices, other.m_charIndices);
+	std::swap(m_glyphWidths, other.m_glyphWidths);
+	std::swap(m_glyphPositions, other.m_glyphPositions);
+	std::swap(m_textLength, other.m_textLength);
+	return *this;
+}
+
+void ShapedText::clear() {
+	release_paragraphs();
+	m_paragraphs.clear();
+	m_runs.clear();
+	m_glyphs.clear();
+	m_charIndices.clear();
+	m_glyphWidths.clear();
+	m_glyphPositions.clear();
+	m_textLength = 0;
+}
+
+void ShapedText::append_paragraph(_SBParagraph* bidiParagraph, int32_t offset, int32_t contentLength,
+		int32_t separatorLength, float ascent, float descent) {
+	m_paragraphs.push_back({
+		.bidiParagraph = bidiParagraph,
+		.offset = offset,
+		.contentLength = contentLength,
+		.separatorLength = separatorLength,
+		.runEndIndex = static_cast<uint32_t>(m_runs.size()),
+		.glyphEndIndex = static_cast<uint32_t>(m_glyphs.size()),
+		.ascent = ascent,
+		.descent = descent,
+	});
+}
+
+void ShapedText::append_run(const Run& run) {
+	m_runs.push_back(run);
+}
+
+void ShapedText::append_glyphs(const uint32_t* glyphs, const uint32_t* charIndices, const float* glyphWidths,
+		size_t glyphCount, const float* glyphPositions, size_t positionCount) {
+	m_glyphs.insert(m_glyphs.end(), glyphs, glyphs + glyphCount);
+	m_charIndices.insert(m_charIndices.end(), charIndices, charIndices + glyphCount);
+	m_glyphWidths.insert(m_glyphWidths.end(), glyphWidths, glyphWidths + glyphCount);
+	m_glyphPositions.insert(m_glyphPositions.end(), glyphPositions, glyphPositions + positionCount);
+}
+
+void ShapedText::set_text_length(int32_t textLength) {
+	m_textLength = textLength;
+}
+
+int32_t ShapedText::get_text_length() const {
+	return m_textLength;
+}
+
+size_t ShapedText::get_paragraph_count() const {
+	return m_paragraphs.size();
+}
+
+const ShapedText::Paragraph& ShapedText::get_paragraph(size_t paragraphIndex) const {
+	return m_paragraphs[paragraphIndex];
+}
+
+uint32_t ShapedText::get_paragraph_first_run_index(size_t paragraphIndex) const {
+	return paragraphIndex == 0 ? 0 : m_paragraphs[paragraphIndex - 1].runEndIndex;
+}
+
+uint32_t ShapedText::get_paragraph_first_glyph_index(size_t paragraphIndex) const {
+	return paragraphIndex == 0 ? 0 : m_paragraphs[paragraphIndex - 1].glyphEndIndex;
+}
+
+const ShapedText::Run* ShapedText::get_runs() const {
+	return m_runs.data();
+}
+
+const uint32_t* ShapedText::get_glyphs() const {
+	return m_glyphs.data();
+}
+
+const uint32_t* ShapedText::get_char_indices() const {
+	return m_charIndices.data();
+}
+
+const float* ShapedText::get_glyph_widths() const {
+	return m_glyphWidths.data();
+}
+
+const float* ShapedText::get_glyph_positions() const {
+	return m_glyphPositions.data();
+}
+
+void ShapedText::release_paragraphs() {
+	for (auto& paragraph : m_paragraphs) {
+		if (paragraph.bidiParagraph) {
+			SBParagraphRelease(paragraph.bidiParagraph);
+		}
+	}
+}
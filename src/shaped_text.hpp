@@ -0,0 +1,130 @@
+#pragma once
+
+#include "font.hpp"
+#include "layout_info.hpp"
+
+#include <cstdint>
+
+#include <vector>
+
+struct _SBParagraph;
+
+namespace Text {
+
+/**
+ * Shaping results for a text, kept so that the text can be broken into lines again at a different font scale or
+ * text area width without reshaping. Glyphs are shaped at units-per-em scale with no hinting, and positions and
+ * advances are stored in em units, so they scale linearly with font size. Bidi paragraphs are retained for
+ * reordering the new lines.
+ *
+ * Built by `shape_text_utf8` and `shape_text_utf16`, then laid out with `build_layout_info_shaped` and
+ * `reflow_layout_info`.
+ */
+class ShapedText final {
+	public:
+		struct Run {
+			SingleScriptFont font;
+			// Pixels per stored position unit at a font scale of 1
+			float unitScale;
+			// Line metrics in pixels at a font scale of 1
+			float ascent;
+			float descent;
+			// Paragraph relative code unit and glyph limits
+			int32_t charEndIndex;
+			uint32_t glyphEndIndex;
+			uint8_t level;
+		};
+
+		struct Paragraph {
+			// Resolved bidi paragraph, null if the text is unidirectional LTR or the paragraph is empty
+			_SBParagraph* bidiParagraph;
+			int32_t offset;
+			int32_t contentLength;
+			int32_t separatorLength;
+			uint32_t runEndIndex;
+			uint32_t glyphEndIndex;
+			// Line metrics of an empty paragraph in pixels at a font scale of 1
+			float ascent;
+			float descent;
+		};
+
+		explicit ShapedText() = default;
+		~ShapedText();
+
+		ShapedText(ShapedText&&) noexcept;
+		ShapedText& operator=(ShapedText&&) noexcept;
+
+		ShapedText(const ShapedText&) = delete;
+		void operator=(const ShapedText&) = delete;
+
+		void clear();
+
+		/**
+		 * Appends a paragraph covering the runs and glyphs appended since the previous one, taking ownership
+		 * of `bidiParagraph`.
+		 */
+		void append_paragraph(_SBParagraph* bidiParagraph, int32_t offset, int32_t contentLength,
+				int32_t separatorLength, float ascent, float descent);
+		void append_run(const Run& run);
+		void append_glyphs(const uint32_t* glyphs, const uint32_t* charIndices, const float* glyphWidths,
+				size_t glyphCount, const float* glyphPositions, size_t positionCount);
+		void set_text_length(int32_t textLength);
+
+		int32_t get_text_length() const;
+
+		size_t get_paragraph_count() const;
+		const Paragraph& get_paragraph(size_t paragraphIndex) const;
+		uint32_t get_paragraph_first_run_index(size_t paragraphIndex) const;
+		uint32_t get_paragraph_first_glyph_index(size_t paragraphIndex) const;
+
+		const Run* get_runs() const;
+		const uint32_t* get_glyphs() const;
+		const uint32_t* get_char_indices() const;
+		const float* get_glyph_widths() const;
+		/**
+		 * Glyph positions as x, y pairs, with one extra pair ending each run.
+		 */
+		const float* get_glyph_positions() const;
+	private:
+		std::vector<Paragraph> m_paragraphs;
+		std::vector<Run> m_runs;
+		std::vector<uint32_t> m_glyphs;
+		std::vector<uint32_t> m_charIndices;
+		std::vector<float> m_glyphWidths;
+		std::vector<float> m_glyphPositions;
+		int32_t m_textLength{};
+
+		void release_paragraphs();
+};
+
+/**
+ * @brief Shapes UTF-8 text once for layout at any font scale, resolving bidi with SheenBidi
+ */
+void shape_text_utf8(ShapedText& result, const char* chars, int32_t count, const ValueRuns<Font>& fontRuns,
+		LayoutInfoFlags flags);
+
+/**
+ * @brief Shapes UTF-16 text once for layout at any font scale, resolving bidi with SheenBidi
+ */
+void shape_text_utf16(ShapedText& result, const char16_t* chars, int32_t count,
+		const ValueRuns<Font>& fontRuns, LayoutInfoFlags flags);
+
+/**
+ * @brief Builds the paragraph layout from shaped text, with font sizes and positions multiplied by `fontScale`.
+ * `chars` must be the text that was shaped.
+ */
+void build_layout_info_shaped(LayoutInfo& result, const ShapedText& shapedText, const char* chars,
+		int32_t count, float fontScale, float textAreaWidth, float textAreaHeight, TextYAlignment textYAlignment);
+void build_layout_info_shaped(LayoutInfo& result, const ShapedText& shapedText, const char16_t* chars,
+		int32_t count, float fontScale, float textAreaWidth, float textAreaHeight, TextYAlignment textYAlignment);
+
+/**
+ * @brief Redoes only line breaking of a layout built by `build_layout_info_shaped` from the same shaped text,
+ * for a new font scale or text area size. Text boundaries are kept.
+ */
+void reflow_layout_info(LayoutInfo& result, const ShapedText& shapedText, const char* chars, int32_t count,
+		float fontScale, float textAreaWidth, float textAreaHeight, TextYAlignment textYAlignment);
+void reflow_layout_info(LayoutInfo& result, const ShapedText& shapedText, const char16_t* chars,
+		int32_t count, float fontScale, float textAreaWidth, float textAreaHeight, TextYAlignment textYAlignment);
+
+}
@@ -0,0 +1,177 @@
+#include "simple_shaping.hpp"
+
+#include <hb.h>
+#include <hb-ot.h>
+
+#include <unicode/uchar.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+using namespace Text;
+
+namespace {
+
+struct CoverageKey {
+	FaceIndex_T face;
+	UScriptCode script;
+	hb_language_t language;
+
+	bool operator==(const CoverageKey&) const = default;
+};
+
+struct CoverageKeyHash {
+	size_t operator()(const CoverageKey& key) const {
+		auto value = (static_cast<uint64_t>(key.face) << 32) | static_cast<uint32_t>(key.script);
+		return std::hash<uint64_t>{}(value) ^ std::hash<const void*>{}(key.language);
+	}
+};
+
+struct SetDeleter {
+	void operator()(hb_set_t* pSet) const {
+		hb_set_destroy(pSet);
+	}
+};
+
+using CoverageCache = std::unordered_map<CoverageKey, std::unique_ptr<hb_set_t, SetDeleter>, CoverageKeyHash>;
+
+}
+
+// Tables HarfBuzz applies outside of the GSUB and GPOS lookups of the shape plan, to any glyph
+static constexpr const hb_tag_t UNPLANNED_TABLES[] = {
+	HB_TAG('k', 'e', 'r', 'n'),
+	HB_TAG('m', 'o', 'r', 'x'),
+	HB_TAG('m', 'o', 'r', 't'),
+	HB_TAG('k', 'e', 'r', 'x'),
+	HB_TAG('t', 'r', 'a', 'k'),
+};
+
+static constexpr const hb_tag_t MARK_FEATURES[] = {HB_TAG('m', 'a', 'r', 'k'), HB_TAG('m', 'k', 'm', 'k'),
+		HB_TAG_NONE};
+
+static thread_local CoverageCache t_coverage;
+static std::atomic_bool g_enabled{true};
+
+static hb_set_t* collect_touched_glyphs(hb_font_t* pFont, UScriptCode script, hb_language_t language);
+static bool has_table(hb_face_t* pFace, hb_tag_t tag);
+
+// Public Functions
+
+const hb_set_t* Text::get_simple_shaping_exclusions(FontFace face, hb_font_t* pFont, UScriptCode script,
+		hb_language_t language) {
+	if (!is_simple_shaping_script(script)) {
+		return nullptr;
+	}
+
+	CoverageKey key{face.handle, script, language};
+
+	if (auto it = t_coverage.find(key); it != t_coverage.end()) {
+		return it->second.get();
+	}
+
+	auto* pGlyphs = collect_touched_glyphs(pFont, script, language);
+	t_coverage.emplace(key, pGlyphs);
+
+	return pGlyphs;
+}
+
+bool Text::is_simple_shaping_script(UScriptCode script) {
+	switch (script) {
+		case USCRIPT_COMMON:
+		case USCRIPT_LATIN:
+		case USCRIPT_GREEK:
+		case USCRIPT_CYRILLIC:
+		case USCRIPT_HAN:
+		case USCRIPT_HIRAGANA:
+		case USCRIPT_KATAKANA:
+			return true;
+		default:
+			return false;
+	}
+}
+
+bool Text::is_simple_shaping_codepoint(uint32_t c) {
+	// Printable ASCII
+	if (c >= 0x20 && c < 0x7F) {
+		return true;
+	}
+
+	auto chr = static_cast<UChar32>(c);
+
+	return u_getIntPropertyValue(chr, UCHAR_GRAPHEME_CLUSTER_BREAK) == U_GCB_OTHER
+			&& !u_hasBinaryProperty(chr, UCHAR_DEFAULT_IGNORABLE_CODE_POINT);
+}
+
+void Text::set_simple_shaping_enabled(bool enabled) {
+	g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Text::is_simple_shaping_enabled() {
+	return g_enabled.load(std::memory_order_relaxed);
+}
+
+// Static Functions
+
+static hb_set_t* collect_touched_glyphs(hb_font_t* pFont, UScriptCode script, hb_language_t language) {
+	auto* pFace = hb_font_get_face(pFont);
+
+	for (auto tag : UNPLANNED_TABLES) {
+		if (has_table(pFace, tag)) {
+			return nullptr;
+		}
+	}
+
+	hb_segment_properties_t props = HB_SEGMENT_PROPERTIES_DEFAULT;
+	props.direction = HB_DIRECTION_LTR;
+	props.script = hb_script_from_string(uscript_getShortName(script), 4);
+	props.language = language;
+
+	// Feature variations select lookups by the instance, so plan for the font's own coordinates
+	unsigned coordCount{};
+	auto* pCoords = hb_font_get_var_coords_normalized(pFont, &coordCount);
+	auto* pPlan = hb_shape_plan_create_cached2(pFace, &props, nullptr, 0, pCoords, coordCount, nullptr);
+
+	auto* pTouched = hb_set_create();
+	auto* pLookups = hb_set_create();
+	auto* pGlyphs = hb_set_create();
+	auto* pMarkLookups = hb_set_create();
+	auto* pMarkGlyphs = hb_set_create();
+
+	hb_ot_layout_collect_lookups(pFace, HB_OT_TAG_GPOS, nullptr, nullptr, MARK_FEATURES, pMarkLookups);
+	hb_ot_layout_get_glyphs_in_class(pFace, HB_OT_LAYOUT_GLYPH_CLASS_MARK, pMarkGlyphs);
+
+	for (auto table : {HB_OT_TAG_GSUB, HB_OT_TAG_GPOS}) {
+		hb_set_clear(pLookups);
+		hb_ot_shape_plan_collect_lookups(pPlan, table, pLookups);
+
+		for (auto lookup = HB_SET_VALUE_INVALID; hb_set_next(pLookups, &lookup);) {
+			hb_set_clear(pGlyphs);
+			hb_ot_layout_lookup_collect_glyphs(pFace, table, lookup, nullptr, pGlyphs, nullptr, nullptr);
+
+			// Mark attachment lists the bases it attaches to as well, but only ever moves the mark glyphs
+			if (table == HB_OT_TAG_GPOS && hb_set_has(pMarkLookups, lookup)) {
+				hb_set_intersect(pGlyphs, pMarkGlyphs);
+			}
+
+			hb_set_union(pTouched, pGlyphs);
+		}
+	}
+
+	hb_set_destroy(pMarkGlyphs);
+	hb_set_destroy(pMarkLookups);
+	hb_set_destroy(pGlyphs);
+	hb_set_destroy(pLookups);
+	hb_shape_plan_destroy(pPlan);
+
+	return pTouched;
+}
+
+static bool has_table(hb_face_t* pFace, hb_tag_t tag) {
+	auto* pBlob = hb_face_reference_table(pFace, tag);
+	auto length = hb_blob_get_length(pBlob);
+	hb_blob_destroy(pBlob);
+
+	return length != 0;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "font_common.hpp"
+
+#include <unicode/uscript.h>
+
+#include <cstdint>
+
+struct hb_font_t;
+struct hb_set_t;
+struct hb_language_impl_t;
+
+namespace Text {
+
+/**
+ * Gets the glyphs that any GSUB or GPOS lookup in HarfBuzz's shape plan for left-to-right `script` text in
+ * `language` can act on, collected once per face, script and language on each thread. A run whose code points
+ * all pass `is_simple_shaping_codepoint` and whose nominal glyphs all lie outside this set comes out of `hb_shape`
+ * as those nominal glyphs at their plain advances with one cluster per code point, so it can skip the shaper.
+ *
+ * Returns null if no run of `script` in this face can skip the shaper: the script fails `is_simple_shaping_script`,
+ * or the face has a legacy `kern` table or AAT tables, which are applied outside of GSUB and GPOS.
+ *
+ * @thread_safety Thread safe, the cache and the returned set belong to the calling thread.
+ */
+[[nodiscard]] const hb_set_t* get_simple_shaping_exclusions(FontFace, hb_font_t* pFont, UScriptCode script,
+		const hb_language_impl_t* language);
+
+/**
+ * Whether HarfBuzz shapes `script` with its default shaper, which does nothing to text without marks beyond
+ * applying font lookups. Complex shapers reorder, compose or decompose characters on their own.
+ */
+[[nodiscard]] bool is_simple_shaping_script(UScriptCode script);
+
+/**
+ * Whether HarfBuzz always gives `c` a cluster of its own and never hides, composes or reorders it outside of font
+ * lookups: its grapheme cluster break property is Other and it is not default ignorable. Marks, joiners,
+ * variation selectors, Hangul jamo, regional indicators and control characters all fail.
+ */
+[[nodiscard]] bool is_simple_shaping_codepoint(uint32_t c);
+
+/**
+ * Enables or disables shaping simple runs without HarfBuzz. Enabled by default, output is identical either way, so
+ * this only exists to measure and verify the fast path.
+ *
+ * @thread_safety Thread safe.
+ */
+void set_simple_shaping_enabled(bool enabled);
+[[nodiscard]] bool is_simple_shaping_enabled();
+
+}
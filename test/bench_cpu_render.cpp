@@ -0,0 +1,86 @@
+#include <benchmark/benchmark.h>
+
+#include <bitmap.hpp>
+#include <cpu_glyph_cache.hpp>
+#include <cpu_text_renderer.hpp>
+#include <font_registry.hpp>
+#include <formatting.hpp>
+#include <layout_info.hpp>
+
+#include <string>
+
+static constexpr const uint32_t TARGET_WIDTH = 1920;
+static constexpr const uint32_t TARGET_HEIGHT = 1080;
+
+static constexpr const char* g_paragraph = "The quick brown fox <u>jumps over</u> the lazy dog. Pack my box "
+		"with <s>five dozen</s> liquor jugs. Sphinx of black quartz, judge my vow. ";
+
+static void bench_render(benchmark::State& state, const Text::StrokeState& stroke);
+
+static void BM_CPURender_Plain(benchmark::State& state) {
+	bench_render(state, {.color = {0.f, 0.f, 0.f, 0.f}, .thickness = 0, .joins = StrokeType::NONE});
+}
+
+static void BM_CPURender_Stroked(benchmark::State& state) {
+	bench_render(state, {.color = {0.f, 0.f, 0.f, 1.f}, .thickness = 2, .joins = StrokeType::ROUND});
+}
+
+BENCHMARK(BM_CPURender_Plain)
+	->RangeMultiplier(2)
+	->Range(1, 16)
+	->UseRealTime();
+BENCHMARK(BM_CPURender_Stroked)
+	->RangeMultiplier(2)
+	->Range(1, 16)
+	->UseRealTime();
+
+// Static Functions
+
+static void bench_render(benchmark::State& state, const Text::StrokeState& stroke) {
+	(void)Text::FontRegistry::register_families_from_path("fonts/families");
+
+	auto family = Text::FontRegistry::get_family("Noto Sans");
+	Text::Font font(family, Text::FontWeight::REGULAR, Text::FontStyle::NORMAL, 24);
+
+	std::string text;
+
+	for (int i = 0; i < 160; ++i) {
+		text += g_paragraph;
+	}
+
+	std::string contentText;
+	auto formatting = Text::parse_inline_formatting(text, contentText, font, {1.f, 1.f, 1.f, 1.f}, stroke);
+
+	Text::LayoutInfo layout;
+	Text::build_layout_info_utf8(layout, contentText.data(), static_cast<int32_t>(contentText.size()),
+			formatting.fontRuns, static_cast<float>(TARGET_WIDTH), static_cast<float>(TARGET_HEIGHT),
+			TextYAlignment::TOP, Text::LayoutInfoFlags::NONE);
+
+	Text::CPUTextRenderInfo info{
+		.pLayout = &layout,
+		.pFormatting = &formatting,
+		.x = 0.f,
+		.y = 0.f,
+		.width = static_cast<float>(TARGET_WIDTH),
+		.alignment = TextXAlignment::LEFT,
+	};
+
+	Text::CPUGlyphCache glyphCache;
+	Bitmap target(TARGET_WIDTH, TARGET_HEIGHT);
+	auto threadCount = static_cast<uint32_t>(state.range(0));
+
+	// Measure compositing with a warm glyph cache
+	Text::render_text(target, info, glyphCache, threadCount);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		target.clear({0.1f, 0.1f, 0.1f, 1.f});
+		state.ResumeTiming();
+
+		Text::render_text(target, info, glyphCache, threadCount);
+		benchmark::DoNotOptimize(target.data());
+	}
+
+	state.counters["MP/s"] = benchmark::Counter(static_cast<double>(state.iterations())
+			* TARGET_WIDTH * TARGET_HEIGHT / 1e6, benchmark::Counter::kIsRate);
+}
@@ -10,6 +10,7 @@
 #include <cstdio>
 
 #include <unicode/utf8.h>
+#include <unicode/ustring.h>
 
 static constexpr const size_t TEST_STRING_SIZE = 1 * 1024 * 1024;
 static constexpr const double WORD_SIZE_AVERAGE = 15.0;
@@ -86,6 +87,13 @@ static constexpr const uint32_t g_paragraphSeparators[] = {
 
 using Lang = std::span<const Text::Pair<uint32_t, uint32_t>>;
 
+enum class Corpus {
+	MULTI_LANG,
+	LATIN,
+	CJK,
+	DEVANAGARI,
+};
+
 static std::string g_testStringMultiLang;
 static std::string g_testStringLatn;
 static std::string g_testStringCJK;
@@ -96,6 +104,8 @@ static void init_test_strings();
 static std::string gen_test_string_single_lang(size_t capacity, Lang lang);
 static std::string gen_test_string_multi_lang(size_t capacity);
 static void dump_test_data(const std::string& str);
+static std::string gen_corpus(Corpus corpus, size_t capacity);
+static std::u16string to_utf16(const std::string& str);
 
 // Benchmarks
 
@@ -227,6 +237,56 @@ static void BM_Layout_SingleFont_Deva_NoLineBreak(benchmark::State& state) {
 	}
 }
 
+// Engine comparison over the same corpora. The UTF-16 engines lay out the transcoded string directly.
+
+static void BM_Engine_UTF8_SheenBidi(benchmark::State& state, Corpus corpus) {
+	auto str = gen_corpus(corpus, state.range(0));
+	(void)Text::FontRegistry::register_families_from_path("fonts/families");
+
+	auto family = Text::FontRegistry::get_family("Noto Sans"); 
+	Text::Font font(family, Text::FontWeight::REGULAR, Text::FontStyle::NORMAL, 48);
+	Text::ValueRuns<Text::Font> fontRuns(font, str.size());
+
+	for (auto _ : state) {
+		Text::LayoutInfo layoutInfo;
+		Text::build_layout_info_utf8(layoutInfo, str.data(), str.size(), fontRuns, 100.f, 100.f,
+				TextYAlignment::TOP, Text::LayoutInfoFlags::NONE);
+		benchmark::DoNotOptimize(layoutInfo);
+	}
+}
+
+static void BM_Engine_UTF16_ICU(benchmark::State& state, Corpus corpus) {
+	auto str = to_utf16(gen_corpus(corpus, state.range(0)));
+	(void)Text::FontRegistry::register_families_from_path("fonts/families");
+
+	auto family = Text::FontRegistry::get_family("Noto Sans"); 
+	Text::Font font(family, Text::FontWeight::REGULAR, Text::FontStyle::NORMAL, 48);
+	Text::ValueRuns<Text::Font> fontRuns(font, str.size());
+
+	for (auto _ : state) {
+		Text::LayoutInfo layoutInfo;
+		Text::build_layout_info_icu(layoutInfo, str.data(), str.size(), fontRuns, 100.f, 100.f,
+				TextYAlignment::TOP, Text::LayoutInfoFlags::NONE);
+		benchmark::DoNotOptimize(layoutInfo);
+	}
+}
+
+static void BM_Engine_UTF16_SheenBidi(benchmark::State& state, Corpus corpus) {
+	auto str = to_utf16(gen_corpus(corpus, state.range(0)));
+	(void)Text::FontRegistry::register_families_from_path("fonts/families");
+
+	auto family = Text::FontRegistry::get_family("Noto Sans"); 
+	Text::Font font(family, Text::FontWeight::REGULAR, Text::FontStyle::NORMAL, 48);
+	Text::ValueRuns<Text::Font> fontRuns(font, str.size());
+
+	for (auto _ : state) {
+		Text::LayoutInfo layoutInfo;
+		Text::build_layout_info_utf16(layoutInfo, str.data(), str.size(), fontRuns, 100.f, 100.f,
+				TextYAlignment::TOP, Text::LayoutInfoFlags::NONE);
+		benchmark::DoNotOptimize(layoutInfo);
+	}
+}
+
 /*static void BM_Layout_MultiFont_LineBreak(benchmark::State& state) {
 	init_test_strings();
 	(void)Text::FontRegistry::register_families_from_path("fonts/families");
@@ -287,6 +347,16 @@ BENCHMARK(BM_Layout_SingleFont_Deva_NoLineBreak)
 	->Range(64, 1024 * 1024);
 //BENCHMARK(BM_Layout_MultiFont_LineBreak);
 
+#define ENGINE_BENCHMARK(func) \
+	BENCHMARK_CAPTURE(func, MultiLang, Corpus::MULTI_LANG)->RangeMultiplier(16)->Range(64, 1024 * 1024); \
+	BENCHMARK_CAPTURE(func, Latin, Corpus::LATIN)->RangeMultiplier(16)->Range(64, 1024 * 1024); \
+	BENCHMARK_CAPTURE(func, CJK, Corpus::CJK)->RangeMultiplier(16)->Range(64, 1024 * 1024); \
+	BENCHMARK_CAPTURE(func, Deva, Corpus::DEVANAGARI)->RangeMultiplier(16)->Range(64, 1024 * 1024)
+
+ENGINE_BENCHMARK(BM_Engine_UTF8_SheenBidi);
+ENGINE_BENCHMARK(BM_Engine_UTF16_ICU);
+ENGINE_BENCHMARK(BM_Engine_UTF16_SheenBidi);
+
 // Static Functions
 
 static size_t apply_lang(std::default_random_engine& rng,
@@ -433,6 +503,30 @@ static std::string gen_test_string_multi_lang(size_t capacity) {
 	return std::string(buffer.get(), stringSize);
 }
 
+static std::string gen_corpus(Corpus corpus, size_t capacity) {
+	switch (corpus) {
+		case Corpus::LATIN:
+			return gen_test_string_single_lang(capacity, g_unicodeLatin);
+		case Corpus::CJK:
+			return gen_test_string_single_lang(capacity, g_unicodeCJK);
+		case Corpus::DEVANAGARI:
+			return gen_test_string_single_lang(capacity, g_unicodeDevanagari);
+		default:
+			return gen_test_string_multi_lang(capacity);
+	}
+}
+
+static std::u16string to_utf16(const std::string& str) {
+	std::u16string result(str.size(), u'\0');
+	UErrorCode err{};
+	int32_t length16{};
+	u_strFromUTF8(result.data(), static_cast<int32_t>(result.size()), &length16, str.data(),
+			static_cast<int32_t>(str.size()), &err);
+	result.resize(length16);
+
+	return result;
+}
+
 static void dump_test_data(const std::string& str) {
 	// HTML
 	{
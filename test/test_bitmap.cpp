@@ -0,0 +1,147 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <bitmap.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static void reference_blit_alpha(Bitmap& dst, const Bitmap& src, int32_t x, int32_t y, const Color& color);
+static void fill_random(Bitmap& bitmap, std::mt19937& rng);
+
+TEST_CASE("Blit alpha matches per-pixel float blending", "[Bitmap]") {
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> tintDist(0.f, 1.f);
+
+	const Color tints[] = {
+		{1.f, 1.f, 1.f, 1.f},
+		{0.f, 0.f, 0.f, 1.f},
+		{0.25f, 0.5f, 0.75f, 0.5f},
+		{tintDist(rng), tintDist(rng), tintDist(rng), tintDist(rng)},
+	};
+
+	const int32_t positions[][2] = {{0, 0}, {3, 5}, {-4, -2}, {29, 27}};
+
+	for (auto& tint : tints) {
+		for (auto& pos : positions) {
+			Bitmap src(17, 13);
+			Bitmap dst(32, 31);
+			Bitmap expected(32, 31);
+
+			fill_random(src, rng);
+			fill_random(dst, rng);
+			std::copy_n(dst.data(), 32 * 31, expected.data());
+
+			dst.blit_alpha(src, pos[0], pos[1], tint);
+			reference_blit_alpha(expected, src, pos[0], pos[1], tint);
+
+			REQUIRE(std::equal(dst.data(), dst.data() + 32 * 31, expected.data()));
+		}
+	}
+}
+
+TEST_CASE("A8 blit matches converted blit", "[Bitmap]") {
+	std::mt19937 rng(5678);
+	std::uniform_int_distribution<uint32_t> byteDist(0, 255);
+
+	constexpr uint32_t width = 19;
+	constexpr uint32_t height = 11;
+	constexpr uint32_t stride = 24;
+
+	std::vector<uint8_t> coverage(stride * height);
+
+	for (auto& c : coverage) {
+		c = static_cast<uint8_t>(byteDist(rng));
+	}
+
+	Bitmap src(width, height);
+
+	for (uint32_t y = 0; y < height; ++y) {
+		Bitmap::convert_a8_to_argb(coverage.data() + y * stride, src.data() + y * width, width);
+	}
+
+	Color tint{0.9f, 0.3f, 0.6f, 0.8f};
+	Bitmap dst(40, 20);
+	Bitmap expected(40, 20);
+	fill_random(dst, rng);
+	std::copy_n(dst.data(), 40 * 20, expected.data());
+
+	dst.blit_alpha_a8(coverage.data(), width, height, stride, -3, 4, tint);
+	expected.blit_alpha(src, -3, 4, tint);
+
+	REQUIRE(std::equal(dst.data(), dst.data() + 40 * 20, expected.data()));
+}
+
+TEST_CASE("A8 conversion", "[Bitmap]") {
+	uint8_t coverage[256];
+	uint32_t pixels[256];
+
+	for (uint32_t i = 0; i < 256; ++i) {
+		coverage[i] = static_cast<uint8_t>(i);
+	}
+
+	Bitmap::convert_a8_to_argb(coverage, pixels, 256);
+
+	for (uint32_t i = 0; i < 256; ++i) {
+		REQUIRE(pixels[i] == Color::to_argb({1.f, 1.f, 1.f, static_cast<float>(i) / 255.f}));
+	}
+}
+
+TEST_CASE("BGRA conversion", "[Bitmap]") {
+	std::vector<uint8_t> bgra;
+	bgra.reserve(256 * 256 * 4);
+
+	for (uint32_t a = 0; a < 256; ++a) {
+		for (uint32_t c = 0; c <= a; ++c) {
+			bgra.insert(bgra.end(), {static_cast<uint8_t>(c), static_cast<uint8_t>(c / 2),
+					static_cast<uint8_t>(a - c), static_cast<uint8_t>(a)});
+		}
+	}
+
+	auto count = bgra.size() / 4;
+	std::vector<uint32_t> pixels(count);
+	Bitmap::convert_bgra_to_argb(bgra.data(), pixels.data(), count);
+
+	for (size_t i = 0; i < count; ++i) {
+		auto b = static_cast<float>(bgra[4 * i]) / 255.f;
+		auto g = static_cast<float>(bgra[4 * i + 1]) / 255.f;
+		auto r = static_cast<float>(bgra[4 * i + 2]) / 255.f;
+		auto a = static_cast<float>(bgra[4 * i + 3]) / 255.f;
+
+		REQUIRE(pixels[i] == Color::to_argb({r / a, g / a, b / a, a}));
+	}
+}
+
+static void reference_blit_alpha(Bitmap& dst, const Bitmap& src, int32_t x, int32_t y, const Color& color) {
+	for (int32_t sy = 0; sy < static_cast<int32_t>(src.get_height()); ++sy) {
+		for (int32_t sx = 0; sx < static_cast<int32_t>(src.get_width()); ++sx) {
+			auto dx = x + sx;
+			auto dy = y + sy;
+
+			if (dx < 0 || dy < 0 || dx >= static_cast<int32_t>(dst.get_width())
+					|| dy >= static_cast<int32_t>(dst.get_height())) {
+				continue;
+			}
+
+			auto srcColor = src.get_pixel(sx, sy) * color;
+			auto dstColor = dst.get_pixel(dx, dy);
+
+			dst.set_pixel(dx, dy, dstColor.a > 0.f ? Color::blend(srcColor, dstColor) : srcColor);
+		}
+	}
+}
+
+static void fill_random(Bitmap& bitmap, std::mt19937& rng) {
+	std::uniform_int_distribution<uint32_t> dist;
+
+	for (uint32_t i = 0, l = bitmap.get_width() * bitmap.get_height(); i < l; ++i) {
+		auto pixel = dist(rng);
+
+		// Exercise both the blend and the copy path for transparent destinations
+		if ((pixel & 0x700) == 0) {
+			pixel &= 0x00FFFFFFu;
+		}
+
+		bitmap.data()[i] = pixel;
+	}
+}
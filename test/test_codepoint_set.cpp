@@ -0,0 +1,57 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <codepoint_set.hpp>
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+
+TEST_CASE("Codepoint set matches std::set", "[CodepointSet]") {
+	std::mt19937 rng(4321);
+	std::uniform_int_distribution<uint32_t> blockDist(0, Text::CodepointSet::BLOCK_COUNT - 1);
+	std::uniform_int_distribution<uint32_t> offsetDist(0, Text::CodepointSet::BLOCK_SIZE - 1);
+
+	// Clustered like a real cmap: a handful of blocks with many codepoints each
+	std::set<uint32_t> expected;
+
+	for (int block = 0; block < 8; ++block) {
+		auto base = blockDist(rng) * Text::CodepointSet::BLOCK_SIZE;
+
+		for (int i = 0; i < 300; ++i) {
+			expected.insert(base + offsetDist(rng));
+		}
+	}
+
+	expected.insert(0);
+	expected.insert(Text::CodepointSet::CODEPOINT_LIMIT - 1);
+
+	std::vector<uint32_t> sorted(expected.begin(), expected.end());
+	// Duplicates and out of range values must be tolerated
+	sorted.insert(sorted.begin() + 1, sorted[0]);
+	sorted.push_back(Text::CodepointSet::CODEPOINT_LIMIT);
+
+	Text::CodepointSet set(sorted.data(), sorted.size());
+
+	REQUIRE(set.size() == expected.size());
+
+	size_t mismatchCount = 0;
+
+	for (uint32_t c = 0; c < Text::CodepointSet::CODEPOINT_LIMIT; ++c) {
+		mismatchCount += set.contains(c) != expected.contains(c);
+	}
+
+	REQUIRE(mismatchCount == 0);
+
+	REQUIRE(!set.contains(Text::CodepointSet::CODEPOINT_LIMIT));
+	REQUIRE(!set.contains(0xFFFFFFFFu));
+}
+
+TEST_CASE("Empty codepoint set", "[CodepointSet]") {
+	Text::CodepointSet set;
+
+	REQUIRE(set.empty());
+	REQUIRE(set.get_memory_size() == 0);
+	REQUIRE(!set.contains(0));
+	REQUIRE(!set.contains('A'));
+}
@@ -0,0 +1,62 @@
+#include "test_common.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <font_registry.hpp>
+#include <layout_info.hpp>
+
+#include <cmath>
+
+static bool g_initialized = false;
+
+void init_font_registry() {
+	if (g_initialized) {
+		return;
+	}
+
+	g_initialized = true;
+	auto res = Text::FontRegistry::register_families_from_path("fonts/families");
+	REQUIRE(res == Text::FontRegistryError::NONE);
+}
+
+void test_compare_layouts(const Text::LayoutInfo& lxLayout, const Text::LayoutInfo& icuLayout) {
+	REQUIRE(lxLayout.get_run_count() == icuLayout.get_run_count());
+	REQUIRE(lxLayout.get_glyph_count() == icuLayout.get_glyph_count());
+	REQUIRE(lxLayout.get_char_index_count() == icuLayout.get_char_index_count());
+	REQUIRE(lxLayout.get_glyph_position_data_count() == icuLayout.get_glyph_position_data_count());
+	REQUIRE(lxLayout.get_line_count() == icuLayout.get_line_count());
+
+	for (size_t i = 0; i < lxLayout.get_glyph_count(); ++i) {
+		REQUIRE(lxLayout.get_glyph_id(i) == icuLayout.get_glyph_id(i));
+	}
+
+	for (size_t i = 0; i < lxLayout.get_char_index_count(); ++i) {
+		REQUIRE(lxLayout.get_char_index(i) == icuLayout.get_char_index(i));
+	}
+
+	auto* lxPosData = lxLayout.get_glyph_position_data();
+	auto* icuPosData = icuLayout.get_glyph_position_data();
+	for (size_t i = 0; i < lxLayout.get_glyph_position_data_count(); ++i) {
+		REQUIRE(fabsf(lxPosData[i] - icuPosData[i]) < 0.01f);
+	}
+
+	for (size_t i = 0; i < lxLayout.get_run_count(); ++i) {
+		REQUIRE(lxLayout.get_run_font(i) == icuLayout.get_run_font(i));
+		REQUIRE(lxLayout.get_run_glyph_end_index(i) == icuLayout.get_run_glyph_end_index(i));
+		REQUIRE(lxLayout.is_run_rtl(i) == icuLayout.is_run_rtl(i));
+		REQUIRE(lxLayout.get_run_char_start_index(i) == icuLayout.get_run_char_start_index(i));
+		REQUIRE(lxLayout.get_run_char_end_index(i) == icuLayout.get_run_char_end_index(i));
+		REQUIRE(lxLayout.get_run_char_end_offset(i) == icuLayout.get_run_char_end_offset(i));
+	}
+
+	for (size_t i = 0; i < lxLayout.get_line_count(); ++i) {
+		REQUIRE(lxLayout.get_line_run_end_index(i) == icuLayout.get_line_run_end_index(i));
+		// LayoutEx truncates width to an integer, so there is some discrepancy
+		REQUIRE(fabsf(lxLayout.get_line_width(i) - icuLayout.get_line_width(i)) < 1.f);
+		REQUIRE(lxLayout.get_line_ascent(i) == icuLayout.get_line_ascent(i));
+		REQUIRE(lxLayout.get_line_total_descent(i) == icuLayout.get_line_total_descent(i));
+	}
+
+	REQUIRE(lxLayout.get_text_start_y() == icuLayout.get_text_start_y());
+}
+
@@ -0,0 +1,18 @@
+#pragma once
+
+namespace Text {
+
+class LayoutInfo;
+
+}
+
+/**
+ * Registers the font families under fonts/families once per test run, shared by every test file that lays out
+ * or renders text.
+ */
+void init_font_registry();
+
+/**
+ * Requires two layouts to have the same runs, glyphs and lines, with positions equal up to rounding.
+ */
+void test_compare_layouts(const Text::LayoutInfo& lxLayout, const Text::LayoutInfo& icuLayout);
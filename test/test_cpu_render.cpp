@@ -0,0 +1,133 @@
+#include "test_common.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <bitmap.hpp>
+#include <cpu_glyph_cache.hpp>
+#include <cpu_text_renderer.hpp>
+#include <font_registry.hpp>
+#include <formatting.hpp>
+#include <layout_info.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <string>
+
+static constexpr const uint32_t TARGET_WIDTH = 300;
+static constexpr const uint32_t TARGET_HEIGHT = 200;
+static constexpr const Color BACKGROUND_COLOR{0.1f, 0.2f, 0.3f, 1.f};
+
+static void render_reference(Bitmap& target, const Text::CPUTextRenderInfo& info, const Color& color);
+static bool bitmaps_equal(const Bitmap& a, const Bitmap& b);
+
+TEST_CASE("CPU render matches per glyph rasterization", "[CPURender]") {
+	init_font_registry();
+	auto family = Text::FontRegistry::get_family("Noto Sans");
+	Text::Font font(family, Text::FontWeight::REGULAR, Text::FontStyle::NORMAL, 24);
+
+	// Wraps onto several lines, so glyphs straddle tile boundaries
+	std::string text = "The quick brown fox jumps over the lazy dog. Pack my box with five dozen liquor jugs. "
+			"Sphinx of black quartz, judge my vow.";
+	std::string contentText;
+	Color textColor{0.9f, 0.8f, 0.1f, 1.f};
+	auto formatting = Text::parse_inline_formatting(text, contentText, font, textColor,
+			{.color = {0.f, 0.f, 0.f, 0.f}, .thickness = 0, .joins = StrokeType::NONE});
+
+	Text::LayoutInfo layout;
+	Text::build_layout_info_utf8(layout, contentText.data(), static_cast<int32_t>(contentText.size()),
+			formatting.fontRuns, static_cast<float>(TARGET_WIDTH), static_cast<float>(TARGET_HEIGHT),
+			TextYAlignment::TOP, Text::LayoutInfoFlags::NONE);
+	REQUIRE(layout.get_line_count() > 1);
+
+	Text::CPUTextRenderInfo info{
+		.pLayout = &layout,
+		.pFormatting = &formatting,
+		.x = 3.3f,
+		.y = 7.6f,
+		.width = static_cast<float>(TARGET_WIDTH),
+		.alignment = TextXAlignment::CENTER,
+	};
+
+	Bitmap expected(TARGET_WIDTH, TARGET_HEIGHT, BACKGROUND_COLOR);
+	render_reference(expected, info, textColor);
+
+	Text::CPUGlyphCache glyphCache;
+
+	for (uint32_t threadCount : {1u, 4u}) {
+		Bitmap result(TARGET_WIDTH, TARGET_HEIGHT, BACKGROUND_COLOR);
+		Text::render_text(result, info, glyphCache, threadCount);
+
+		REQUIRE(bitmaps_equal(result, expected));
+	}
+}
+
+TEST_CASE("CPU render is independent of thread count", "[CPURender]") {
+	init_font_registry();
+	auto family = Text::FontRegistry::get_family("Noto Sans");
+	Text::Font font(family, Text::FontWeight::REGULAR, Text::FontStyle::NORMAL, 32);
+
+	// Strokes, underlines and strikethroughs overlap across tile boundaries, so any reordering shows up
+	std::string text = "Pack my box <u>with five dozen</u> liquor jugs. <s>Sphinx of black</s> quartz, <u>judge "
+			"my <s>vow</s></u>.";
+	std::string contentText;
+	auto formatting = Text::parse_inline_formatting(text, contentText, font, {1.f, 1.f, 1.f, 1.f},
+			{.color = {0.f, 0.f, 0.f, 1.f}, .thickness = 2, .joins = StrokeType::ROUND});
+
+	Text::LayoutInfo layout;
+	Text::build_layout_info_utf8(layout, contentText.data(), static_cast<int32_t>(contentText.size()),
+			formatting.fontRuns, static_cast<float>(TARGET_WIDTH), static_cast<float>(TARGET_HEIGHT),
+			TextYAlignment::TOP, Text::LayoutInfoFlags::NONE);
+
+	Text::CPUTextRenderInfo info{
+		.pLayout = &layout,
+		.pFormatting = &formatting,
+		.x = 0.f,
+		.y = 0.f,
+		.width = static_cast<float>(TARGET_WIDTH),
+		.alignment = TextXAlignment::LEFT,
+	};
+
+	Text::CPUGlyphCache glyphCache;
+	Bitmap expected(TARGET_WIDTH, TARGET_HEIGHT, BACKGROUND_COLOR);
+	Text::render_text(expected, info, glyphCache, 1);
+
+	for (uint32_t threadCount : {2u, 8u}) {
+		Bitmap result(TARGET_WIDTH, TARGET_HEIGHT, BACKGROUND_COLOR);
+		Text::render_text(result, info, glyphCache, threadCount);
+
+		REQUIRE(bitmaps_equal(result, expected));
+	}
+}
+
+// Static Functions
+
+// Draws each glyph straight into the target in layout order, as the GPU renderer draws glyphs from its atlas
+static void render_reference(Bitmap& target, const Text::CPUTextRenderInfo& info, const Color& color) {
+	auto& layout = *info.pLayout;
+	auto* glyphPositions = layout.get_glyph_position_data();
+	uint32_t glyphIndex{};
+	uint32_t glyphPosIndex{};
+
+	layout.for_each_run(info.width, info.alignment, [&](auto, auto runIndex, auto lineX, auto lineY) {
+		auto fontData = Text::FontRegistry::get_font_data(layout.get_run_font(runIndex));
+
+		for (auto glyphEndIndex = layout.get_run_glyph_end_index(runIndex); glyphIndex < glyphEndIndex;
+				++glyphIndex, glyphPosIndex += 2) {
+			float offset[2]{};
+			auto result = fontData.rasterize_glyph(layout.get_glyph_id(glyphIndex), offset);
+			auto x = std::floor(info.x + lineX + glyphPositions[glyphPosIndex] + 0.5f);
+			auto y = std::floor(info.y + lineY + glyphPositions[glyphPosIndex + 1] + 0.5f);
+
+			target.blit_alpha(result.bitmap, static_cast<int32_t>(x) + static_cast<int32_t>(offset[0]),
+					static_cast<int32_t>(y) + static_cast<int32_t>(offset[1]),
+					result.hasColor ? Color{1.f, 1.f, 1.f, 1.f} : color);
+		}
+
+		glyphPosIndex += 2;
+	});
+}
+
+static bool bitmaps_equal(const Bitmap& a, const Bitmap& b) {
+	return a.get_width() == b.get_width() && a.get_height() == b.get_height()
+			&& std::memcmp(a.data(), b.data(), size_t{a.get_width()} * a.get_height() * sizeof(uint32_t)) == 0;
+}
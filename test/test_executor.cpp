@@ -0,0 +1,162 @@
+#include "test_common.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <executor.hpp>
+#include <font_registry.hpp>
+#include <msdf_batch.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+static void test_run_on_workers(Text::Executor& executor, uint32_t workerCount);
+static void test_nested_waits(Text::Executor& executor);
+
+TEST_CASE("Serial executor", "[Executor]") {
+	Text::SerialExecutor executor;
+
+	REQUIRE(executor.get_worker_count() == 1);
+	test_run_on_workers(executor, 1);
+	test_run_on_workers(executor, 8);
+	test_nested_waits(executor);
+}
+
+TEST_CASE("Oversubscribed thread pool executor", "[Executor]") {
+	// Far more threads than cores, so tasks are preempted mid-claim and finish out of order
+	Text::ThreadPoolExecutor executor(64);
+
+	REQUIRE(executor.get_worker_count() == 65);
+	test_run_on_workers(executor, executor.get_worker_count());
+	test_run_on_workers(executor, 256);
+	test_nested_waits(executor);
+}
+
+TEST_CASE("Thread pool executor with fewer threads than tasks", "[Executor]") {
+	Text::ThreadPoolExecutor executor(1);
+
+	test_run_on_workers(executor, 16);
+	test_nested_waits(executor);
+}
+
+TEST_CASE("Thread pool executor waits only on its own group", "[Executor]") {
+	Text::ThreadPoolExecutor executor(1);
+	Text::TaskGroup blockingGroup;
+	Text::TaskGroup otherGroup;
+	Text::TaskGroup group;
+	std::atomic_bool release{false};
+	std::atomic_bool otherRan{false};
+	std::atomic_bool ran{false};
+
+	// Occupies the only thread, so the other group's task stays queued while the caller waits
+	executor.submit(blockingGroup, [&] {
+		while (!release.load(std::memory_order_acquire)) {
+			std::this_thread::yield();
+		}
+	});
+	executor.submit(otherGroup, [&] { otherRan.store(true); });
+	executor.submit(group, [&] { ran.store(true); });
+
+	executor.wait(group);
+
+	REQUIRE(ran.load());
+	REQUIRE(!otherRan.load());
+
+	release.store(true, std::memory_order_release);
+	executor.wait(blockingGroup);
+	executor.wait(otherGroup);
+
+	REQUIRE(otherRan.load());
+}
+
+TEST_CASE("Installed executor", "[Executor]") {
+	Text::SerialExecutor executor;
+
+	Text::set_executor(&executor);
+	REQUIRE(&Text::get_executor() == &executor);
+
+	Text::set_executor(nullptr);
+	REQUIRE(&Text::get_executor() != &executor);
+	REQUIRE(Text::get_executor().get_worker_count() >= 2);
+}
+
+TEST_CASE("MSDF batch matches across executors", "[Executor]") {
+	init_font_registry();
+	auto family = Text::FontRegistry::get_family("Noto Sans");
+	Text::Font font(family, Text::FontWeight::REGULAR, Text::FontStyle::NORMAL, 48);
+	Text::SingleScriptFont subFont{.face = Text::FontRegistry::get_face(font), .size = 48};
+
+	std::vector<Text::MSDFBatchGlyph> glyphs;
+
+	for (uint32_t glyphIndex = 1; glyphIndex < 200; ++glyphIndex) {
+		glyphs.push_back({subFont, glyphIndex});
+	}
+
+	Text::SerialExecutor serialExecutor;
+	Text::set_executor(&serialExecutor);
+	auto expected = Text::generate_msdf_batch(glyphs.data(), glyphs.size());
+
+	Text::ThreadPoolExecutor oversubscribedExecutor(64);
+	Text::set_executor(&oversubscribedExecutor);
+	auto result = Text::generate_msdf_batch(glyphs.data(), glyphs.size());
+
+	Text::set_executor(nullptr);
+
+	REQUIRE(result.glyphs.size() == expected.glyphs.size());
+
+	for (size_t i = 0; i < glyphs.size(); ++i) {
+		auto& glyph = result.glyphs[i];
+		auto& expectedGlyph = expected.glyphs[i];
+		auto byteCount = size_t{glyph.width} * glyph.height * 3;
+
+		REQUIRE(glyph.width == expectedGlyph.width);
+		REQUIRE(glyph.height == expectedGlyph.height);
+		REQUIRE(std::memcmp(result.pixels.data() + glyph.dataOffset,
+				expected.pixels.data() + expectedGlyph.dataOffset, byteCount) == 0);
+	}
+}
+
+static void test_run_on_workers(Text::Executor& executor, uint32_t workerCount) {
+	static constexpr const size_t ITEM_COUNT = 10000;
+
+	std::vector<std::atomic_uint32_t> workerCalls(workerCount);
+	std::vector<uint64_t> workerSums(workerCount);
+	std::atomic_size_t nextItem{0};
+
+	Text::run_on_workers(executor, workerCount, [&](uint32_t workerIndex) {
+		workerCalls[workerIndex].fetch_add(1, std::memory_order_relaxed);
+
+		for (;;) {
+			auto item = nextItem.fetch_add(1, std::memory_order_relaxed);
+
+			if (item >= ITEM_COUNT) {
+				break;
+			}
+
+			workerSums[workerIndex] += item;
+		}
+	});
+
+	for (auto& calls : workerCalls) {
+		REQUIRE(calls.load() == 1);
+	}
+
+	REQUIRE(std::accumulate(workerSums.begin(), workerSums.end(), uint64_t{0})
+			== ITEM_COUNT * (ITEM_COUNT - 1) / 2);
+}
+
+// Tasks that wait on groups of their own must not deadlock, even when every thread is busy waiting
+static void test_nested_waits(Text::Executor& executor) {
+	std::atomic_uint32_t innerCalls{0};
+
+	Text::run_on_workers(executor, 8, [&](uint32_t) {
+		Text::run_on_workers(executor, 8, [&](uint32_t) {
+			innerCalls.fetch_add(1, std::memory_order_relaxed);
+		});
+	});
+
+	REQUIRE(innerCalls.load() == 64);
+}
@@ -0,0 +1,101 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <font_pack.hpp>
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static void write_test_file(const char* fileName, const std::string& contents);
+
+TEST_CASE("Font pack round trip", "[FontPack]") {
+	// Sizes straddle the alignment to exercise padding between blobs
+	std::string contentsA(5000, 'a');
+	std::string contentsB = "not actually a font";
+	std::string contentsLoose = "loose file";
+
+	write_test_file("test_pack_a.bin", contentsA);
+	write_test_file("test_pack_b.bin", contentsB);
+	write_test_file("test_pack_loose.bin", contentsLoose);
+
+	// Out of order and duplicated, the writer must sort and dedup
+	std::string_view uris[] = {"test_pack_b.bin", "test_pack_a.bin", "test_pack_b.bin"};
+
+	REQUIRE(Text::FontPack::write("test_pack.pack", uris, 3));
+	REQUIRE(Text::FontPack::open("test_pack.pack"));
+
+	auto funcs = Text::FontPack::get_file_mapping_functions();
+
+	for (auto [uri, expected] : {std::pair<std::string_view, const std::string*>{"test_pack_a.bin", &contentsA},
+			{"test_pack_b.bin", &contentsB}, {"test_pack_loose.bin", &contentsLoose}}) {
+		auto mapping = funcs.pfnMapFile(uri);
+
+		REQUIRE(mapping.mapping);
+		REQUIRE(mapping.size == expected->size());
+		REQUIRE(std::memcmp(mapping.mapping, expected->data(), mapping.size) == 0);
+
+		funcs.pfnUnmapFile(mapping);
+	}
+
+	auto packed = funcs.pfnMapFile("test_pack_a.bin");
+	auto packedB = funcs.pfnMapFile("test_pack_b.bin");
+	auto offset = reinterpret_cast<uintptr_t>(packedB.mapping) - reinterpret_cast<uintptr_t>(packed.mapping);
+	REQUIRE(offset % Text::FONT_PACK_ALIGNMENT == 0);
+	funcs.pfnUnmapFile(packed);
+	funcs.pfnUnmapFile(packedB);
+
+	Text::FontPack::prefetch("test_pack_a.bin");
+	Text::FontPack::prefetch("missing.bin");
+
+	REQUIRE(!funcs.pfnMapFile("missing.bin").mapping);
+
+	// Once closed, URIs are served from loose files again
+	Text::FontPack::close();
+	write_test_file("test_pack_a.bin", contentsLoose);
+
+	auto loose = funcs.pfnMapFile("test_pack_a.bin");
+	REQUIRE(loose.mapping);
+	REQUIRE(loose.size == contentsLoose.size());
+	funcs.pfnUnmapFile(loose);
+}
+
+TEST_CASE("Font pack rejects invalid files", "[FontPack]") {
+	write_test_file("test_pack_invalid.pack", "RTFP but not a pack");
+
+	REQUIRE(!Text::FontPack::open("test_pack_invalid.pack"));
+	REQUIRE(!Text::FontPack::open("missing.pack"));
+
+	// An entry whose end wraps past 2^64 must not pass the bounds check
+	Text::FontPackHeader header{
+		.magic = 0x50465452u,
+		.version = 1,
+		.entryCount = 1,
+		.stringTableSize = 1,
+	};
+	Text::FontPackEntry entry{
+		.dataOffset = 64,
+		.dataSize = UINT64_MAX - 32,
+		.uriOffset = 0,
+		.uriLength = 1,
+	};
+
+	std::string overflowPack(reinterpret_cast<const char*>(&header), sizeof(header));
+	overflowPack.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+	overflowPack.append(64, 'x');
+	write_test_file("test_pack_overflow.pack", overflowPack);
+
+	REQUIRE(!Text::FontPack::open("test_pack_overflow.pack"));
+
+	std::string_view missing = "missing.bin";
+	REQUIRE(!Text::FontPack::write("test_pack_missing.pack", &missing, 1));
+}
+
+static void write_test_file(const char* fileName, const std::string& contents) {
+	FILE* file = std::fopen(fileName, "wb");
+	REQUIRE(file);
+	REQUIRE(std::fwrite(contents.data(), 1, contents.size(), file) == contents.size());
+	std::fclose(file);
+}
@@ -0,0 +1,176 @@
+#include "test_common.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <font_registry.hpp>
+
+#include <iterator>
+#include <string>
+
+static constexpr const char* g_variableFamilyJSON = R"({
+	"name": "Noto Sans Variable",
+	"faces": [
+		{
+			"name": "Noto Sans Variable Regular",
+			"uri": "fonts/NotoSans/NotoSans[wdth,wght].ttf",
+			"weight": 400,
+			"style": "normal"
+		},
+		{
+			"name": "Noto Sans Variable Bold",
+			"uri": "fonts/NotoSans/NotoSans[wdth,wght].ttf",
+			"weight": 700,
+			"style": "normal",
+			"variations": {"wght": 700}
+		},
+		{
+			"name": "Noto Sans Variable Condensed Black",
+			"uri": "fonts/NotoSans/NotoSans[wdth,wght].ttf",
+			"weight": 900,
+			"style": "normal",
+			"named_instance": 1,
+			"variations": {"wght": 900, "wdth": 62.5}
+		}
+	]
+})";
+
+static Text::FontRegistryError register_json(std::string json);
+static Text::FontFamily get_variable_family();
+
+TEST_CASE("Variable font instances", "[FontRegistry]") {
+	auto family = get_variable_family();
+	REQUIRE(family);
+
+	auto regularFace = Text::FontRegistry::get_face(Text::Font(family, Text::FontWeight::REGULAR,
+			Text::FontStyle::NORMAL, 48));
+	auto boldFace = Text::FontRegistry::get_face(Text::Font(family, Text::FontWeight::BOLD, Text::FontStyle::NORMAL,
+			48));
+	auto blackFace = Text::FontRegistry::get_face(Text::Font(family, Text::FontWeight::BLACK,
+			Text::FontStyle::NORMAL, 48));
+
+	REQUIRE(regularFace);
+	REQUIRE(boldFace);
+	REQUIRE(blackFace);
+
+	// Instances share the file but not their glyphs, so caches keyed by content must keep them apart
+	REQUIRE(Text::FontRegistry::get_face_content_hash(regularFace)
+			!= Text::FontRegistry::get_face_content_hash(boldFace));
+	REQUIRE(Text::FontRegistry::get_face_content_hash(boldFace)
+			!= Text::FontRegistry::get_face_content_hash(blackFace));
+
+	auto regular = Text::FontRegistry::get_font_data(regularFace, 48);
+	auto bold = Text::FontRegistry::get_font_data(boldFace, 48);
+
+	REQUIRE(regular);
+	REQUIRE(bold);
+	REQUIRE(regular.ftFace != bold.ftFace);
+
+	auto glyph = regular.map_codepoint_to_glyph('m');
+	REQUIRE(glyph == bold.map_codepoint_to_glyph('m'));
+
+	auto regularAdvance = regular.get_glyph_advance_x(glyph);
+	auto boldAdvance = bold.get_glyph_advance_x(glyph);
+	REQUIRE(boldAdvance > regularAdvance);
+
+	// Requesting a sibling instance must leave data already handed out untouched
+	auto black = Text::FontRegistry::get_font_data(blackFace, 48);
+	REQUIRE(black);
+	REQUIRE(black.get_glyph_advance_x(glyph) != boldAdvance);
+
+	REQUIRE(regular.get_glyph_advance_x(glyph) == regularAdvance);
+	REQUIRE(bold.get_glyph_advance_x(glyph) == boldAdvance);
+	REQUIRE(Text::FontRegistry::get_font_data(regularFace, 48).get_glyph_advance_x(glyph) == regularAdvance);
+}
+
+TEST_CASE("Variable font JSON", "[FontRegistry]") {
+	REQUIRE(get_variable_family());
+
+	// Axis tags are exactly four characters
+	REQUIRE(register_json(R"({"name": "Bad Axis", "faces": [{"name": "Bad Axis Regular",
+			"uri": "fonts/NotoSans/NotoSans[wdth,wght].ttf", "weight": 400, "style": "normal",
+			"variations": {"wg": 700}}]})") == Text::FontRegistryError::INVALID_JSON);
+	REQUIRE(register_json(R"({"name": "Bad Axis Value", "faces": [{"name": "Bad Axis Value Regular",
+			"uri": "fonts/NotoSans/NotoSans[wdth,wght].ttf", "weight": 400, "style": "normal",
+			"variations": {"wght": "bold"}}]})") == Text::FontRegistryError::INVALID_JSON);
+	REQUIRE(register_json(R"({"name": "Bad Instance", "faces": [{"name": "Bad Instance Regular",
+			"uri": "fonts/NotoSans/NotoSans[wdth,wght].ttf", "weight": 400, "style": "normal",
+			"named_instance": -1}]})") == Text::FontRegistryError::INVALID_JSON);
+
+	REQUIRE(!Text::FontRegistry::get_family("Bad Axis"));
+	REQUIRE(!Text::FontRegistry::get_family("Bad Instance"));
+}
+
+TEST_CASE("Font registry trimming", "[FontRegistry]") {
+	init_font_registry();
+
+	const char* familyNames[] = {"Noto Sans", "Noto Naskh Arabic", "Noto Serif Devanagari"};
+	Text::FontFace faces[3]{};
+
+	for (size_t i = 0; i < std::size(familyNames); ++i) {
+		Text::Font font(Text::FontRegistry::get_family(familyNames[i]), Text::FontWeight::REGULAR,
+				Text::FontStyle::NORMAL, 24);
+		faces[i] = Text::FontRegistry::get_face(font);
+	}
+
+	Text::FontRegistry::release_thread_data();
+	REQUIRE(Text::FontRegistry::get_thread_usage().faceCount == 0);
+	REQUIRE(Text::FontRegistry::get_thread_usage().memoryBytes == 0);
+
+	for (auto face : faces) {
+		REQUIRE(Text::FontRegistry::get_font_data(face, 24));
+	}
+
+	auto usage = Text::FontRegistry::get_thread_usage();
+	REQUIRE(usage.faceCount == 3);
+	REQUIRE(usage.memoryBytes > 0);
+
+	SECTION("Idle faces") {
+		Text::FontRegistry::advance_frame();
+		Text::FontRegistry::advance_frame();
+		REQUIRE(Text::FontRegistry::get_font_data(faces[1], 24));
+
+		Text::FontRegistry::trim({.maxIdleFrames = 1});
+		REQUIRE(Text::FontRegistry::get_thread_usage().faceCount == 1);
+
+		// Evicted faces reopen on demand
+		REQUIRE(Text::FontRegistry::get_font_data(faces[0], 24));
+		REQUIRE(Text::FontRegistry::get_thread_usage().faceCount == 2);
+	}
+
+	SECTION("Face count budget evicts least recently used") {
+		REQUIRE(Text::FontRegistry::get_font_data(faces[0], 24));
+		Text::FontRegistry::trim({.maxFaceCount = 2});
+		REQUIRE(Text::FontRegistry::get_thread_usage().faceCount == 2);
+
+		Text::FontRegistry::trim({.maxFaceCount = 1});
+		REQUIRE(Text::FontRegistry::get_thread_usage().faceCount == 1);
+		REQUIRE(Text::FontRegistry::get_thread_usage().memoryBytes < usage.memoryBytes);
+	}
+
+	SECTION("Memory budget") {
+		Text::FontRegistry::trim({.maxMemoryBytes = 1});
+		REQUIRE(Text::FontRegistry::get_thread_usage().faceCount == 0);
+	}
+
+	Text::FontRegistry::release_thread_data();
+	REQUIRE(Text::FontRegistry::get_thread_usage().memoryBytes == 0);
+}
+
+// Static Functions
+
+static Text::FontRegistryError register_json(std::string json) {
+	// The parser reads up to `SIMDJSON_PADDING` bytes past the end of the document
+	json.append(64, ' ');
+	return Text::FontRegistry::register_family_from_json_data(json);
+}
+
+static Text::FontFamily get_variable_family() {
+	static bool registered = false;
+
+	if (!registered) {
+		registered = true;
+		REQUIRE(register_json(g_variableFamilyJSON) == Text::FontRegistryError::NONE);
+	}
+
+	return Text::FontRegistry::get_family("Noto Sans Variable");
+}
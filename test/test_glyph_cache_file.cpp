@@ -0,0 +1,205 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <glyph_cache_file.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <initializer_list>
+
+struct TestGlyph {
+	Text::GlyphCacheKey key;
+	Bitmap bitmap;
+	float offset[2];
+	bool hasColor;
+};
+
+static Text::GlyphCacheKey make_test_key(uint32_t glyphIndex);
+static Bitmap make_test_bitmap(uint32_t width, uint32_t height, std::initializer_list<uint32_t> pattern);
+static void require_glyph(const Text::GlyphCacheFile& cache, const TestGlyph& glyph);
+
+TEST_CASE("Glyph cache round trip", "[GlyphCacheFile]") {
+	static constexpr const char* FILE_NAME = "test_glyph_cache.bin";
+	std::filesystem::remove(FILE_NAME);
+
+	// Runs shorter than the 3 pixels worth encoding, runs at the start and end, and a fully uniform bitmap
+	TestGlyph glyphs[] = {
+		{make_test_key(1), make_test_bitmap(7, 5, {0, 0, 0, 0, 0xFF00FF00u, 0xFF00FF00u, 1, 2, 2, 2}), {1.f, -2.f},
+				false},
+		{make_test_key(2), make_test_bitmap(9, 3, {5, 6, 7, 8}), {0.5f, 3.f}, true},
+		{make_test_key(3), make_test_bitmap(16, 16, {0xFFFFFFFFu}), {0.f, 0.f}, false},
+		{make_test_key(4), make_test_bitmap(1, 1, {42}), {-1.f, 1.f}, false},
+		{make_test_key(5), make_test_bitmap(0, 0, {0}), {0.f, 0.f}, false},
+	};
+
+	{
+		Text::GlyphCacheFile cache;
+		REQUIRE(!cache.open(FILE_NAME));
+
+		// Inserted out of key order
+		for (auto i : {3, 0, 4, 1}) {
+			cache.insert(glyphs[i].key, glyphs[i].bitmap, glyphs[i].offset, glyphs[i].hasColor);
+		}
+
+		for (auto i : {3, 0, 4, 1}) {
+			require_glyph(cache, glyphs[i]);
+		}
+
+		REQUIRE(cache.save());
+
+		// Entries are served from the new mapping after saving
+		for (auto i : {3, 0, 4, 1}) {
+			require_glyph(cache, glyphs[i]);
+		}
+	}
+
+	{
+		Text::GlyphCacheFile cache;
+		REQUIRE(cache.open(FILE_NAME));
+
+		for (auto i : {0, 1, 3, 4}) {
+			require_glyph(cache, glyphs[i]);
+		}
+
+		// Merge a new entry and replace a mapped one
+		glyphs[0].bitmap = make_test_bitmap(4, 4, {9, 9, 9, 3});
+		glyphs[0].hasColor = true;
+		cache.insert(glyphs[0].key, glyphs[0].bitmap, glyphs[0].offset, glyphs[0].hasColor);
+		cache.insert(glyphs[2].key, glyphs[2].bitmap, glyphs[2].offset, glyphs[2].hasColor);
+
+		REQUIRE(cache.save());
+	}
+
+	{
+		Text::GlyphCacheFile cache;
+		REQUIRE(cache.open(FILE_NAME));
+
+		for (auto& glyph : glyphs) {
+			require_glyph(cache, glyph);
+		}
+
+		Bitmap bitmap;
+		float offset[2];
+		bool hasColor;
+		REQUIRE(!cache.find(make_test_key(6), bitmap, offset, hasColor));
+	}
+
+	std::filesystem::remove(FILE_NAME);
+}
+
+TEST_CASE("Glyph cache failed save", "[GlyphCacheFile]") {
+	// A non-empty directory cannot be replaced by a file, so the save fails after writing its temporary file
+	static constexpr const char* DIRECTORY_NAME = "test_glyph_cache_dir.bin";
+	std::filesystem::remove_all(DIRECTORY_NAME);
+	std::filesystem::create_directory(DIRECTORY_NAME);
+	std::filesystem::create_directory(std::filesystem::path(DIRECTORY_NAME) / "child");
+
+	TestGlyph glyph{make_test_key(1), make_test_bitmap(3, 2, {1, 2, 3}), {2.f, 4.f}, false};
+
+	Text::GlyphCacheFile cache;
+	REQUIRE(!cache.open(DIRECTORY_NAME));
+
+	cache.insert(glyph.key, glyph.bitmap, glyph.offset, glyph.hasColor);
+	REQUIRE(!cache.save());
+
+	// Nothing may be lost to a failed save
+	require_glyph(cache, glyph);
+	REQUIRE(!std::filesystem::exists(std::string(DIRECTORY_NAME) + ".tmp"));
+
+	std::filesystem::remove_all(DIRECTORY_NAME);
+}
+
+TEST_CASE("Glyph cache corrupt entries", "[GlyphCacheFile]") {
+	static constexpr const char* FILE_NAME = "test_glyph_cache_corrupt.bin";
+	// The only entry directly follows the 16 byte header, its data directly follows the entry
+	static constexpr const long DATA_OFFSET_POSITION = 16 + 8;
+	static constexpr const long DATA_POSITION = 16 + 48;
+
+	TestGlyph glyph{make_test_key(1), make_test_bitmap(3, 2, {1, 2, 3}), {2.f, 4.f}, false};
+
+	auto writeCorruptFile = [&](long position, const void* data, size_t size) {
+		std::filesystem::remove(FILE_NAME);
+
+		{
+			Text::GlyphCacheFile cache;
+			REQUIRE(!cache.open(FILE_NAME));
+			cache.insert(glyph.key, glyph.bitmap, glyph.offset, glyph.hasColor);
+			REQUIRE(cache.save());
+		}
+
+		auto* file = std::fopen(FILE_NAME, "r+b");
+		REQUIRE(file);
+		REQUIRE(std::fseek(file, position, SEEK_SET) == 0);
+		REQUIRE(std::fwrite(data, 1, size, file) == size);
+		std::fclose(file);
+	};
+
+	SECTION("Out of bounds offset") {
+		// Wraps around when the data size is added to it
+		uint64_t dataOffset = ~uint64_t{0} - 3;
+		writeCorruptFile(DATA_OFFSET_POSITION, &dataOffset, sizeof(dataOffset));
+
+		Text::GlyphCacheFile cache;
+		REQUIRE(!cache.open(FILE_NAME));
+	}
+
+	SECTION("Undecodable data") {
+		// A literal span longer than the bitmap
+		uint32_t token = 0xFFFF'FFFEu;
+		writeCorruptFile(DATA_POSITION, &token, sizeof(token));
+
+		Text::GlyphCacheFile cache;
+		REQUIRE(cache.open(FILE_NAME));
+
+		Bitmap bitmap;
+		float offset[2];
+		bool hasColor;
+		REQUIRE(!cache.find(glyph.key, bitmap, offset, hasColor));
+
+		// The re-rasterized glyph is found over the bad mapped entry
+		cache.insert(glyph.key, glyph.bitmap, glyph.offset, glyph.hasColor);
+		require_glyph(cache, glyph);
+	}
+
+	std::filesystem::remove(FILE_NAME);
+}
+
+// Static Functions
+
+static Text::GlyphCacheKey make_test_key(uint32_t glyphIndex) {
+	return {
+		.fontHash = 0x1234'5678'9ABC'DEF0ull,
+		.glyphIndex = glyphIndex,
+		.size = 24,
+		.strokeThickness = 0,
+		.strokeType = StrokeType::NONE,
+		.type = Text::GlyphCacheEntryType::BITMAP,
+	};
+}
+
+// Fills the bitmap by repeating `pattern` over its pixels in order
+static Bitmap make_test_bitmap(uint32_t width, uint32_t height, std::initializer_list<uint32_t> pattern) {
+	Bitmap bitmap(width, height);
+
+	for (uint32_t i = 0; i < width * height; ++i) {
+		bitmap.data()[i] = pattern.begin()[i % pattern.size()];
+	}
+
+	return bitmap;
+}
+
+static void require_glyph(const Text::GlyphCacheFile& cache, const TestGlyph& glyph) {
+	Bitmap bitmap;
+	float offset[2]{};
+	bool hasColor{};
+
+	REQUIRE(cache.find(glyph.key, bitmap, offset, hasColor));
+	REQUIRE(bitmap.get_width() == glyph.bitmap.get_width());
+	REQUIRE(bitmap.get_height() == glyph.bitmap.get_height());
+	REQUIRE(std::memcmp(bitmap.data(), glyph.bitmap.data(),
+			size_t{bitmap.get_width()} * bitmap.get_height() * sizeof(uint32_t)) == 0);
+	REQUIRE(offset[0] == glyph.offset[0]);
+	REQUIRE(offset[1] == glyph.offset[1]);
+	REQUIRE(hasColor == glyph.hasColor);
+}
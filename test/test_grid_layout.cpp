@@ -0,0 +1,121 @@
+#include "test_common.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <font_registry.hpp>
+#include <grid_layout.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <string>
+
+TEST_CASE("Grid layout", "[GridLayout]") {
+	init_font_registry();
+	auto family = Text::FontRegistry::get_family("Noto Sans Mono CJK");
+	Text::Font font(family, Text::FontWeight::REGULAR, Text::FontStyle::NORMAL, 16);
+	Text::GridLayout grid(font);
+	Text::GridLine line;
+
+	REQUIRE(grid.get_cell_width() > 0.f);
+	REQUIRE(grid.get_row_height() > 0.f);
+
+	SECTION("Columns") {
+		// a b <tab> 日 本, the CJK characters are wide
+		std::string text = "ab\t\xe6\x97\xa5\xe6\x9c\xac";
+		REQUIRE(grid.build_line(line, text.data(), static_cast<int32_t>(text.size())));
+
+		REQUIRE(line.get_column_count() == 12);
+		REQUIRE(line.get_char_count() == text.size());
+		REQUIRE(line.get_glyph_count() == 4);
+
+		REQUIRE(line.get_char_index_at_column(1) == 1);
+		REQUIRE(line.get_char_index_at_column(5) == 2);
+		REQUIRE(line.get_char_index_at_column(9) == 3);
+		REQUIRE(line.get_char_index_at_column(10) == 6);
+		REQUIRE(line.get_char_index_at_column(12) == text.size());
+		REQUIRE(line.get_column_at_char_index(2) == 2);
+		REQUIRE(line.get_column_at_char_index(4) == 8);
+		REQUIRE(line.get_column_at_char_index(6) == 10);
+
+		REQUIRE(line.get_next_cursor_position(2) == 3);
+		REQUIRE(line.get_next_cursor_position(3) == 6);
+		REQUIRE(line.get_next_cursor_position(6) == text.size());
+		REQUIRE(line.get_previous_cursor_position(6) == 3);
+		REQUIRE(line.get_previous_cursor_position(3) == 2);
+		REQUIRE(line.get_previous_cursor_position(0) == 0);
+
+		// Each glyph is centered on its cells, which in a fixed pitch face puts it at the start of its first cell
+		const uint32_t glyphColumns[] = {0, 1, 8, 10};
+		const uint32_t glyphColumnCounts[] = {1, 1, 2, 2};
+
+		for (size_t i = 0; i < line.get_glyph_count(); ++i) {
+			auto fontData = Text::FontRegistry::get_font_data(line.get_glyph_font(i));
+			auto advance = fontData.get_glyph_advance_x(line.get_glyph_id(i)) / 64.f;
+			auto cellsWidth = static_cast<float>(glyphColumnCounts[i]) * grid.get_cell_width();
+			auto columnX = grid.get_column_x(glyphColumns[i]);
+
+			REQUIRE(fabsf(advance - cellsWidth) <= 1.f);
+			REQUIRE(fabsf(line.get_glyph_x(i) - (columnX + 0.5f * (cellsWidth - advance))) < 0.001f);
+			REQUIRE(fabsf(line.get_glyph_x(i) - columnX) <= 0.5f);
+		}
+	}
+
+	SECTION("Lines needing full layout") {
+		const char* strings[] = {
+			"abc \xd8\xa7\xd9\x84\xd8\xb9\xd8\xb1\xd8\xa8\xd9\x8a\xd8\xa9",
+			"e\xcc\x81",
+			"\xe0\xa4\x95\xe0\xa5\x8d\xe0\xa4\xb7",
+		};
+
+		for (auto* str : strings) {
+			REQUIRE(!grid.build_line(line, str, static_cast<int32_t>(strlen(str))));
+			REQUIRE(line.get_glyph_count() == 0);
+			REQUIRE(line.get_column_count() == 0);
+		}
+	}
+
+	SECTION("Hit testing and scrolling") {
+		auto cell = grid.get_cell_at(2.5f * grid.get_cell_width(), 3.5f * grid.get_row_height());
+		REQUIRE(cell.row == 3);
+		REQUIRE(cell.column == 2);
+		REQUIRE(grid.get_closest_column_boundary(2.75f * grid.get_cell_width()) == 3);
+
+		size_t firstRow;
+		size_t rowLimit;
+		grid.get_visible_rows(500'000.5f * grid.get_row_height(), 10.f * grid.get_row_height(), 1'000'000,
+				firstRow, rowLimit);
+		REQUIRE(firstRow == 500'000);
+		REQUIRE(rowLimit == 500'011);
+
+		grid.get_visible_rows(999'995.f * grid.get_row_height(), 10.f * grid.get_row_height(), 1'000'000,
+				firstRow, rowLimit);
+		REQUIRE(rowLimit == 1'000'000);
+	}
+}
+
+TEST_CASE("Monospace families", "[GridLayout]") {
+	init_font_registry();
+	auto family = Text::FontRegistry::get_family("Noto Sans");
+	REQUIRE(!Text::FontRegistry::is_monospace(Text::Font(family, Text::FontWeight::REGULAR,
+			Text::FontStyle::NORMAL, 16)));
+	REQUIRE(Text::FontRegistry::is_monospace(Text::Font(Text::FontRegistry::get_family("Noto Sans Mono CJK"),
+			Text::FontWeight::REGULAR, Text::FontStyle::NORMAL, 16)));
+
+	Text::FontFaceCreateInfo faceInfo{
+		.name = "Noto Sans Grid Test Regular",
+		.uri = "fonts/NotoSans/NotoSans-Regular.ttf",
+		.weight = Text::FontWeight::REGULAR,
+		.style = Text::FontStyle::NORMAL,
+	};
+
+	REQUIRE(Text::FontRegistry::register_family({
+		.name = "Noto Sans Grid Test",
+		.pFaces = &faceInfo,
+		.faceCount = 1,
+		.monospace = true,
+	}) == Text::FontRegistryError::NONE);
+
+	auto monoFamily = Text::FontRegistry::get_family("Noto Sans Grid Test");
+	REQUIRE(Text::FontRegistry::is_monospace(Text::Font(monoFamily, Text::FontWeight::REGULAR,
+			Text::FontStyle::NORMAL, 16)));
+}
@@ -1,13 +1,17 @@
+#include "test_common.hpp"
+
 #include <catch2/catch_test_macros.hpp>
 
+#include <cursor_controller.hpp>
 #include <font_registry.hpp>
 #include <layout_info.hpp>
+#include <shaped_text.hpp>
 
 #include <unicode/unistr.h>
 
+#include <algorithm>
 #include <cmath>
-
-static bool g_initialized = false;
+#include <cstring>
 
 static constexpr const char* g_testStrings[] = {
 	"HelloWorld",
@@ -21,11 +25,11 @@ static constexpr const char* g_testStrings[] = {
 	//"aaa\u2067אאא\u2066bbb\u202bבבב\u202cccc\u2069גגג",
 };
 
-static void init_font_registry();
-
 static void test_lx_vs_icu(Text::Font font, const char* str, float width);
 static void test_lx_vs_utf8(Text::Font font, const char* str, float width);
-static void test_compare_layouts(const Text::LayoutInfo& lxLayout, const Text::LayoutInfo& icuLayout);
+static void test_lx_vs_utf16(Text::Font font, const char* str, float width);
+static void test_reflow_width(Text::Font font, const char* str, float width);
+static void test_reflow_scaling(Text::Font font, const char* str, float fontScale);
 
 TEST_CASE("ICU UTF-16", "[LayoutInfo]") {
 	init_font_registry();
@@ -63,18 +67,238 @@ TEST_CASE("ICU UTF-8", "[LayoutInfo]") {
 	}
 }
 
-// Static Functions
+TEST_CASE("SheenBidi UTF-16", "[LayoutInfo]") {
+	init_font_registry();
+	auto family = Text::FontRegistry::get_family("Noto Sans"); 
+	Text::Font font(family, Text::FontWeight::REGULAR, Text::FontStyle::NORMAL, 48);
+
+	SECTION("Single Font Softbreaking") {
+		for (size_t i = 0; i < std::ssize(g_testStrings); ++i) {
+			test_lx_vs_utf16(font, g_testStrings[i], 100.f);
+		}
+	}
+
+	SECTION("Single Font No Softbreaking") {
+		for (size_t i = 0; i < std::ssize(g_testStrings); ++i) {
+			test_lx_vs_utf16(font, g_testStrings[i], 0.f);
+		}
+	}
+}
+
+TEST_CASE("Final word fits exactly", "[LayoutInfo]") {
+	init_font_registry();
+	auto family = Text::FontRegistry::get_family("Noto Sans"); 
+	Text::Font font(family, Text::FontWeight::REGULAR, Text::FontStyle::NORMAL, 48);
+	const char* str = "Hello World";
+	auto count = static_cast<int32_t>(strlen(str));
+	Text::ValueRuns<Text::Font> fontRuns(font, count);
+
+	Text::LayoutInfo unwrapped{};
+	build_layout_info_utf8(unwrapped, str, count, fontRuns, 0.f, 100.f, TextYAlignment::BOTTOM,
+			Text::LayoutInfoFlags::NONE);
+	auto width = unwrapped.get_line_width(0);
+
+	// A line ending in a word that exactly fits, with or without hanging whitespace, must not wrap that word
+	for (auto* testString : {"Hello World", "Hello World ", "Hello World\t "}) {
+		auto testCount = static_cast<int32_t>(strlen(testString));
+		Text::ValueRuns<Text::Font> testFontRuns(font, testCount);
+
+		Text::LayoutInfo layout{};
+		build_layout_info_utf8(layout, testString, testCount, testFontRuns, width, 100.f, TextYAlignment::BOTTOM,
+				Text::LayoutInfoFlags::NONE);
+		REQUIRE(layout.get_line_count() == 1);
+
+		test_lx_vs_utf8(font, testString, width);
+		test_lx_vs_utf16(font, testString, width);
+	}
+
+	Text::LayoutInfo wrapped{};
+	build_layout_info_utf8(wrapped, str, count, fontRuns, width - 1.f, 100.f, TextYAlignment::BOTTOM,
+			Text::LayoutInfoFlags::NONE);
+	REQUIRE(wrapped.get_line_count() == 2);
+
+	test_lx_vs_utf8(font, str, width - 1.f);
+}
+
+TEST_CASE("Shaped Text Reflow", "[LayoutInfo]") {
+	init_font_registry();
+	auto family = Text::FontRegistry::get_family("Noto Sans"); 
+	Text::Font font(family, Text::FontWeight::REGULAR, Text::FontStyle::NORMAL, 48);
+	const char* wrappingString = "Hello World, this text wraps across several lines";
+
+	SECTION("Width Change") {
+		test_reflow_width(font, wrappingString, 150.f);
+
+		for (size_t i = 0; i < std::ssize(g_testStrings); ++i) {
+			test_reflow_width(font, g_testStrings[i], 100.f);
+		}
+	}
+
+	SECTION("Scale Change") {
+		for (auto fontScale : {0.5f, 1.5f, 2.f}) {
+			test_reflow_scaling(font, wrappingString, fontScale);
+
+			for (size_t i = 0; i < std::ssize(g_testStrings); ++i) {
+				test_reflow_scaling(font, g_testStrings[i], fontScale);
+			}
+		}
+	}
+}
+
+TEST_CASE("Cursor Boundaries", "[LayoutInfo]") {
+	init_font_registry();
+	auto family = Text::FontRegistry::get_family("Noto Sans");
+	Text::Font font(family, Text::FontWeight::REGULAR, Text::FontStyle::NORMAL, 48);
+
+	// "a" + U+0308 COMBINING DIAERESIS forms a single grapheme spanning bytes [10, 13)
+	const char* str = "foo  bar\nba\xCC\x88z";
+	auto count = static_cast<int32_t>(std::strlen(str));
+	Text::ValueRuns<Text::Font> fontRuns(font, count);
+
+	Text::LayoutInfo layout{};
+	Text::build_layout_info_utf8(layout, str, count, fontRuns, 0.f, 100.f, TextYAlignment::TOP,
+			Text::LayoutInfoFlags::NONE);
+
+	Text::CursorController ctrl{};
+	auto pos = [](uint32_t p) { return CursorPosition{p}; };
+
+	SECTION("Characters") {
+		REQUIRE(ctrl.next_character(layout, pos(0)) == pos(1));
+		REQUIRE(ctrl.next_character(layout, pos(10)) == pos(13));
+		REQUIRE(ctrl.prev_character(layout, pos(13)) == pos(10));
+		REQUIRE(ctrl.next_character(layout, pos(14)) == pos(14));
+		REQUIRE(ctrl.prev_character(layout, pos(0)) == pos(0));
+	}
 
-static void init_font_registry() {
-	if (g_initialized) {
-		return;
+	SECTION("Words") {
+		REQUIRE(ctrl.next_word(layout, pos(0)) == pos(5));
+		REQUIRE(ctrl.next_word(layout, pos(5)) == pos(8));
+		REQUIRE(ctrl.next_word(layout, pos(8)) == pos(9));
+		REQUIRE(ctrl.next_word(layout, pos(9)) == pos(14));
+		REQUIRE(ctrl.prev_word(layout, pos(14)) == pos(9));
+		REQUIRE(ctrl.prev_word(layout, pos(9)) == pos(8));
+		REQUIRE(ctrl.prev_word(layout, pos(7)) == pos(5));
+		REQUIRE(ctrl.prev_word(layout, pos(5)) == pos(0));
 	}
+}
+
+TEST_CASE("Selection Rects", "[LayoutInfo]") {
+	init_font_registry();
+	auto family = Text::FontRegistry::get_family("Noto Sans");
+	Text::Font font(family, Text::FontWeight::REGULAR, Text::FontStyle::NORMAL, 48);
+
+	const char* str = "Hello world\n\nthe quick brown fox jumps over the lazy dog\r\nend";
+	auto count = static_cast<int32_t>(std::strlen(str));
+	Text::ValueRuns<Text::Font> fontRuns(font, count);
+
+	Text::LayoutInfo layout{};
+	Text::build_layout_info_utf8(layout, str, count, fontRuns, 300.f, 100.f, TextYAlignment::TOP,
+			Text::LayoutInfoFlags::NONE);
+
+	// Every range must produce the same rects as testing each run of the document
+	for (uint32_t start = 0; start < static_cast<uint32_t>(count); start += 3) {
+		for (uint32_t end = start + 1; end <= static_cast<uint32_t>(count); end += 7) {
+			std::vector<Text::SelectionRect> expected;
+			layout.for_each_run(300.f, TextXAlignment::LEFT, [&](auto lineIndex, auto runIndex, auto lineX,
+					auto lineY) {
+				if (layout.run_contains_char_range(runIndex, start, end)) {
+					auto [minPos, maxPos] = layout.get_position_range_in_run(runIndex, start, end);
+					expected.push_back({lineX + minPos, lineY - layout.get_line_ascent(lineIndex), maxPos - minPos,
+							layout.get_line_height(lineIndex)});
+				}
+			});
+
+			std::vector<Text::SelectionRect> rects;
+			layout.get_selection_rects(300.f, TextXAlignment::LEFT, start, end, rects);
+
+			REQUIRE(rects.size() == expected.size());
+
+			for (auto& rect : expected) {
+				REQUIRE(std::any_of(rects.begin(), rects.end(), [&](auto& r) {
+					return r.x == rect.x && r.width == rect.width && std::abs(r.y - rect.y) < 0.01f
+							&& r.height == rect.height;
+				}));
+			}
+		}
+	}
+}
+
+TEST_CASE("Batch Hit Test", "[LayoutInfo]") {
+	init_font_registry();
+	auto family = Text::FontRegistry::get_family("Noto Sans");
+	Text::Font font(family, Text::FontWeight::REGULAR, Text::FontStyle::NORMAL, 48);
 
-	g_initialized = true;
-	auto res = Text::FontRegistry::register_families_from_path("fonts/families");
-	REQUIRE(res == Text::FontRegistryError::NONE);
+	const char* str = "Hello world\n\nthe quick brown fox jumps over the lazy dog\r\nend";
+	auto count = static_cast<int32_t>(std::strlen(str));
+	Text::ValueRuns<Text::Font> fontRuns(font, count);
+
+	Text::LayoutInfo layout{};
+	Text::build_layout_info_utf8(layout, str, count, fontRuns, 300.f, 100.f, TextYAlignment::TOP,
+			Text::LayoutInfoFlags::NONE);
+
+	std::vector<float> points;
+
+	for (float y = -10.f; y < layout.get_text_height() + 20.f; y += 7.f) {
+		for (float x = -20.f; x < 340.f; x += 13.f) {
+			points.push_back(x);
+			points.push_back(y);
+		}
+	}
+
+	auto pointCount = points.size() / 2;
+	std::vector<Text::HitTestResult> results(pointCount);
+	Text::CursorController ctrl{};
+	ctrl.closest_to_positions(layout, 300.f, TextXAlignment::CENTER, points.data(), pointCount, results.data());
+
+	for (size_t i = 0; i < pointCount; ++i) {
+		auto& result = results[i];
+		REQUIRE(result.cursor == ctrl.closest_to_position(layout, 300.f, TextXAlignment::CENTER, points[2 * i],
+				points[2 * i + 1]));
+		REQUIRE(result.runIndex >= layout.get_first_run_index(result.lineIndex));
+		REQUIRE(result.runIndex < layout.get_line_run_end_index(result.lineIndex));
+		REQUIRE(result.glyphIndex >= layout.get_first_glyph_index(result.runIndex));
+		REQUIRE(result.glyphIndex <= layout.get_run_glyph_end_index(result.runIndex));
+	}
+
+	// An empty batch must not touch the point or result arrays
+	layout.hit_test(300.f, TextXAlignment::CENTER, nullptr, 0, nullptr);
+	ctrl.closest_to_positions(layout, 300.f, TextXAlignment::CENTER, nullptr, 0, nullptr);
 }
 
+TEST_CASE("Boundary Bitset", "[LayoutInfo]") {
+	Text::BoundaryBitset bits;
+	bits.reset(200);
+	bits.set(0);
+	bits.set(63);
+	bits.set(64);
+	bits.set(200);
+
+	REQUIRE(bits.next(0) == 63);
+	REQUIRE(bits.next(63) == 64);
+	REQUIRE(bits.next(64) == 200);
+	REQUIRE(bits.next(200) == Text::BoundaryBitset::INVALID_INDEX);
+	REQUIRE(bits.prev(200) == 64);
+	REQUIRE(bits.prev(64) == 63);
+	REQUIRE(bits.prev(63) == 0);
+	REQUIRE(bits.prev(0) == Text::BoundaryBitset::INVALID_INDEX);
+	REQUIRE(bits.prev(500) == 200);
+
+	SECTION("Empty") {
+		Text::BoundaryBitset empty;
+		bits.clear();
+
+		for (auto* pBits : {&empty, &bits}) {
+			REQUIRE(!pBits->test(0));
+			REQUIRE(!pBits->test(200));
+			REQUIRE(pBits->next(0) == Text::BoundaryBitset::INVALID_INDEX);
+			REQUIRE(pBits->prev(0) == Text::BoundaryBitset::INVALID_INDEX);
+			REQUIRE(pBits->prev(500) == Text::BoundaryBitset::INVALID_INDEX);
+		}
+	}
+}
+
+// Static Functions
+
 static void test_lx_vs_icu(Text::Font font, const char* str, float width) {
 	icu::UnicodeString text(str);
 	Text::ValueRuns<Text::Font> fontRuns(font, text.length());
@@ -109,44 +333,94 @@ static void test_lx_vs_utf8(Text::Font font, const char* str, float width) {
 	test_compare_layouts(lxLayout8, utf8Layout);
 }
 
-static void test_compare_layouts(const Text::LayoutInfo& lxLayout, const Text::LayoutInfo& icuLayout) {
-	REQUIRE(lxLayout.get_run_count() == icuLayout.get_run_count());
-	REQUIRE(lxLayout.get_glyph_count() == icuLayout.get_glyph_count());
-	REQUIRE(lxLayout.get_char_index_count() == icuLayout.get_char_index_count());
-	REQUIRE(lxLayout.get_glyph_position_data_count() == icuLayout.get_glyph_position_data_count());
-	REQUIRE(lxLayout.get_line_count() == icuLayout.get_line_count());
+static void test_lx_vs_utf16(Text::Font font, const char* str, float width) {
+	icu::UnicodeString text(str);
+	Text::ValueRuns<Text::Font> fontRuns(font, text.length());
+
+	Text::LayoutInfo lxLayout{};
+	build_layout_info_icu_lx(lxLayout, text.getBuffer(), text.length(), fontRuns, width, 100.f,
+			TextYAlignment::BOTTOM, Text::LayoutInfoFlags::NONE);
+
+	Text::LayoutInfo utf16Layout{};
+	build_layout_info_utf16(utf16Layout, text.getBuffer(), text.length(), fontRuns, width, 100.f,
+			TextYAlignment::BOTTOM, Text::LayoutInfoFlags::NONE);
+
+	test_compare_layouts(lxLayout, utf16Layout);
+}
+
+static void test_reflow_width(Text::Font font, const char* str, float width) {
+	auto count = static_cast<int32_t>(strlen(str));
+	Text::ValueRuns<Text::Font> fontRuns(font, count);
+
+	Text::ShapedText shapedText{};
+	shape_text_utf8(shapedText, str, count, fontRuns, Text::LayoutInfoFlags::NONE);
+
+	Text::LayoutInfo unwrapped{};
+	build_layout_info_shaped(unwrapped, shapedText, str, count, 1.f, 0.f, 100.f, TextYAlignment::TOP);
 
-	for (size_t i = 0; i < lxLayout.get_glyph_count(); ++i) {
-		REQUIRE(lxLayout.get_glyph_id(i) == icuLayout.get_glyph_id(i));
+	Text::LayoutInfo layout{};
+	build_layout_info_shaped(layout, shapedText, str, count, 1.f, 0.f, 100.f, TextYAlignment::TOP);
+	reflow_layout_info(layout, shapedText, str, count, 1.f, width, 100.f, TextYAlignment::TOP);
+
+	// Wrapping moves glyphs onto new lines without reshaping them
+	REQUIRE(layout.get_glyph_count() == unwrapped.get_glyph_count());
+
+	for (uint32_t i = 0; i < layout.get_glyph_count(); ++i) {
+		REQUIRE(layout.get_glyph_id(i) == unwrapped.get_glyph_id(i));
 	}
 
-	for (size_t i = 0; i < lxLayout.get_char_index_count(); ++i) {
-		REQUIRE(lxLayout.get_char_index(i) == icuLayout.get_char_index(i));
+	if (unwrapped.get_line_width(0) > width) {
+		REQUIRE(layout.get_line_count() > unwrapped.get_line_count());
 	}
 
-	auto* lxPosData = lxLayout.get_glyph_position_data();
-	auto* icuPosData = icuLayout.get_glyph_position_data();
-	for (size_t i = 0; i < lxLayout.get_glyph_position_data_count(); ++i) {
-		REQUIRE(fabsf(lxPosData[i] - icuPosData[i]) < 0.01f);
+	// Reflowing back to the original width restores the original lines
+	reflow_layout_info(layout, shapedText, str, count, 1.f, 0.f, 100.f, TextYAlignment::TOP);
+	test_compare_layouts(layout, unwrapped);
+}
+
+// Shaped text is stored unhinted, so reflowing at another scale must scale every position and metric linearly
+static void test_reflow_scaling(Text::Font font, const char* str, float fontScale) {
+	auto count = static_cast<int32_t>(strlen(str));
+	Text::ValueRuns<Text::Font> fontRuns(font, count);
+
+	Text::ShapedText shapedText{};
+	shape_text_utf8(shapedText, str, count, fontRuns, Text::LayoutInfoFlags::NONE);
+
+	Text::LayoutInfo base{};
+	build_layout_info_shaped(base, shapedText, str, count, 1.f, 0.f, 100.f, TextYAlignment::TOP);
+
+	Text::LayoutInfo scaled{};
+	build_layout_info_shaped(scaled, shapedText, str, count, 1.f, 0.f, 100.f, TextYAlignment::TOP);
+	reflow_layout_info(scaled, shapedText, str, count, fontScale, 0.f, 100.f, TextYAlignment::TOP);
+
+	REQUIRE(scaled.get_run_count() == base.get_run_count());
+	REQUIRE(scaled.get_glyph_count() == base.get_glyph_count());
+	REQUIRE(scaled.get_glyph_position_data_count() == base.get_glyph_position_data_count());
+	REQUIRE(scaled.get_line_count() == base.get_line_count());
+
+	for (uint32_t i = 0; i < scaled.get_glyph_count(); ++i) {
+		REQUIRE(scaled.get_glyph_id(i) == base.get_glyph_id(i));
 	}
 
-	for (size_t i = 0; i < lxLayout.get_run_count(); ++i) {
-		REQUIRE(lxLayout.get_run_font(i) == icuLayout.get_run_font(i));
-		REQUIRE(lxLayout.get_run_glyph_end_index(i) == icuLayout.get_run_glyph_end_index(i));
-		REQUIRE(lxLayout.is_run_rtl(i) == icuLayout.is_run_rtl(i));
-		REQUIRE(lxLayout.get_run_char_start_index(i) == icuLayout.get_run_char_start_index(i));
-		REQUIRE(lxLayout.get_run_char_end_index(i) == icuLayout.get_run_char_end_index(i));
-		REQUIRE(lxLayout.get_run_char_end_offset(i) == icuLayout.get_run_char_end_offset(i));
+	auto* scaledPosData = scaled.get_glyph_position_data();
+	auto* basePosData = base.get_glyph_position_data();
+
+	for (size_t i = 0; i < scaled.get_glyph_position_data_count(); ++i) {
+		REQUIRE(fabsf(scaledPosData[i] - basePosData[i] * fontScale) < 0.01f);
 	}
 
-	for (size_t i = 0; i < lxLayout.get_line_count(); ++i) {
-		REQUIRE(lxLayout.get_line_run_end_index(i) == icuLayout.get_line_run_end_index(i));
-		// LayoutEx truncates width to an integer, so there is some discrepancy
-		REQUIRE(fabsf(lxLayout.get_line_width(i) - icuLayout.get_line_width(i)) < 1.f);
-		REQUIRE(lxLayout.get_line_ascent(i) == icuLayout.get_line_ascent(i));
-		REQUIRE(lxLayout.get_line_total_descent(i) == icuLayout.get_line_total_descent(i));
+	for (size_t i = 0; i < scaled.get_run_count(); ++i) {
+		auto& scaledFont = scaled.get_run_font(i);
+		auto& baseFont = base.get_run_font(i);
+
+		REQUIRE(scaledFont.face == baseFont.face);
+		REQUIRE(scaledFont.size == static_cast<uint32_t>(std::lround(static_cast<float>(baseFont.size)
+				* fontScale)));
 	}
 
-	REQUIRE(lxLayout.get_text_start_y() == icuLayout.get_text_start_y());
+	for (size_t i = 0; i < scaled.get_line_count(); ++i) {
+		REQUIRE(fabsf(scaled.get_line_width(i) - base.get_line_width(i) * fontScale) < 0.05f);
+		REQUIRE(fabsf(scaled.get_line_ascent(i) - base.get_line_ascent(i) * fontScale) < 0.05f);
+		REQUIRE(fabsf(scaled.get_line_total_descent(i) - base.get_line_total_descent(i) * fontScale) < 0.05f);
+	}
 }
-
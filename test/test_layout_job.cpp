@@ -0,0 +1,53 @@
+#include "test_common.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <font_registry.hpp>
+#include <layout_info.hpp>
+#include <layout_job.hpp>
+
+#include <string>
+
+TEST_CASE("Resumable layout job", "[LayoutJob]") {
+	init_font_registry();
+	auto family = Text::FontRegistry::get_family("Noto Sans");
+	Text::Font font(family, Text::FontWeight::REGULAR, Text::FontStyle::NORMAL, 48);
+	std::string text = "First paragraph wraps onto a few lines\n\nThird paragraph\r\nbeffiإلابسم اللهffter\n";
+	auto count = static_cast<int32_t>(text.size());
+	Text::ValueRuns<Text::Font> fontRuns(font, count);
+
+	Text::LayoutInfo expected{};
+	Text::build_layout_info_utf8(expected, text.data(), count, fontRuns, 300.f, 100.f, TextYAlignment::CENTER,
+			Text::LayoutInfoFlags::NONE);
+
+	SECTION("One paragraph per call") {
+		Text::LayoutInfo layout{};
+		Text::LayoutJob job(layout, text.data(), count, fontRuns, 300.f, 100.f, TextYAlignment::CENTER,
+				Text::LayoutInfoFlags::NONE);
+		size_t callCount = 0;
+		size_t lastLineCount = 0;
+
+		while (job.resume({.codeUnits = 1}) == Text::LayoutJobStatus::PARTIAL) {
+			++callCount;
+			REQUIRE(layout.get_line_count() > lastLineCount);
+			REQUIRE(job.get_progress() < count);
+			lastLineCount = layout.get_line_count();
+		}
+
+		REQUIRE(callCount == 3);
+		REQUIRE(job.is_complete());
+		REQUIRE(job.get_progress() == count);
+		REQUIRE(job.resume({}) == Text::LayoutJobStatus::COMPLETE);
+		test_compare_layouts(layout, expected);
+		REQUIRE(layout.get_text_start_y() == expected.get_text_start_y());
+	}
+
+	SECTION("Unlimited budget") {
+		Text::LayoutInfo layout{};
+		Text::LayoutJob job(layout, text.data(), count, fontRuns, 300.f, 100.f, TextYAlignment::CENTER,
+				Text::LayoutInfoFlags::NONE);
+
+		REQUIRE(job.resume({}) == Text::LayoutJobStatus::COMPLETE);
+		test_compare_layouts(layout, expected);
+	}
+}
@@ -0,0 +1,76 @@
+#include "test_common.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <font_registry.hpp>
+#include <layout_info.hpp>
+#include <layout_service.hpp>
+
+#include <string>
+
+TEST_CASE("Layout service", "[LayoutService]") {
+	init_font_registry();
+	auto family = Text::FontRegistry::get_family("Noto Sans");
+	Text::Font font(family, Text::FontWeight::REGULAR, Text::FontStyle::NORMAL, 48);
+	std::string text = "Hello World, this text wraps across several lines";
+
+	auto makeRequest = [&](float width) {
+		return Text::LayoutRequest{
+			.text = text,
+			.fontRuns = Text::ValueRuns<Text::Font>(font, static_cast<int32_t>(text.size())),
+			.textAreaWidth = width,
+			.textAreaHeight = 100.f,
+			.textYAlignment = TextYAlignment::TOP,
+			.flags = Text::LayoutInfoFlags::NONE,
+		};
+	};
+
+	Text::LayoutInfo expected{};
+	Text::build_layout_info_utf8(expected, text.data(), static_cast<int32_t>(text.size()),
+			Text::ValueRuns<Text::Font>(font, static_cast<int32_t>(text.size())), 200.f, 100.f,
+			TextYAlignment::TOP, Text::LayoutInfoFlags::NONE);
+
+	SECTION("Synchronous") {
+		Text::LayoutService service(Text::LayoutServiceMode::SYNCHRONOUS);
+		auto generation = service.submit(1, makeRequest(200.f));
+
+		REQUIRE(!service.get_result(1));
+		REQUIRE(service.swap_buffers());
+
+		auto* result = service.get_result(1);
+		REQUIRE(result);
+		REQUIRE(result->generation == generation);
+		test_compare_layouts(result->layout, expected);
+	}
+
+	SECTION("Superseded requests are coalesced") {
+		Text::LayoutService service;
+		service.submit(1, makeRequest(50.f));
+		service.submit(1, makeRequest(100.f));
+		auto generation = service.submit(1, makeRequest(200.f));
+		auto otherGeneration = service.submit(2, makeRequest(200.f));
+		service.wait_idle();
+		service.swap_buffers();
+
+		auto* result = service.get_result(1);
+		REQUIRE(result);
+		REQUIRE(result->generation == generation);
+		test_compare_layouts(result->layout, expected);
+
+		REQUIRE(service.get_result(2));
+		REQUIRE(service.get_result(2)->generation == otherGeneration);
+
+		service.remove_result(1);
+		REQUIRE(!service.get_result(1));
+	}
+
+	SECTION("Cancelled requests are not published") {
+		Text::LayoutService service;
+		service.submit(1, makeRequest(200.f));
+		service.cancel(1);
+		service.wait_idle();
+		service.swap_buffers();
+
+		REQUIRE(!service.get_result(1));
+	}
+}
@@ -5,7 +5,11 @@
 #include <usc_impl.h>
 #include <unicode/ustring.h>
 
+#include <unicode/utf8.h>
+#include <unicode/utf16.h>
+
 #include <array>
+#include <random>
 
 namespace {
 
@@ -35,6 +39,8 @@ static constexpr const RunTestData g_scriptRunTestData2[] = {
 
 static void test_script_runs_icu(const RunTestData* pTestData, size_t testCount);
 static void test_script_runs_utf8(const RunTestData* pTestData, size_t testCount);
+static void test_script_runs_utf16(const RunTestData* pTestData, size_t testCount);
+static void test_script_table(UChar32 c);
 
 TEST_CASE("ICU Script Runs", "[ScriptRuns]") {
 	test_script_runs_icu(g_scriptRunTestData1, std::ssize(g_scriptRunTestData1));
@@ -46,6 +52,82 @@ TEST_CASE("UTF-8 Script Runs", "[ScriptRuns]") {
 	test_script_runs_utf8(g_scriptRunTestData2, std::ssize(g_scriptRunTestData2));
 }
 
+TEST_CASE("UTF-16 Script Runs", "[ScriptRuns]") {
+	test_script_runs_utf16(g_scriptRunTestData1, std::ssize(g_scriptRunTestData1));
+	test_script_runs_utf16(g_scriptRunTestData2, std::ssize(g_scriptRunTestData2));
+}
+
+TEST_CASE("Script table matches ICU", "[ScriptRuns]") {
+	// Fixed seed so failures reproduce
+	std::mt19937 rng(0x5C127);
+
+	for (UChar32 plane = 0; plane <= 0x10; ++plane) {
+		std::uniform_int_distribution<UChar32> dist(plane << 16, (plane << 16) | 0xFFFF);
+
+		for (int i = 0; i < 4096; ++i) {
+			test_script_table(dist(rng));
+		}
+
+		// Plane ends are noncharacters, unassigned in every plane
+		test_script_table((plane << 16) | 0xFFFE);
+		test_script_table((plane << 16) | 0xFFFF);
+	}
+
+	for (UChar32 c = 0xD800; c <= 0xDFFF; ++c) {
+		test_script_table(c);
+	}
+
+	for (UChar32 c = 0; c < 0x800; ++c) {
+		test_script_table(c);
+	}
+}
+
+// Scans a single code point. The iterator only tells a run's script apart from Common and Inherited, which take
+// on the script of the run around them, so both are reported as Common.
+static void test_script_table(UChar32 c) {
+	INFO("U+" << std::hex << c);
+
+	UErrorCode err{U_ZERO_ERROR};
+	auto expectedCode = uscript_getScript(c, &err);
+
+	if (U_FAILURE(err)) {
+		expectedCode = USCRIPT_UNKNOWN;
+	}
+
+	if (expectedCode <= USCRIPT_INHERITED) {
+		expectedCode = USCRIPT_COMMON;
+	}
+
+	int32_t runStart, runLimit;
+	UScriptCode runCode;
+
+	char16_t text16[U16_MAX_LENGTH];
+	int32_t length16{};
+	// Writes surrogates as unpaired code units, which are looked up as code points
+	U16_APPEND_UNSAFE(text16, length16, c);
+
+	ScriptRunIterator runIter16(text16, length16);
+	REQUIRE(runIter16.next(runStart, runLimit, runCode));
+	REQUIRE(runStart == 0);
+	REQUIRE(runLimit == length16);
+	REQUIRE(runCode == expectedCode);
+
+	// Surrogates are ill-formed in UTF-8
+	if (U_IS_SURROGATE(c)) {
+		return;
+	}
+
+	uint8_t text8[U8_MAX_LENGTH];
+	int32_t length8{};
+	U8_APPEND_UNSAFE(text8, length8, c);
+
+	ScriptRunIterator runIter8(reinterpret_cast<const char*>(text8), length8);
+	REQUIRE(runIter8.next(runStart, runLimit, runCode));
+	REQUIRE(runStart == 0);
+	REQUIRE(runLimit == length8);
+	REQUIRE(runCode == expectedCode);
+}
+
 static void test_script_runs_icu(const RunTestData* pTestData, size_t testCount) {
 	UChar testString[1024];
 	int32_t runStarts[256];
@@ -112,3 +194,31 @@ static void test_script_runs_utf8(const RunTestData* pTestData, size_t testCount
 	}
 }
 
+static void test_script_runs_utf16(const RunTestData* pTestData, size_t testCount) {
+	char16_t testString[1024];
+	int32_t runStarts[256];
+
+	// Fill in the test string and the runStarts array.
+	int32_t stringLimit = 0;
+	for (size_t run = 0; run < testCount; ++run) {
+		runStarts[run] = stringLimit;
+		stringLimit += u_unescape(pTestData[run].runText, testString + stringLimit, 1024 - stringLimit);
+	}
+
+	// The limit of the last run
+	runStarts[testCount] = stringLimit;
+
+	ScriptRunIterator runIter(testString, stringLimit);
+	int32_t runStart, runLimit;
+	UScriptCode runCode;
+	size_t runIndex{};
+
+	while (runIter.next(runStart, runLimit, runCode)) {
+		REQUIRE(runStart == runStarts[runIndex]);
+		REQUIRE(runLimit == runStarts[runIndex + 1]);
+		REQUIRE(runCode == pTestData[runIndex].runCode);
+		REQUIRE(runIndex < testCount);
+
+		++runIndex;
+	}
+}
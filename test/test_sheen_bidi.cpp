@@ -1,6 +1,7 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/benchmark/catch_benchmark.hpp>
 
+#include "bidi_prescan.hpp"
 #include "bidi_test.hpp"
 
 #include <unicode/ustring.h>
@@ -39,6 +40,8 @@ static size_t g_testStringLength{};
 static size_t g_baseViewCount{};
 
 static void compare_icu_sheen(std::string_view str);
+template <typename CharT>
+static void compare_prescan_sheen(std::basic_string_view<CharT> str);
 static void print_levels(const char* name, const uint8_t* levels, size_t count);
 static void print_visual_runs_icu(UBiDi* pBiDi, int32_t runCount);
 static void print_visual_runs_sheen(const SBRun* runs, size_t runCount);
@@ -90,8 +93,82 @@ TEST_CASE("ComparisonTest", "[SheenBidi]") {
 	}
 }
 
+TEST_CASE("PrescanTest", "[SheenBidi]") {
+	init_test_string();
+
+	for (size_t i = 0; i < g_baseViewCount; ++i) {
+		compare_prescan_sheen(g_testViews[i]);
+	}
+
+	for (auto view : g_testViews16) {
+		compare_prescan_sheen(view);
+	}
+
+	REQUIRE(Text::is_trivially_ltr("Hello, world 123", 16));
+	REQUIRE(Text::is_trivially_ltr("\xE4\xB8\xAD\xE6\x96\x87 \xE0\xA4\xB9\xE0\xA4\xBF", 13));
+	REQUIRE(!Text::is_trivially_ltr("abc \xD7\x90", 6)); // Hebrew alef
+	REQUIRE(!Text::is_trivially_ltr("abc \xD9\xA1", 6)); // Arabic-indic digit one
+	REQUIRE(!Text::is_trivially_ltr("abc \xE2\x81\xA7", 7)); // RLI
+	REQUIRE(!Text::is_trivially_ltr("abc \xE2", 5)); // Truncated sequence
+
+	compare_prescan_sheen<char>("a\r\nb\rc\n\nd\xE2\x80\xA9" "e\xC2\x85" "f\x1C");
+	compare_prescan_sheen<char>("abc\n\xD7\x90\nxyz");
+
+	REQUIRE(Text::is_trivially_ltr(u"Hello, world 123", 16));
+	REQUIRE(Text::is_trivially_ltr(u"\u4E2D\u6587 \u0939\u093F", 5));
+	REQUIRE(!Text::is_trivially_ltr(u"abcdefghijklmnop\u05D0", 17)); // Hebrew alef after a full vector
+	REQUIRE(!Text::is_trivially_ltr(u"abc \u0661", 5)); // Arabic-indic digit one
+	REQUIRE(!Text::is_trivially_ltr(u"abc \u2067", 5)); // RLI
+	REQUIRE(!Text::is_trivially_ltr(u"abc \xD83D", 5)); // Unpaired surrogate
+
+	compare_prescan_sheen<char16_t>(u"a\r\nb\rc\n\nd\u2029e\u0085f\u001C");
+	compare_prescan_sheen<char16_t>(u"abc\n\u05D0\nxyz");
+}
+
 // Static Functions
 
+template <typename CharT>
+static void compare_prescan_sheen(std::basic_string_view<CharT> str) {
+	if (str.empty()) {
+		return;
+	}
+
+	auto encoding = sizeof(CharT) == 1 ? SBStringEncodingUTF8 : SBStringEncodingUTF16;
+	SBCodepointSequence codepointSequence{encoding, (void*)str.data(), str.size()};
+	SBAlgorithmRef bidiAlgorithm = SBAlgorithmCreate(&codepointSequence);
+	auto count = static_cast<int32_t>(str.size());
+	SBUInteger paragraphOffset{};
+
+	while (paragraphOffset < str.size()) {
+		SBUInteger sheenLength, sheenSeparatorLength;
+		SBAlgorithmGetParagraphBoundary(bidiAlgorithm, paragraphOffset, INT32_MAX, &sheenLength,
+				&sheenSeparatorLength);
+
+		size_t length, separatorLength;
+		Text::find_paragraph_boundary(str.data(), count, paragraphOffset, length, separatorLength);
+
+		REQUIRE(length == sheenLength);
+		REQUIRE(separatorLength == sheenSeparatorLength);
+
+		// Layout prescans each paragraph on its own, so RTL text in one paragraph can't affect the others
+		if (Text::is_trivially_ltr(str.data() + paragraphOffset, static_cast<int32_t>(length))) {
+			SBParagraphRef paragraph = SBAlgorithmCreateParagraph(bidiAlgorithm, paragraphOffset, sheenLength,
+					SBLevelDefaultLTR);
+			auto* levels = SBParagraphGetLevelsPtr(paragraph);
+
+			for (SBUInteger i = 0; i < sheenLength; ++i) {
+				REQUIRE(levels[i] == 0);
+			}
+
+			SBParagraphRelease(paragraph);
+		}
+
+		paragraphOffset += sheenLength;
+	}
+
+	SBAlgorithmRelease(bidiAlgorithm);
+}
+
 static void compare_icu_sheen(std::string_view str) {
 	if (str.empty()) {
 		return;
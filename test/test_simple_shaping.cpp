@@ -0,0 +1,56 @@
+#include "test_common.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <font_registry.hpp>
+#include <layout_info.hpp>
+#include <shaped_text.hpp>
+#include <simple_shaping.hpp>
+
+#include <cstring>
+
+TEST_CASE("Simple shaping matches HarfBuzz", "[SimpleShaping]") {
+	init_font_registry();
+
+	const char* familyNames[] = {"Noto Sans", "Noto Sans CJK"};
+	const char* strings[] = {
+		"0123456789 +-*/=",
+		"Hello, World! Kerning AV To Wa",
+		"Привет мир, Γειά σου",
+		"日本語のテキスト、カタカナ。",
+		"e\xcc\x81 combining and a\xe2\x80\x8d" "joiner",
+		"12 إلابسم 34 hello",
+	};
+
+	for (auto* familyName : familyNames) {
+		auto family = Text::FontRegistry::get_family(familyName);
+		Text::Font font(family, Text::FontWeight::REGULAR, Text::FontStyle::NORMAL, 48);
+
+		for (auto* str : strings) {
+			auto count = static_cast<int32_t>(strlen(str));
+			Text::ValueRuns<Text::Font> fontRuns(font, count);
+
+			Text::set_simple_shaping_enabled(false);
+			Text::LayoutInfo expected{};
+			Text::build_layout_info_utf8(expected, str, count, fontRuns, 200.f, 100.f, TextYAlignment::BOTTOM,
+					Text::LayoutInfoFlags::NONE);
+			Text::ShapedText expectedShaped{};
+			Text::shape_text_utf8(expectedShaped, str, count, fontRuns, Text::LayoutInfoFlags::NONE);
+			Text::LayoutInfo expectedReflow{};
+			Text::build_layout_info_shaped(expectedReflow, expectedShaped, str, count, 1.f, 200.f, 100.f,
+					TextYAlignment::BOTTOM);
+
+			Text::set_simple_shaping_enabled(true);
+			Text::LayoutInfo layout{};
+			Text::build_layout_info_utf8(layout, str, count, fontRuns, 200.f, 100.f, TextYAlignment::BOTTOM,
+					Text::LayoutInfoFlags::NONE);
+			Text::ShapedText shaped{};
+			Text::shape_text_utf8(shaped, str, count, fontRuns, Text::LayoutInfoFlags::NONE);
+			Text::LayoutInfo reflow{};
+			Text::build_layout_info_shaped(reflow, shaped, str, count, 1.f, 200.f, 100.f, TextYAlignment::BOTTOM);
+
+			test_compare_layouts(layout, expected);
+			test_compare_layouts(reflow, expectedReflow);
+		}
+	}
+}
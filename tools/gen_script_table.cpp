@@ -0,0 +1,145 @@
+/**
+ * Generates the two-level script property table used by `ScriptRunIterator`. Each entry packs the code point's
+ * `UScriptCode` with its index into the paired punctuation list, so itemization needs a single table load per
+ * code point instead of an ICU property lookup and a binary search.
+ *
+ * Usage: GenScriptTable <output.inc>
+ */
+#include <unicode/uchar.h>
+#include <unicode/uscript.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static constexpr const UChar32 CODE_POINT_LIMIT = 0x110000;
+static constexpr const uint32_t LATIN1_LIMIT = 0x100;
+
+static constexpr const uint32_t BLOCK_SHIFT = 7;
+static constexpr const uint32_t BLOCK_SIZE = 1u << BLOCK_SHIFT;
+
+static constexpr const uint32_t PAIR_SHIFT = 10;
+static constexpr const uint32_t SCRIPT_MASK = (1u << PAIR_SHIFT) - 1;
+
+// Open and close characters alternate, so an even index is an opening character and `index & ~1` identifies
+// the pair
+static constexpr const UChar32 PAIRED_CHARS[] = {
+	0x0028, 0x0029, /* ascii paired punctuation */
+	0x003c, 0x003e,
+	0x005b, 0x005d,
+	0x007b, 0x007d,
+	0x00ab, 0x00bb, /* guillemets */
+	0x2018, 0x2019, /* general punctuation */
+	0x201c, 0x201d,
+	0x2039, 0x203a,
+	0x3008, 0x3009, /* chinese paired punctuation */
+	0x300a, 0x300b,
+	0x300c, 0x300d,
+	0x300e, 0x300f,
+	0x3010, 0x3011,
+	0x3014, 0x3015,
+	0x3016, 0x3017,
+	0x3018, 0x3019,
+	0x301a, 0x301b
+};
+
+static_assert(USCRIPT_CODE_LIMIT <= SCRIPT_MASK + 1, "Script codes no longer fit the table entry");
+static_assert(std::size(PAIRED_CHARS) < (1u << (16 - PAIR_SHIFT)), "Pair indices no longer fit the table entry");
+
+static uint16_t get_entry(UChar32 c);
+static void write_array(FILE* file, const char* type, const char* name, const uint16_t* values, size_t count);
+
+int main(int argc, char** argv) {
+	if (argc != 2) {
+		std::fprintf(stderr, "Usage: %s <output.inc>\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<uint16_t> latin1;
+
+	for (UChar32 c = 0; c < static_cast<UChar32>(LATIN1_LIMIT); ++c) {
+		latin1.push_back(get_entry(c));
+	}
+
+	// Deduplicate blocks, most of the code space is unassigned or shares a script
+	std::vector<uint16_t> stage1;
+	std::vector<uint16_t> stage2;
+	std::unordered_map<std::string, uint16_t> blockIndices;
+
+	for (UChar32 blockStart = 0; blockStart < CODE_POINT_LIMIT; blockStart += BLOCK_SIZE) {
+		uint16_t block[BLOCK_SIZE];
+
+		for (uint32_t i = 0; i < BLOCK_SIZE; ++i) {
+			block[i] = get_entry(blockStart + static_cast<UChar32>(i));
+		}
+
+		std::string key(reinterpret_cast<const char*>(block), sizeof(block));
+		auto [it, inserted] = blockIndices.emplace(std::move(key), static_cast<uint16_t>(blockIndices.size()));
+
+		if (inserted) {
+			stage2.insert(stage2.end(), block, block + BLOCK_SIZE);
+		}
+
+		stage1.push_back(it->second);
+	}
+
+	FILE* file = std::fopen(argv[1], "wb");
+
+	if (!file) {
+		std::fprintf(stderr, "Failed to open %s\n", argv[1]);
+		return 1;
+	}
+
+	std::fprintf(file, "// Generated by tools/gen_script_table.cpp from ICU %s. Do not edit.\n\n", U_ICU_VERSION);
+	std::fprintf(file, "static constexpr const uint32_t SCRIPT_TABLE_LATIN1_LIMIT = 0x%X;\n", LATIN1_LIMIT);
+	std::fprintf(file, "static constexpr const uint32_t SCRIPT_TABLE_BLOCK_SHIFT = %u;\n", BLOCK_SHIFT);
+	std::fprintf(file, "static constexpr const uint32_t SCRIPT_TABLE_PAIR_SHIFT = %u;\n", PAIR_SHIFT);
+	std::fprintf(file, "static constexpr const uint32_t SCRIPT_TABLE_SCRIPT_MASK = 0x%X;\n\n", SCRIPT_MASK);
+	write_array(file, "uint16_t", "SCRIPT_TABLE_LATIN1", latin1.data(), latin1.size());
+	// Narrow the first stage when possible to keep it resident in L1
+	write_array(file, blockIndices.size() <= 256 ? "uint8_t" : "uint16_t", "SCRIPT_TABLE_STAGE1", stage1.data(),
+			stage1.size());
+	write_array(file, "uint16_t", "SCRIPT_TABLE_STAGE2", stage2.data(), stage2.size());
+
+	if (std::fclose(file) != 0) {
+		std::fprintf(stderr, "Failed to write %s\n", argv[1]);
+		return 1;
+	}
+
+	return 0;
+}
+
+// Static Functions
+
+static uint16_t get_entry(UChar32 c) {
+	UErrorCode err{U_ZERO_ERROR};
+	auto script = uscript_getScript(c, &err);
+
+	if (U_FAILURE(err)) {
+		script = USCRIPT_UNKNOWN;
+	}
+
+	uint32_t pairIndex = 0;
+
+	for (uint32_t i = 0; i < std::size(PAIRED_CHARS); ++i) {
+		if (PAIRED_CHARS[i] == c) {
+			pairIndex = i + 1;
+			break;
+		}
+	}
+
+	return static_cast<uint16_t>((pairIndex << PAIR_SHIFT) | static_cast<uint32_t>(script));
+}
+
+static void write_array(FILE* file, const char* type, const char* name, const uint16_t* values, size_t count) {
+	std::fprintf(file, "static constexpr const %s %s[%zu] = {", type, name, count);
+
+	for (size_t i = 0; i < count; ++i) {
+		std::fprintf(file, i % 16 == 0 ? "\n\t0x%04X," : " 0x%04X,", values[i]);
+	}
+
+	std::fprintf(file, "\n};\n\n");
+}
@@ -0,0 +1,58 @@
+/**
+ * Packs every font file referenced by a directory of family JSON files into a single font pack, see `FontPack`.
+ * Face URIs are read relative to the working directory and stored as written in the JSON files, so the family
+ * files can be registered unchanged once the pack is opened.
+ *
+ * Usage: PackFonts <families dir> <output.pack>
+ */
+#include <font_pack.hpp>
+
+#include <simdjson.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+	if (argc != 3) {
+		std::fprintf(stderr, "Usage: %s <families dir> <output.pack>\n", argv[0]);
+		return 1;
+	}
+
+	simdjson::dom::parser parser;
+	std::vector<std::string> uris;
+
+	for (auto& entry : std::filesystem::directory_iterator{argv[1]}) {
+		if (entry.path().extension().compare(".json") != 0) {
+			continue;
+		}
+
+		simdjson::dom::array faces;
+
+		if (parser.load(entry.path().string())["faces"].get(faces) != 0) {
+			std::fprintf(stderr, "Failed to parse %s\n", entry.path().string().c_str());
+			return 1;
+		}
+
+		for (auto face : faces) {
+			std::string_view uri;
+
+			if (face["uri"].get(uri) != 0) {
+				std::fprintf(stderr, "Face without a URI in %s\n", entry.path().string().c_str());
+				return 1;
+			}
+
+			uris.emplace_back(uri);
+		}
+	}
+
+	std::vector<std::string_view> uriViews(uris.begin(), uris.end());
+
+	if (!Text::FontPack::write(argv[2], uriViews.data(), uriViews.size())) {
+		std::fprintf(stderr, "Failed to write %s\n", argv[2]);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,427 @@
+/**
+ * Subsets the fonts referenced by a directory of family JSON files to the codepoints used by a text corpus, for
+ * shipping builds that only display known strings. HarfBuzz computes the glyph closure, so glyphs reachable
+ * through GSUB substitutions of the corpus codepoints are kept, and all layout features are retained.
+ *
+ * Face files are read from their URI relative to the working directory and written to the same URI under the
+ * output directory. A subset holds a single font, so faces past index 0 of a collection file are written next to it
+ * as `<name>-<index>.ttf` or `.otf` instead. Family JSON files are rewritten to `<output>/families`, pointing faces
+ * at their subsets and dropping faces whose subset covers none of the corpus, so the output directory can stand in
+ * for the working directory at runtime.
+ *
+ * Usage: SubsetFonts <families dir> <output dir> <corpus file>...
+ */
+#include <file_read_bytes.hpp>
+
+#include <hb.h>
+#include <hb-subset.h>
+
+#include <simdjson.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct SubsetResult {
+	bool success;
+	// Whether the subset maps any of the corpus codepoints
+	bool coversCorpus;
+	// Where the subset was written, relative to the output directory
+	std::string outputURI;
+};
+
+// URI and index of a face within its file
+using FaceKey = std::pair<std::string, uint32_t>;
+
+}
+
+static constexpr const uint32_t INVALID_CODEPOINT = ~0u;
+
+static void add_corpus_codepoints(hb_set_t* codepoints, const std::vector<char>& text);
+static uint32_t decode_utf8(const uint8_t* chars, size_t& index, size_t count);
+static bool get_face_key(simdjson::dom::element face, FaceKey& keyOut);
+static std::string get_output_uri(const FaceKey& key);
+static SubsetResult subset_face_file(const FaceKey& key, const std::filesystem::path& outputPath,
+		const hb_set_t* codepoints);
+static bool write_family(const std::filesystem::path& outputPath, simdjson::dom::object family,
+		const std::map<FaceKey, SubsetResult>& results);
+static std::string write_face(simdjson::dom::object face, const std::string& outputURI);
+static std::string write_json_string(std::string_view value);
+static bool write_file(const std::filesystem::path& path, std::string_view data);
+
+int main(int argc, char** argv) {
+	if (argc < 4) {
+		std::fprintf(stderr, "Usage: %s <families dir> <output dir> <corpus file>...\n", argv[0]);
+		return 1;
+	}
+
+	std::filesystem::path familiesPath(argv[1]);
+	std::filesystem::path outputPath(argv[2]);
+
+	auto* codepoints = hb_set_create();
+
+	for (int i = 3; i < argc; ++i) {
+		auto text = file_read_bytes(argv[i]);
+
+		if (text.empty()) {
+			std::fprintf(stderr, "Failed to read corpus %s\n", argv[i]);
+			hb_set_destroy(codepoints);
+			return 1;
+		}
+
+		add_corpus_codepoints(codepoints, text);
+	}
+
+	std::printf("Corpus uses %u codepoints\n", hb_set_get_population(codepoints));
+
+	simdjson::dom::parser parser;
+	// Faces may share a file, subset each face of a file once
+	std::map<FaceKey, SubsetResult> results;
+	bool success = true;
+
+	for (auto& entry : std::filesystem::directory_iterator{familiesPath}) {
+		if (entry.path().extension().compare(".json") != 0) {
+			continue;
+		}
+
+		simdjson::dom::object family;
+
+		if (parser.load(entry.path().string()).get(family) != 0) {
+			std::fprintf(stderr, "Failed to parse %s\n", entry.path().string().c_str());
+			success = false;
+			continue;
+		}
+
+		simdjson::dom::array faces;
+
+		if (family["faces"].get(faces) != 0) {
+			std::fprintf(stderr, "%s has no faces\n", entry.path().string().c_str());
+			success = false;
+			continue;
+		}
+
+		for (auto face : faces) {
+			FaceKey key;
+
+			if (!get_face_key(face, key)) {
+				std::fprintf(stderr, "%s has a face without a valid uri or index\n", entry.path().string().c_str());
+				success = false;
+				continue;
+			}
+
+			if (!results.contains(key)) {
+				auto result = subset_face_file(key, outputPath, codepoints);
+				success = success && result.success;
+				results.emplace(std::move(key), std::move(result));
+			}
+		}
+
+		success = write_family(outputPath / "families" / entry.path().filename(), family, results) && success;
+	}
+
+	hb_set_destroy(codepoints);
+
+	return success ? 0 : 1;
+}
+
+// Static Functions
+
+static void add_corpus_codepoints(hb_set_t* codepoints, const std::vector<char>& text) {
+	auto* chars = reinterpret_cast<const uint8_t*>(text.data());
+
+	for (size_t i = 0; i < text.size();) {
+		if (auto c = decode_utf8(chars, i, text.size()); c != INVALID_CODEPOINT) {
+			hb_set_add(codepoints, c);
+		}
+	}
+}
+
+// Decodes the code point at `index` and advances past it. Ill-formed sequences, overlong forms and surrogates
+// decode to `INVALID_CODEPOINT`, leaving a byte that cannot continue the sequence for the next call.
+static uint32_t decode_utf8(const uint8_t* chars, size_t& index, size_t count) {
+	uint32_t c = chars[index++];
+
+	if (c < 0x80) {
+		return c;
+	}
+
+	size_t trailCount;
+	uint32_t minValue;
+
+	if (c >= 0xC2 && c <= 0xDF) {
+		trailCount = 1;
+		minValue = 0x80;
+		c &= 0x1F;
+	}
+	else if (c >= 0xE0 && c <= 0xEF) {
+		trailCount = 2;
+		minValue = 0x800;
+		c &= 0x0F;
+	}
+	else if (c >= 0xF0 && c <= 0xF4) {
+		trailCount = 3;
+		minValue = 0x10000;
+		c &= 0x07;
+	}
+	else {
+		return INVALID_CODEPOINT;
+	}
+
+	for (size_t i = 0; i < trailCount; ++i) {
+		if (index == count || (chars[index] & 0xC0) != 0x80) {
+			return INVALID_CODEPOINT;
+		}
+
+		c = (c << 6) | (chars[index++] & 0x3F);
+	}
+
+	if (c < minValue || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) {
+		return INVALID_CODEPOINT;
+	}
+
+	return c;
+}
+
+static bool get_face_key(simdjson::dom::element face, FaceKey& keyOut) {
+	std::string_view uri;
+	int64_t faceIndex{};
+
+	if (face["uri"].get(uri) != 0) {
+		return false;
+	}
+
+	if (auto err = face["index"].get(faceIndex); (err != 0 && err != simdjson::NO_SUCH_FIELD) || faceIndex < 0
+			|| faceIndex > UINT32_MAX) {
+		return false;
+	}
+
+	keyOut = {std::string(uri), static_cast<uint32_t>(faceIndex)};
+	return true;
+}
+
+static std::string get_output_uri(const FaceKey& key) {
+	auto& [uri, faceIndex] = key;
+
+	if (faceIndex == 0) {
+		return uri;
+	}
+
+	std::filesystem::path path(uri);
+	auto extension = path.extension().string();
+
+	if (extension == ".ttc") {
+		extension = ".ttf";
+	}
+	else if (extension == ".otc") {
+		extension = ".otf";
+	}
+
+	return (path.parent_path() / (path.stem().string() + "-" + std::to_string(faceIndex) + extension))
+			.generic_string();
+}
+
+static SubsetResult subset_face_file(const FaceKey& key, const std::filesystem::path& outputPath,
+		const hb_set_t* codepoints) {
+	auto& [uri, faceIndex] = key;
+	auto* blob = hb_blob_create_from_file_or_fail(uri.c_str());
+
+	if (!blob) {
+		std::fprintf(stderr, "Failed to read %s\n", uri.c_str());
+		return {false, false, {}};
+	}
+
+	if (faceIndex >= hb_face_count(blob)) {
+		std::fprintf(stderr, "%s has no face at index %u\n", uri.c_str(), faceIndex);
+		hb_blob_destroy(blob);
+		return {false, false, {}};
+	}
+
+	auto* face = hb_face_create(blob, faceIndex);
+	auto* input = hb_subset_input_create_or_fail();
+
+	hb_set_union(hb_subset_input_unicode_set(input), codepoints);
+
+	// Keep every layout feature rather than HarfBuzz's default list, text may rely on any of them
+	auto* features = hb_subset_input_set(input, HB_SUBSET_SETS_LAYOUT_FEATURE_TAG);
+	hb_set_clear(features);
+	hb_set_invert(features);
+
+	auto* subsetFace = hb_subset_or_fail(face, input);
+	SubsetResult result{false, false, get_output_uri(key)};
+
+	if (subsetFace) {
+		auto* unicodes = hb_set_create();
+		hb_face_collect_unicodes(subsetFace, unicodes);
+		result.coversCorpus = !hb_set_is_empty(unicodes);
+		hb_set_destroy(unicodes);
+
+		auto* subsetBlob = hb_face_reference_blob(subsetFace);
+		unsigned subsetSize;
+		auto* subsetData = hb_blob_get_data(subsetBlob, &subsetSize);
+
+		result.success = write_file(outputPath / result.outputURI, std::string_view(subsetData, subsetSize));
+
+		if (result.success) {
+			std::printf("%s#%u: %u -> %u bytes\n", uri.c_str(), faceIndex, hb_blob_get_length(blob), subsetSize);
+		}
+
+		hb_blob_destroy(subsetBlob);
+		hb_face_destroy(subsetFace);
+	}
+	else {
+		std::fprintf(stderr, "Failed to subset %s\n", uri.c_str());
+	}
+
+	hb_subset_input_destroy(input);
+	hb_face_destroy(face);
+	hb_blob_destroy(blob);
+
+	return result;
+}
+
+static bool write_family(const std::filesystem::path& outputPath, simdjson::dom::object family,
+		const std::map<FaceKey, SubsetResult>& results) {
+	std::string output = "{";
+	bool firstField = true;
+
+	for (auto [key, value] : family) {
+		output += firstField ? "\n\t\"" : ",\n\t\"";
+		output += key;
+		output += "\": ";
+		firstField = false;
+
+		if (key != "faces") {
+			output += simdjson::to_string(value);
+			continue;
+		}
+
+		std::vector<std::pair<simdjson::dom::element, const SubsetResult*>> keptFaces;
+		std::pair<simdjson::dom::element, const SubsetResult*> firstFace{};
+
+		for (auto face : value.get_array()) {
+			FaceKey key;
+
+			if (!get_face_key(face, key)) {
+				continue;
+			}
+
+			if (auto it = results.find(key); it != results.end()) {
+				if (!firstFace.second) {
+					firstFace = {face, &it->second};
+				}
+
+				if (it->second.coversCorpus) {
+					keptFaces.emplace_back(face, &it->second);
+				}
+			}
+		}
+
+		// A family must keep a face to stay registrable, other families may still link to or fall back on it
+		if (keptFaces.empty() && firstFace.second) {
+			keptFaces.push_back(firstFace);
+		}
+
+		output += "[";
+
+		for (size_t i = 0; i < keptFaces.size(); ++i) {
+			output += i == 0 ? "\n\t\t" : ",\n\t\t";
+			output += write_face(keptFaces[i].first.get_object(), keptFaces[i].second->outputURI);
+		}
+
+		output += "\n\t]";
+	}
+
+	output += "\n}\n";
+
+	return write_file(outputPath, output);
+}
+
+// Subsets hold a single font, so faces are written without their collection index and with the subset's URI
+static std::string write_face(simdjson::dom::object face, const std::string& outputURI) {
+	std::string output = "{";
+
+	for (auto [key, value] : face) {
+		if (key == "index") {
+			continue;
+		}
+
+		output += output.size() == 1 ? "\"" : ",\"";
+		output += key;
+		output += "\":";
+		output += key == "uri" ? write_json_string(outputURI) : simdjson::to_string(value);
+	}
+
+	return output + "}";
+}
+
+// Quotes and escapes `value` the same way `simdjson::to_string` writes strings
+static std::string write_json_string(std::string_view value) {
+	static constexpr const char HEX_DIGITS[] = "0123456789abcdef";
+
+	std::string output = "\"";
+
+	for (auto c : value) {
+		switch (c) {
+			case '"':
+				output += "\\\"";
+				break;
+			case '\\':
+				output += "\\\\";
+				break;
+			case '\b':
+				output += "\\b";
+				break;
+			case '\f':
+				output += "\\f";
+				break;
+			case '\n':
+				output += "\\n";
+				break;
+			case '\r':
+				output += "\\r";
+				break;
+			case '\t':
+				output += "\\t";
+				break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					output += "\\u00";
+					output += HEX_DIGITS[c >> 4];
+					output += HEX_DIGITS[c & 0xF];
+				}
+				else {
+					output += c;
+				}
+		}
+	}
+
+	return output + "\"";
+}
+
+static bool write_file(const std::filesystem::path& path, std::string_view data) {
+	std::error_code err;
+	std::filesystem::create_directories(path.parent_path(), err);
+
+	FILE* file = std::fopen(path.string().c_str(), "wb");
+
+	if (!file) {
+		std::fprintf(stderr, "Failed to open %s\n", path.string().c_str());
+		return false;
+	}
+
+	bool success = data.empty() || std::fwrite(data.data(), 1, data.size(), file) == data.size();
+	success = (std::fclose(file) == 0) && success;
+
+	if (!success) {
+		std::fprintf(stderr, "Failed to write %s\n", path.string().c_str());
+	}
+
+	return success;
+}